@@ -0,0 +1,380 @@
+// 大规模站点基准测试：生成确定性的合成语料，分别测量完整构建、无变化的增量构建和修改一篇文章后的构建
+// 用法：blog-bench [--generator PATH] [--dir DIR] [--template PATH] 文章数...
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/stat.h>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <limits.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+#endif
+
+#define BENCH_DEFAULT_DIR "_bench"
+#define BENCH_TAG_COUNT 48
+#define BENCH_SEED 0x9E3779B97F4A7C15ULL
+
+#ifndef _WIN32
+
+typedef struct {
+    double seconds;
+    long peak_rss_kb;
+    int status;
+} BuildResult;
+
+// xorshift64*：同一文章数总是生成完全相同的语料
+static unsigned long long rng_state;
+
+static unsigned long long next_random(void) {
+    rng_state ^= rng_state >> 12;
+    rng_state ^= rng_state << 25;
+    rng_state ^= rng_state >> 27;
+    return rng_state * 0x2545F4914F6CDD1DULL;
+}
+
+static int random_range(int low, int high) {
+    return low + (int)(next_random() % (unsigned long long)(high - low + 1));
+}
+
+static const char* words[] = {
+    "static", "blog", "generator", "markdown", "parser", "template", "render", "cache",
+    "thread", "pool", "buffer", "latency", "throughput", "kernel", "memory", "arena",
+    "index", "catalog", "incremental", "build", "page", "archive", "feed", "sitemap",
+    "compress", "stream", "vector", "branch", "pipeline", "profile", "allocation", "syscall",
+    "文章", "性能", "缓存", "模板", "解析", "并行", "内存", "构建"
+};
+#define WORD_COUNT (sizeof(words) / sizeof(words[0]))
+
+static const char* languages[] = {"c", "python", "rust", "bash", "", "go"};
+
+static void write_words(FILE* fp, int count) {
+    for (int i = 0; i < count; i++) {
+        const char* word = words[next_random() % WORD_COUNT];
+        if (i > 0) fputc(' ', fp);
+
+        // 穿插行内格式：加粗、强调、代码和链接
+        switch (next_random() % 24) {
+            case 0: fprintf(fp, "**%s**", word); break;
+            case 1: fprintf(fp, "_%s_", word); break;
+            case 2: fprintf(fp, "`%s()`", word); break;
+            case 3: fprintf(fp, "[%s](https://example.com/%s)", word, word); break;
+            default: fputs(word, fp); break;
+        }
+    }
+}
+
+// 标题和描述只用普通单词，输出文件名由标题生成
+static void write_plain_words(FILE* fp, int count) {
+    for (int i = 0; i < count; i++) {
+        fprintf(fp, "%s%s", i ? " " : "", words[next_random() % WORD_COUNT]);
+    }
+}
+
+static void write_code_block(FILE* fp) {
+    fprintf(fp, "```%s\n", languages[next_random() % (sizeof(languages) / sizeof(languages[0]))]);
+    int lines = random_range(4, 30);
+    for (int i = 0; i < lines; i++) {
+        fprintf(fp, "%*sint %s_%d = compute(%d, \"%s\") < 0 && flag;\n", (i % 4) * 4, "",
+                words[next_random() % 32], i, random_range(0, 9999), words[next_random() % WORD_COUNT]);
+    }
+    fputs("```\n\n", fp);
+}
+
+static void write_list(FILE* fp) {
+    int ordered = next_random() % 3 == 0;
+    int items = random_range(3, 12);
+    for (int i = 0; i < items; i++) {
+        if (ordered) fprintf(fp, "%d. ", i + 1);
+        else fputs("- ", fp);
+        write_words(fp, random_range(4, 16));
+        fputc('\n', fp);
+    }
+    fputc('\n', fp);
+}
+
+// 文章大小近似对数正态：多数 2-10 KB，少数长文到 100 KB 以上
+static int post_target_size(void) {
+    int roll = random_range(0, 99);
+    if (roll < 60) return random_range(1500, 6000);
+    if (roll < 90) return random_range(6000, 20000);
+    if (roll < 99) return random_range(20000, 60000);
+    return random_range(60000, 160000);
+}
+
+static int write_post(const char* path, int index) {
+    FILE* fp = fopen(path, "w");
+    if (!fp) return 0;
+
+    int year = 2015 + index % 10;
+    int month = 1 + (index / 10) % 12;
+    int day = 1 + (index / 120) % 28;
+    fprintf(fp, "---\ntitle: Post %06d ", index);
+    write_plain_words(fp, random_range(2, 6));
+    fprintf(fp, "\ndate: %04d-%02d-%02d\nauthor: Bench\ndescription: ", year, month, day);
+    write_plain_words(fp, random_range(8, 20));
+    fputs("\ntags: [", fp);
+    int tag_count = random_range(1, 5);
+    for (int t = 0; t < tag_count; t++) {
+        fprintf(fp, "%stag%02d", t ? ", " : "", (int)(next_random() % BENCH_TAG_COUNT));
+    }
+    fputs("]\n---\n\n", fp);
+
+    long target = post_target_size();
+    while (ftell(fp) < target) {
+        int kind = random_range(0, 9);
+        if (kind == 0) {
+            fprintf(fp, "## ");
+            write_words(fp, random_range(2, 8));
+            fputs("\n\n", fp);
+        } else if (kind == 1) {
+            write_code_block(fp);
+        } else if (kind == 2) {
+            write_list(fp);
+        } else {
+            write_words(fp, random_range(30, 120));
+            fputs("\n\n", fp);
+        }
+    }
+
+    return fclose(fp) == 0;
+}
+
+static int make_dirs(const char* path) {
+    char tmp[PATH_MAX];
+    snprintf(tmp, sizeof(tmp), "%s", path);
+    for (char* p = tmp + 1; *p; p++) {
+        if (*p != '/') continue;
+        *p = '\0';
+        if (mkdir(tmp, 0755) != 0 && errno != EEXIST) return 0;
+        *p = '/';
+    }
+    return mkdir(tmp, 0755) == 0 || errno == EEXIST;
+}
+
+static int copy_file(const char* src, const char* dest) {
+    FILE* in = fopen(src, "rb");
+    if (!in) return 0;
+    FILE* out = fopen(dest, "wb");
+    if (!out) {
+        fclose(in);
+        return 0;
+    }
+
+    char buffer[65536];
+    size_t n;
+    while ((n = fread(buffer, 1, sizeof(buffer), in)) > 0) fwrite(buffer, 1, n, out);
+    fclose(in);
+    return fclose(out) == 0;
+}
+
+static void post_path(char* path, size_t size, const char* site, int index) {
+    snprintf(path, size, "%s/posts/%04d/%02d/post-%06d.md", site, 2015 + index % 10, 1 + (index / 10) % 12, index);
+}
+
+// 语料按文章数缓存在 DIR/site-N 中，已生成过的直接复用
+static long long generate_corpus(const char* site, int posts, const char* template_path) {
+    char path[PATH_MAX];
+    snprintf(path, sizeof(path), "%s/.corpus", site);
+
+    long long bytes = 0;
+    int cached = 0;
+    FILE* marker = fopen(path, "r");
+    if (marker) {
+        cached = fscanf(marker, "%*d %lld", &bytes) == 1;
+        fclose(marker);
+    }
+    if (cached) return bytes;
+
+    printf("Generating %d post(s) in %s...\n", posts, site);
+    fflush(stdout);
+    rng_state = BENCH_SEED ^ (unsigned long long)posts;
+
+    snprintf(path, sizeof(path), "%s/templates", site);
+    if (!make_dirs(path)) return -1;
+    snprintf(path, sizeof(path), "%s/templates/post.html", site);
+    if (!copy_file(template_path, path)) {
+        fprintf(stderr, "Could not copy %s\n", template_path);
+        return -1;
+    }
+
+    for (int i = 0; i < posts; i++) {
+        post_path(path, sizeof(path), site, i);
+        char* slash = strrchr(path, '/');
+        *slash = '\0';
+        if (!make_dirs(path)) return -1;
+        *slash = '/';
+        if (!write_post(path, i)) return -1;
+
+        struct stat st;
+        if (stat(path, &st) == 0) bytes += st.st_size;
+    }
+
+    snprintf(path, sizeof(path), "%s/.corpus", site);
+    marker = fopen(path, "w");
+    if (marker) {
+        fprintf(marker, "%d %lld\n", posts, bytes);
+        fclose(marker);
+    }
+    return bytes;
+}
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// 在站点目录中运行生成器，输出丢弃；峰值 RSS 取自 wait4 返回的子进程资源统计
+static BuildResult run_build(const char* generator, const char* site) {
+    BuildResult result = {0, 0, -1};
+    double start = now_seconds();
+
+    pid_t pid = fork();
+    if (pid < 0) return result;
+    if (pid == 0) {
+        int null_fd = open("/dev/null", O_WRONLY);
+        if (null_fd >= 0) {
+            dup2(null_fd, STDOUT_FILENO);
+            dup2(null_fd, STDERR_FILENO);
+        }
+        if (chdir(site) != 0) _exit(127);
+        execl(generator, generator, "--quiet", "_site", (char*)NULL);
+        _exit(127);
+    }
+
+    int status;
+    struct rusage usage;
+    if (wait4(pid, &status, 0, &usage) < 0) return result;
+
+    result.seconds = now_seconds() - start;
+    result.peak_rss_kb = usage.ru_maxrss;
+    result.status = WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+    return result;
+}
+
+static void remove_output(const char* site) {
+    char command[PATH_MAX + 32];
+    snprintf(command, sizeof(command), "rm -rf '%s/_site'", site);
+    if (system(command) != 0) fprintf(stderr, "Could not remove %s/_site\n", site);
+}
+
+// 截回原来的长度：语料缓存在多次运行之间复用，必须保持与生成时相同
+static void restore_post(const char* path, off_t length) {
+    if (truncate(path, length) != 0) fprintf(stderr, "Could not restore %s\n", path);
+}
+
+// 在一篇文章末尾追加一段，使内容真正变化：生成器要重新解析、渲染并写出这一页。返回原来的长度，失败时返回 -1
+static off_t change_post(const char* path) {
+    struct stat st;
+    if (stat(path, &st) != 0) return -1;
+
+    FILE* fp = fopen(path, "a");
+    if (!fp) return -1;
+    fputs("\nAn extra paragraph appended by the benchmark to change this post.\n", fp);
+    if (fclose(fp) != 0) {
+        restore_post(path, st.st_size);
+        return -1;
+    }
+    return st.st_size;
+}
+
+static void report(const char* name, int posts, long long bytes, BuildResult result) {
+    if (result.status != 0) {
+        printf("  %-14s FAILED (exit status %d)\n", name, result.status);
+        return;
+    }
+    printf("  %-14s %9.3f s %11.0f posts/s %9.1f MB/s %9.1f MB peak RSS\n", name, result.seconds,
+           posts / result.seconds, bytes / (1024.0 * 1024.0) / result.seconds, result.peak_rss_kb / 1024.0);
+}
+
+static int bench_site(const char* generator, const char* dir, const char* template_path, int posts) {
+    char site[1024];
+    snprintf(site, sizeof(site), "%s/site-%d", dir, posts);
+
+    long long bytes = generate_corpus(site, posts, template_path);
+    if (bytes < 0) {
+        fprintf(stderr, "Could not generate corpus in %s\n", site);
+        return 0;
+    }
+
+    printf("%d post(s), %.1f MB of markdown:\n", posts, bytes / (1024.0 * 1024.0));
+
+    remove_output(site);
+    BuildResult full = run_build(generator, site);
+    report("full", posts, bytes, full);
+
+    BuildResult unchanged = run_build(generator, site);
+    report("no change", posts, bytes, unchanged);
+
+    char path[PATH_MAX];
+    post_path(path, sizeof(path), site, posts / 2);
+    BuildResult changed = {0, 0, -1};
+    off_t original = change_post(path);
+    if (original >= 0) {
+        changed = run_build(generator, site);
+        restore_post(path, original);
+    }
+    report("one changed", posts, bytes, changed);
+
+    fflush(stdout);
+    return full.status == 0 && unchanged.status == 0 && changed.status == 0;
+}
+
+int main(int argc, char* argv[]) {
+    const char* generator = "./blog-generator";
+    const char* dir = BENCH_DEFAULT_DIR;
+    const char* template_path = "templates/post.html";
+    int sizes[16];
+    int size_count = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--generator") == 0 && i + 1 < argc) {
+            generator = argv[++i];
+        } else if (strcmp(argv[i], "--dir") == 0 && i + 1 < argc) {
+            dir = argv[++i];
+        } else if (strcmp(argv[i], "--template") == 0 && i + 1 < argc) {
+            template_path = argv[++i];
+        } else if (atoi(argv[i]) > 0 && size_count < 16) {
+            sizes[size_count++] = atoi(argv[i]);
+        } else {
+            printf("Usage: %s [--generator PATH] [--dir DIR] [--template PATH] POSTS...\n", argv[0]);
+            return 1;
+        }
+    }
+    if (size_count == 0) {
+        sizes[size_count++] = 1000;
+    }
+
+    // 子进程在站点目录中运行，生成器需使用绝对路径
+    char generator_path[PATH_MAX];
+    if (!realpath(generator, generator_path)) {
+        fprintf(stderr, "Could not find generator %s\n", generator);
+        return 1;
+    }
+    if (!make_dirs(dir)) {
+        fprintf(stderr, "Could not create %s\n", dir);
+        return 1;
+    }
+
+    int ok = 1;
+    for (int i = 0; i < size_count; i++) {
+        if (!bench_site(generator_path, dir, template_path, sizes[i])) ok = 0;
+    }
+    return ok ? 0 : 1;
+}
+
+#else
+
+int main(void) {
+    printf("The benchmark runner is only supported on POSIX systems\n");
+    return 1;
+}
+
+#endif
@@ -0,0 +1,315 @@
+// 解析器和渲染器的微基准：直接链接 parser.c 和 generator.c，在内存中的输入上测量热点函数，不受磁盘影响
+// 用法：blog-microbench [--reps N] [--warmup N] [--filter 子串]
+#include "../include/parser.h"
+#include "../include/generator.h"
+#include "../include/optimization.h"
+#include "../include/memstats.h"
+#include "../include/source.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MICRO_DEFAULT_REPS 20
+#define MICRO_DEFAULT_WARMUP 3
+#define MICRO_TEMPLATE_PATH "templates/post.html"
+
+// 模板文件不存在时使用的最小模板
+static const char* fallback_template =
+    "<!DOCTYPE html>\n<html><head><title>{{title}}</title></head>\n"
+    "<body><h1>{{title}}</h1><p>{{date}} {{author}}</p>\n{{content}}\n</body></html>\n";
+
+typedef struct {
+    const char* name;
+    char* text;               // Markdown 输入
+    size_t length;
+    ParserContext* parsed;    // 预先解析好的结果，供渲染测量使用
+    char* html;               // 预先渲染好的 HTML，供模板和清理测量使用
+    size_t html_length;
+    char* scratch;            // sanitize_html 会修改输入，每轮测量前重新复制
+} MicroInput;
+
+typedef struct {
+    const char* function;
+    void (*setup)(MicroInput* input);     // 每轮测量前调用，不计入时间
+    void (*run)(MicroInput* input);
+    int uses_html;            // 吞吐量按 HTML 大小而不是 Markdown 大小计算
+} MicroBench;
+
+static const char* template_text = NULL;
+static PostMetadata bench_metadata = {
+    .title = "Micro benchmark",
+    .date = "2024-01-01",
+    .author = "Bench",
+    .description = "In-memory parser and renderer benchmark",
+    .permalink = "micro-benchmark"
+};
+
+// 防止编译器把结果未使用的调用优化掉
+static volatile size_t sink;
+
+static void bench_scan(MicroInput* input) {
+    LineIndex lines = {0};
+    size_t error_offset;
+    if (scan_utf8_lines(input->text, input->length, &lines, &error_offset) == 1) sink += lines.count;
+    free_line_index(&lines);
+}
+
+static void bench_parse(MicroInput* input) {
+    ParserContext* ctx = create_parser_context(NULL);
+    if (ctx && parse_markdown_with_context(ctx, input->text)) sink += ctx->pool->used;
+    destroy_parser_context(ctx);
+}
+
+static void bench_render(MicroInput* input) {
+    char* html = get_html_output(input->parsed);
+    if (html) sink += strlen(html);
+    mem_free(MEM_RENDER, html);
+}
+
+static void bench_escape(MicroInput* input) {
+    char* escaped = escape_html(input->text);
+    if (escaped) sink += strlen(escaped);
+    free(escaped);
+}
+
+static void bench_template(MicroInput* input) {
+    char* page = apply_template(template_text, input->html, &bench_metadata);
+    if (page) sink += strlen(page);
+    mem_free(MEM_OUTPUT, page);
+}
+
+static void setup_sanitize(MicroInput* input) {
+    memcpy(input->scratch, input->html, input->html_length + 1);
+}
+
+static void bench_sanitize(MicroInput* input) {
+    sanitize_html(input->scratch);
+    sink += (unsigned char)input->scratch[0];
+}
+
+static const MicroBench benches[] = {
+    {"scan_utf8_lines", NULL, bench_scan, 0},
+    {"parse_markdown_with_context", NULL, bench_parse, 0},
+    {"get_html_output", NULL, bench_render, 0},
+    {"escape_html", NULL, bench_escape, 0},
+    {"apply_template", NULL, bench_template, 1},
+    {"sanitize_html", setup_sanitize, bench_sanitize, 1},
+};
+
+// 输入构造：按需扩容的字符串
+typedef struct {
+    char* data;
+    size_t length;
+    size_t capacity;
+} Text;
+
+static void text_append(Text* text, const char* str) {
+    size_t length = strlen(str);
+    if (text->length + length + 1 > text->capacity) {
+        size_t capacity = text->capacity ? text->capacity : 4096;
+        while (capacity < text->length + length + 1) capacity *= 2;
+        char* data = realloc(text->data, capacity);
+        if (!data) {
+            fprintf(stderr, "Out of memory while building inputs\n");
+            exit(1);
+        }
+        text->data = data;
+        text->capacity = capacity;
+    }
+    memcpy(text->data + text->length, str, length + 1);
+    text->length += length;
+}
+
+// 普通文章：标题、带行内格式的段落、列表、代码块，约 20 KB
+static Text typical_post(void) {
+    Text text = {0};
+    char line[256];
+    text_append(&text, "---\ntitle: Typical\ndate: 2024-01-01\n---\n\n");
+    for (int section = 0; section < 24; section++) {
+        snprintf(line, sizeof(line), "## Section %d\n\n", section);
+        text_append(&text, line);
+        text_append(&text, "Parsing **markdown** into _HTML_ needs `inline` handling, "
+                           "[links](https://example.com/page) and <escaped> & \"quoted\" text.\n\n");
+        for (int item = 0; item < 4; item++) {
+            snprintf(line, sizeof(line), "- list item %d with **bold** text\n", item);
+            text_append(&text, line);
+        }
+        text_append(&text, "\n```c\nint main(void) {\n    return printf(\"<%d>\", 42) < 0;\n}\n```\n\n");
+    }
+    return text;
+}
+
+// 10 MB 连续的 80 字节短行，中间没有空行（解析器会把超过 4 KB 的行截断，单行输入测不到解析本身）
+static Text wrapped_lines(void) {
+    Text text = {0};
+    const char* words = "lorem **ipsum** dolor _sit_ amet `consectetur` adipiscing elit sed do eiusmod \n";
+    while (text.length < 10 * 1024 * 1024) text_append(&text, words);
+    return text;
+}
+
+// 中文文章：正文几乎都是三字节字符，夹杂少量 ASCII 标点和 emoji，约 4 MB
+static Text cjk_post(void) {
+    Text text = {0};
+    text_append(&text, "---\ntitle: 中文\ndate: 2024-01-01\n---\n\n");
+    while (text.length < 4 * 1024 * 1024) {
+        text_append(&text, "## 静态博客生成器\n\n");
+        text_append(&text, "解析器逐行读取文章，把**标题**、列表和代码块转换成 HTML，"
+                           "再套用模板写入输出目录。增量构建只重新渲染修改过的文章 😀，"
+                           "未变化的页面直接跳过，大型站点也能在一秒内完成重建。\n\n");
+    }
+    return text;
+}
+
+// 10 万个列表项
+static Text long_list(void) {
+    Text text = {0};
+    char line[64];
+    for (int i = 0; i < 100000; i++) {
+        snprintf(line, sizeof(line), "- item %d\n", i);
+        text_append(&text, line);
+    }
+    return text;
+}
+
+// 深度嵌套：层层缩进的列表、引用以及嵌套的行内标记和链接
+static Text deep_nesting(void) {
+    Text text = {0};
+    for (int depth = 0; depth < 2000; depth++) {
+        for (int i = 0; i < depth % 64; i++) text_append(&text, "  ");
+        text_append(&text, "- nested\n");
+    }
+    text_append(&text, "\n");
+    for (int depth = 0; depth < 2000; depth++) text_append(&text, "> ");
+    text_append(&text, "quote\n\n");
+    for (int depth = 0; depth < 5000; depth++) text_append(&text, "**_[`");
+    text_append(&text, "core");
+    for (int depth = 0; depth < 5000; depth++) text_append(&text, "`](x)_**");
+    text_append(&text, "\n\n");
+    for (int i = 0; i < 2000; i++) text_append(&text, "<script>javascript:onerror=</script>\n");
+    return text;
+}
+
+static int prepare_input(MicroInput* input, const char* name, Text text) {
+    memset(input, 0, sizeof(MicroInput));
+    input->name = name;
+    input->text = text.data;
+    input->length = text.length;
+
+    input->parsed = create_parser_context(NULL);
+    if (!input->parsed || !parse_markdown_with_context(input->parsed, input->text)) return 0;
+    input->html = get_html_output(input->parsed);
+    if (!input->html) return 0;
+    input->html_length = strlen(input->html);
+    input->scratch = malloc(input->html_length + 1);
+    return input->scratch != NULL;
+}
+
+static void free_input(MicroInput* input) {
+    free(input->text);
+    destroy_parser_context(input->parsed);
+    mem_free(MEM_RENDER, input->html);
+    free(input->scratch);
+}
+
+static int compare_ns(const void* a, const void* b) {
+    long long x = *(const long long*)a;
+    long long y = *(const long long*)b;
+    return (x > y) - (x < y);
+}
+
+// 最近秩法取百分位
+static long long percentile(const long long* sorted, int count, int p) {
+    int rank = (p * count + 99) / 100;
+    if (rank < 1) rank = 1;
+    return sorted[rank - 1];
+}
+
+static void run_bench(const MicroBench* bench, MicroInput* input, int warmup, int reps, long long* samples) {
+    for (int i = 0; i < warmup; i++) {
+        if (bench->setup) bench->setup(input);
+        bench->run(input);
+    }
+    for (int i = 0; i < reps; i++) {
+        if (bench->setup) bench->setup(input);
+        long long start = monotonic_ns();
+        bench->run(input);
+        samples[i] = monotonic_ns() - start;
+    }
+    qsort(samples, reps, sizeof(long long), compare_ns);
+
+    size_t bytes = bench->uses_html ? input->html_length : input->length;
+    long long median = percentile(samples, reps, 50);
+    printf("%-28s %-10s %9.2f MB %10.3f %10.3f %10.3f %10.3f %10.3f %9.1f\n",
+           bench->function, input->name, bytes / (1024.0 * 1024.0),
+           samples[0] / 1e6, median / 1e6, percentile(samples, reps, 90) / 1e6,
+           percentile(samples, reps, 99) / 1e6, samples[reps - 1] / 1e6,
+           median > 0 ? bytes / (1024.0 * 1024.0) / (median / 1e9) : 0.0);
+    fflush(stdout);
+}
+
+static char* read_template(const char* path) {
+    FILE* fp = fopen(path, "rb");
+    if (!fp) return NULL;
+    fseek(fp, 0, SEEK_END);
+    long size = ftell(fp);
+    rewind(fp);
+    char* data = size >= 0 ? malloc(size + 1) : NULL;
+    if (data) data[fread(data, 1, size, fp)] = '\0';
+    fclose(fp);
+    return data;
+}
+
+int main(int argc, char* argv[]) {
+    int reps = MICRO_DEFAULT_REPS;
+    int warmup = MICRO_DEFAULT_WARMUP;
+    const char* filter = NULL;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--reps") == 0 && i + 1 < argc) {
+            reps = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--warmup") == 0 && i + 1 < argc) {
+            warmup = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--filter") == 0 && i + 1 < argc) {
+            filter = argv[++i];
+        } else {
+            printf("Usage: %s [--reps N] [--warmup N] [--filter SUBSTRING]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (reps < 1) reps = 1;
+    if (warmup < 0) warmup = 0;
+
+    char* template_file = read_template(MICRO_TEMPLATE_PATH);
+    template_text = template_file ? template_file : fallback_template;
+
+    MicroInput inputs[5];
+    const char* names[5] = {"typical", "lines-10mb", "cjk-4mb", "list-100k", "nested"};
+    Text (*builders[5])(void) = {typical_post, wrapped_lines, cjk_post, long_list, deep_nesting};
+    int input_count = 0;
+    for (int i = 0; i < 5; i++) {
+        if (!prepare_input(&inputs[input_count], names[i], builders[i]())) {
+            fprintf(stderr, "Could not prepare input %s\n", names[i]);
+            free_input(&inputs[input_count]);
+            continue;
+        }
+        input_count++;
+    }
+
+    long long* samples = malloc(reps * sizeof(long long));
+    if (!samples) return 1;
+
+    printf("%d warmup run(s), %d measured run(s); times in ms\n", warmup, reps);
+    printf("%-28s %-10s %12s %10s %10s %10s %10s %10s %9s\n",
+           "function", "input", "size", "min", "p50", "p90", "p99", "max", "MB/s");
+    for (size_t b = 0; b < sizeof(benches) / sizeof(benches[0]); b++) {
+        for (int i = 0; i < input_count; i++) {
+            if (filter && !strstr(benches[b].function, filter) && !strstr(inputs[i].name, filter)) continue;
+            run_bench(&benches[b], &inputs[i], warmup, reps, samples);
+        }
+    }
+
+    free(samples);
+    for (int i = 0; i < input_count; i++) free_input(&inputs[i]);
+    free(template_file);
+    return 0;
+}
@@ -0,0 +1,21 @@
+#ifndef ASSETS_H
+#define ASSETS_H
+
+#include "generator.h"
+
+// 资源清单文件（位于输出目录），记录上次构建的指纹以便跳过未变化的文件
+#define ASSET_MANIFEST_FILE ".asset-manifest"
+#define ASSET_HASH_DIGITS 8
+
+// 为 CSS/JS/图片生成带内容指纹的副本，并把清单保存到 ctx->assets
+int fingerprint_assets(GeneratorContext* ctx, const char* src_dir, const char* dest_dir);
+
+// 查询带指纹的路径，未找到时返回 NULL
+const char* lookup_asset(const AssetManifest* assets, const char* path);
+void free_asset_manifest(AssetManifest* assets);
+
+// 在编译模板时提取 <style> 块：压缩、去重后写入带指纹的 assets/css/site.<hash>.css，
+// 返回以 <link> 替换样式块的新模板（MEM_RENDER 分配）；config->critical_css 中的选择器仍保留在页面内
+char* extract_template_styles(GeneratorContext* ctx, const char* template_content);
+
+#endif /* ASSETS_H */
@@ -0,0 +1,73 @@
+#ifndef BLOG_H
+#define BLOG_H
+
+#include <stddef.h>
+
+// libblog：在进程内把内存中的 Markdown 渲染为 HTML，不读写文件
+// 每个 BlogRenderer 只能同时被一个线程使用，多线程时每个线程各建一个；
+// 编译后的 BlogTemplate 只读，可以在线程间共享
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if defined(_WIN32)
+#define BLOG_API
+#else
+#define BLOG_API __attribute__((visibility("default")))
+#endif
+
+typedef enum {
+    BLOG_OK = 0,
+    BLOG_ERROR_INVALID,       // 参数无效
+    BLOG_ERROR_MEMORY,        // 内存不足
+    BLOG_ERROR_ENCODING,      // 输入不是合法的 UTF-8
+    BLOG_ERROR_TOO_SMALL,     // 调用者的缓冲区不够，*out_length 为需要的长度（不含 '\0'）
+    BLOG_ERROR_TIMEOUT        // 在线程池任务中运行且超出了任务的时间预算
+} BlogStatus;
+
+// 页面元数据；字段可以为 NULL，对应的占位符输出为空
+typedef struct {
+    const char* title;
+    const char* date;
+    const char* author;
+    const char* description;
+} BlogMetadata;
+
+typedef struct BlogRenderer BlogRenderer;
+typedef struct BlogTemplate BlogTemplate;
+
+// 可复用的渲染上下文：解析器内存池、行索引和输出缓冲区在多次渲染间保留
+BLOG_API BlogRenderer* blog_renderer_create(void);
+BLOG_API void blog_renderer_destroy(BlogRenderer* renderer);
+
+// 把 markdown（length 字节，无需以 '\0' 结尾，开头的 front matter 会被跳过）渲染为 HTML 片段，
+// 写入调用者提供的 out；capacity 至少为 HTML 长度加 1，*out_length 为 HTML 长度
+BLOG_API BlogStatus blog_render_markdown(BlogRenderer* renderer, const char* markdown, size_t length,
+                                         char* out, size_t capacity, size_t* out_length);
+
+// 同上，但结果保存在渲染上下文自己的缓冲区中，*html 在下一次使用该上下文前有效
+BLOG_API BlogStatus blog_render_markdown_arena(BlogRenderer* renderer, const char* markdown, size_t length,
+                                               const char** html, size_t* html_length);
+
+// 编译模板，支持 {{content}}、{{title}}、{{date}}、{{author}}、{{description}} 和 {{asset:路径}}
+BLOG_API BlogTemplate* blog_template_compile(const char* source, size_t length);
+BLOG_API void blog_template_destroy(BlogTemplate* tpl);
+
+// 渲染 Markdown 并套用模板得到完整页面；metadata 为 NULL 时从 front matter 中读取
+BLOG_API BlogStatus blog_render_page(BlogRenderer* renderer, const BlogTemplate* tpl,
+                                     const char* markdown, size_t length, const BlogMetadata* metadata,
+                                     char* out, size_t capacity, size_t* out_length);
+BLOG_API BlogStatus blog_render_page_arena(BlogRenderer* renderer, const BlogTemplate* tpl,
+                                           const char* markdown, size_t length, const BlogMetadata* metadata,
+                                           const char** html, size_t* html_length);
+
+// 出错时的详细说明（如非法 UTF-8 的位置），在下一次使用该上下文前有效
+BLOG_API const char* blog_renderer_error(const BlogRenderer* renderer);
+BLOG_API const char* blog_status_message(BlogStatus status);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BLOG_H */
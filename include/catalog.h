@@ -0,0 +1,19 @@
+#ifndef CATALOG_H
+#define CATALOG_H
+
+#include "generator.h"
+
+// 目录缓存文件（位于输出目录）：文章元数据、标签和源文件的大小/修改时间，以及字符串表
+#define CATALOG_CACHE_FILE ".catalog-cache"
+#define CATALOG_CACHE_VERSION 1
+
+// 映射上次保存的目录缓存并直接填充 ctx->catalog；文件不存在或格式不符时返回 0，按冷启动处理
+int load_catalog_cache(GeneratorContext* ctx);
+// 把当前目录写成缓存文件（内容未变时不重写）
+int save_catalog_cache(GeneratorContext* ctx);
+void close_catalog_cache(CatalogCache* cache);
+
+// 指针是否指向缓存映射或缓存的元数据数组，这些内存不能单独释放
+int catalog_cache_owns(const CatalogCache* cache, const void* ptr);
+
+#endif /* CATALOG_H */
@@ -0,0 +1,22 @@
+#ifndef COMPRESS_H
+#define COMPRESS_H
+
+#include "generator.h"
+
+// 压缩结果
+typedef enum {
+    COMPRESS_FAILED = 0,
+    COMPRESS_WRITTEN,
+    COMPRESS_UNCHANGED      // 内容哈希未变，沿用已有的 .gz
+} CompressResult;
+
+// 把 input_path 压缩为 output_path.gz
+int compress_file(const char* input_path, const char* output_path);
+CompressResult compress_file_if_changed(const char* input_path, const char* output_path);
+
+// 在线程池上压缩输出目录中所有的 HTML/XML/CSS/JS 文件
+int compress_site(GeneratorContext* ctx);
+// 重新压缩监视模式下改写过的页面（见 track_rewritten_outputs），完成后清空记录
+int compress_rewritten_outputs(GeneratorContext* ctx);
+
+#endif /* COMPRESS_H */
@@ -6,6 +6,13 @@
 #include <string.h>
 #include <time.h>
 #include "parser.h"
+#include "optimization.h"
+#include "writer.h"
+#include "scan.h"
+
+#ifndef _WIN32
+#include <pthread.h>
+#endif
 
 // 错误处理枚举
 typedef enum {
@@ -13,7 +20,8 @@ typedef enum {
     GEN_ERROR_TIMEOUT,
     GEN_ERROR_MEMORY,
     GEN_ERROR_IO,
-    GEN_ERROR_NETWORK
+    GEN_ERROR_NETWORK,
+    GEN_ERROR_ENCODING
 } GeneratorError;
 
 // 博客配置结构体
@@ -28,10 +36,15 @@ typedef struct {
     int enable_compression;     // 启用Gzip压缩
     int enable_incremental;     // 启用增量构建
     int parallel_workers;       // 并行处理线程数
-    size_t chunk_size;         // 文件分块处理大小(KB)
-    int timeout_seconds;       // 操作超时时间
-    int retry_count;           // 重试次数
-    int retry_delay;           // 重试延迟(秒)
+    size_t chunk_size;         // 超过该大小(KB)的文章流式生成，也是流式写出的缓冲区大小；0 表示不使用
+    int post_budget_ms;        // 单篇文章的处理时间预算(毫秒)，0 表示不限
+    int retry_count;           // 单篇文章遇到临时 I/O 错误时的最多尝试次数
+    int hard_link_assets;      // 同步资源时尽量使用硬链接
+    int enable_fingerprint;    // 为 CSS/JS/图片生成带内容指纹的文件名
+    int enable_minify;         // 写出HTML时进行流式压缩
+    int extract_styles;        // 把模板中的 <style> 提取为共享样式表
+    const char* critical_css;  // 保留在页面内的关键选择器（逗号分隔）
+    int use_io_uring;          // 使用 io_uring 批量写出页面（仅 Linux）
 } BlogConfig;
 
 // 文章元数据结构体
@@ -45,14 +58,151 @@ typedef struct {
     int tag_count;
 } PostMetadata;
 
+// 编译后模板的片段类型
+typedef enum {
+    TPL_LITERAL = 0,
+    TPL_CONTENT,
+    TPL_TITLE,
+    TPL_DATE,
+    TPL_AUTHOR,
+    TPL_DESCRIPTION
+} TemplateSegmentType;
+
+// 模板片段：字面量文本或占位符
+typedef struct {
+    TemplateSegmentType type;
+    const char* text;         // 字面量文本（指向 source 内部）
+    size_t length;
+} TemplateSegment;
+
+// 编译后的模板，渲染时无需再扫描占位符
+typedef struct {
+    char* source;
+    TemplateSegment* segments;
+    int segment_count;
+    size_t literal_length;    // 所有字面量的总长度
+    char** owned_strings;     // 编译时解析出的文本（如带指纹的资源路径）
+    int owned_count;
+} CompiledTemplate;
+
+// 带内容指纹的资源条目，路径均相对 assets 目录
+typedef struct {
+    char* path;               // 原始路径，如 css/style.css
+    char* hashed_path;        // 带指纹的路径，如 css/style.3fa9c1d2.css
+    long long size;
+    long long mtime_ns;
+} AssetEntry;
+
+// 资源清单，按 path 排序以便二分查找
+typedef struct {
+    AssetEntry* entries;
+    int count;
+    int capacity;
+} AssetManifest;
+
+// 文章目录条目
+typedef struct {
+    char* source_path;        // 源文件路径
+    char* output_name;        // 输出文件名（相对输出目录）
+    PostMetadata* metadata;
+    long long size;           // 渲染时源文件的大小和修改时间，用于增量构建
+    long long mtime_ns;
+} CatalogEntry;
+
+// 常驻内存的文章目录
+typedef struct {
+    CatalogEntry* entries;
+    int count;
+    int capacity;
+    int* slots;               // 按源路径哈希的开放寻址索引，存放 下标+1，0 为空
+    int slot_count;
+} PostCatalog;
+
+// 从输出目录中 mmap 的目录缓存；条目的字符串和元数据直接指向这里，不做复制
+typedef struct {
+    void* map;
+    size_t map_length;
+    PostMetadata* metadata;   // 缓存条目的元数据结构
+    char** tags;              // 所有缓存条目的标签指针
+    int count;
+    uint64_t render_key;      // 条目渲染时的模板和配置指纹
+} CatalogCache;
+
+// 标签索引条目，posts 为目录条目下标
+typedef struct {
+    char* name;
+    int* posts;
+    int count;
+    int capacity;
+} TagEntry;
+
+typedef struct {
+    TagEntry* tags;
+    int count;
+    int capacity;
+} TagIndex;
+
+// 输出文件名到所属文章（源路径）的索引；owner 为 NULL 的槽位已删除
+typedef struct {
+    char* name;
+    char* owner;
+    int write_failed;         // 批量写出在 flush 时失败，文章不能记为已渲染
+} OutputNameSlot;
+
+typedef struct {
+    OutputNameSlot* slots;    // 开放寻址，首次分配文件名时由目录建立
+    int slot_count;
+    int used;                 // 占用的槽位数，包括已删除的
+} OutputNames;
+
+// 处理失败的文章及诊断信息
+typedef struct {
+    char* source_path;
+    GeneratorError error;
+    int sys_errno;            // 出错时的 errno，用于区分临时 I/O 错误
+    char message[256];
+} PostFailure;
+
+typedef struct {
+    PostFailure* items;
+    int count;
+    int capacity;
+} PostFailures;
+
+// 监视模式下重建时改写过的输出文件，flush 之后据此更新对应的 .gz
+typedef struct {
+    char** paths;
+    int count;
+    int capacity;
+    int enabled;              // 启用压缩的监视模式才记录
+} RewrittenOutputs;
+
+// 临时 I/O 错误的首次重试等待时间，之后每次翻倍
+#define POST_RETRY_DELAY_MS 50
+
 // 生成器上下文结构体
 typedef struct {
     MemPool* pool;
     BlogConfig* config;
     char* output_dir;
     char* template_dir;
-    time_t start_time;        // 添加开始时间字段
     GeneratorError last_error; // 添加错误状态字段
+    PostCatalog catalog;       // 文章目录
+    TagIndex tag_index;        // 标签索引
+    CompiledTemplate* post_template; // 已编译的文章模板
+    int catalog_changed;       // 目录中影响列表页的内容是否发生变化
+    WorkerPool* workers;       // 共享的工作线程池
+    AssetManifest assets;      // 资源指纹清单，供模板引擎查询
+    WriterStats writes;        // 输出文件写入统计
+    OutputBatch* output_batch; // 批量写出后端，未启用时为 NULL
+    CatalogCache catalog_cache; // 上次构建保存的目录缓存
+    PostFailures failures;     // 本次处理中失败的文章
+    OutputNames output_names;  // 已分配的输出文件名，渲染前登记，避免同名文章写同一个文件
+    RewrittenOutputs rewritten; // 初次构建之后改写的页面，由 compress_rewritten_outputs 重新压缩
+    ScanResult posts_scan;     // 最近一次扫描的结果，保留到下次扫描：性能分析记录直接引用其中的路径
+#ifndef _WIN32
+    pthread_mutex_t catalog_lock; // 并行处理文章时保护 catalog、failures 和 output_names
+#endif
 } GeneratorContext;
 
 // 生成器上下文操作
@@ -64,26 +214,57 @@ void create_directory_structure(const char* base_dir);
 
 // 文章处理函数
 PostMetadata* extract_post_metadata(const char* markdown_content);
+PostMetadata* extract_post_metadata_span(const char* markdown_content, size_t length);
+void free_post_metadata(PostMetadata* metadata);
 char* generate_permalink(const char* title, const char* date);
 int process_posts(GeneratorContext* ctx, const char* posts_dir);
+int process_single_post(GeneratorContext* ctx, const char* post_path);
+// 只读取 front matter 填充目录，不渲染正文；输出页面缺失的文章仍会完整渲染
+int process_posts_metadata(GeneratorContext* ctx, const char* posts_dir);
+int process_post_metadata(GeneratorContext* ctx, const char* post_path);
+// 单篇文章的失败不会中断构建，汇总在 ctx->failures 中
+int report_post_failures(const GeneratorContext* ctx);
+void clear_post_failures(GeneratorContext* ctx);
+int remove_post(GeneratorContext* ctx, const char* post_path);
+
+// 文章目录和标签索引
+CatalogEntry* find_catalog_entry(GeneratorContext* ctx, const char* source_path);
+void rebuild_catalog_index(PostCatalog* catalog);
+void rebuild_tag_index(GeneratorContext* ctx);
 
 // 页面生成函数
-int generate_post_page(GeneratorContext* ctx, const char* markdown_content, PostMetadata* metadata);
+int generate_post_page(GeneratorContext* ctx, const char* markdown_content, size_t length,
+                       const LineIndex* lines, PostMetadata* metadata, const char* output_name);
+// 边解析边写出，不保留整篇 HTML；process_single_post 对超过 chunk_size 的文章使用
+int generate_post_page_streaming(GeneratorContext* ctx, const char* markdown_content, size_t length,
+                                 PostMetadata* metadata, const char* output_name);
 int generate_index_page(GeneratorContext* ctx);
 int generate_tag_pages(GeneratorContext* ctx);
+int generate_tag_page(GeneratorContext* ctx, const TagEntry* tag);
+int remove_tag_page(GeneratorContext* ctx, const char* tag_name);
 int generate_archive_page(GeneratorContext* ctx);
 int generate_rss_feed(GeneratorContext* ctx);
 int generate_sitemap(GeneratorContext* ctx);
+int generate_list_pages(GeneratorContext* ctx);
+int flush_output(GeneratorContext* ctx);
+// 开始记录之后改写的输出文件（监视模式且启用压缩时）
+void track_rewritten_outputs(GeneratorContext* ctx);
+void clear_rewritten_outputs(GeneratorContext* ctx);
 
 // 模板处理函数
 char* apply_template(const char* template_content, const char* content, const PostMetadata* metadata);
+CompiledTemplate* compile_template(const char* template_content);
+CompiledTemplate* compile_template_with_assets(const char* template_content, const AssetManifest* assets);
+// 返回的页面用 mem_free(MEM_OUTPUT, ...) 释放
+char* render_template(const CompiledTemplate* tpl, const char* content, const PostMetadata* metadata);
+void destroy_template(CompiledTemplate* tpl);
+int load_post_template(GeneratorContext* ctx);
+// 已编译模板和影响页面输出的配置的指纹，与 catalog_cache.render_key 比较
+uint64_t render_fingerprint(const GeneratorContext* ctx);
 
 // 错误处理和优化函数
 GeneratorError get_last_error(GeneratorContext* ctx);
 const char* get_error_message(GeneratorError error);
-int has_operation_timeout(GeneratorContext* ctx);
-void sleep_with_backoff(int retry_count, int base_delay);
 int needs_rebuild(const char* source_file, const char* target_file);
-int compress_file(const char* input_path, const char* output_path);
 
 #endif /* GENERATOR_H */
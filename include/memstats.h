@@ -0,0 +1,38 @@
+#ifndef MEMSTATS_H
+#define MEMSTATS_H
+
+#include <stddef.h>
+#include <stdio.h>
+
+// 按子系统统计内存分配：字节数、次数、峰值和大小分布，计数器都是原子的，发布版本中也一直开启
+// 分配仍由 malloc 完成，字节数取自分配器记录的块大小，因此释放时无需传入大小
+typedef enum {
+    MEM_GENERAL = 0,          // ALLOC/FREE
+    MEM_ARENA,                // 解析器内存池的块
+    MEM_PARSER,               // 解析器上下文
+    MEM_RENDER,               // Markdown 转换出的 HTML 和编译后的模板
+    MEM_OUTPUT,               // 完整页面和输出缓冲区
+    MEM_SOURCE,               // 源文件缓冲区和行索引
+    MEM_CATALOG,              // 文章目录和标签索引
+    MEM_SCAN,                 // 目录扫描结果和监视状态
+    MEM_SERVER,               // 预览服务和渲染服务的连接与请求
+    MEM_SUBSYSTEM_COUNT
+} MemSubsystem;
+
+// 大小分布按 2 的幂分档：<=16、<=32 …… <=256KB，最后一档为更大的分配
+#define MEM_SIZE_CLASSES 16
+
+void* mem_malloc(MemSubsystem subsystem, size_t size);
+void* mem_calloc(MemSubsystem subsystem, size_t count, size_t size);
+void* mem_realloc(MemSubsystem subsystem, void* ptr, size_t size);
+char* mem_strdup(MemSubsystem subsystem, const char* str);
+// 只能释放用同一子系统的 mem_* 函数分配的内存
+void mem_free(MemSubsystem subsystem, void* ptr);
+
+// 内存池销毁时报告实际使用的字节数和申请的容量，用于确定初始大小
+void mem_stats_arena(size_t used, size_t reserved);
+
+// 输出各子系统的统计
+void mem_stats_dump(FILE* fp);
+
+#endif /* MEMSTATS_H */
@@ -0,0 +1,51 @@
+#ifndef MINIFY_H
+#define MINIFY_H
+
+#include <stddef.h>
+
+// 输出回调：minifier 把处理后的数据分块交给调用者
+typedef void (*MinifyEmit)(void* user, const char* data, size_t length);
+
+#define MINIFY_OUT_SIZE 4096
+#define MINIFY_TAG_SIZE 32
+#define MINIFY_VALUE_SIZE 256
+
+// 流式HTML压缩器状态；输入可以任意切分，跨块的标签、注释和属性值都能正确处理
+typedef struct {
+    MinifyEmit emit;
+    void* user;
+
+    int state;
+    int pending_space;        // 有待决定的空白：0 无，1 普通空白，2 含换行的空白
+    int after_block_tag;      // 上一个输出是块级标签
+    int started;              // 已输出过内容（用于丢弃开头的空白）
+
+    char tag[MINIFY_TAG_SIZE];     // 尚未输出的 "<" + 标签名
+    size_t tag_len;
+    int closing;                   // 当前是结束标签
+    char tag_name[MINIFY_TAG_SIZE];
+    int tag_is_block;
+
+    char raw_tag[MINIFY_TAG_SIZE]; // 原样输出的元素（pre/code/script/style/textarea）
+    size_t raw_match;              // 已匹配的 "</raw_tag" 长度
+
+    char value[MINIFY_VALUE_SIZE]; // 缓存的带引号属性值，用于判断能否去掉引号
+    size_t value_len;
+    char quote;
+    int attr_space;                // 标签内待输出的空白
+    char last_tag_char;            // 标签内最后输出的字符
+
+    int dashes;                    // 注释结尾匹配计数
+
+    char out[MINIFY_OUT_SIZE];
+    size_t out_len;
+} HtmlMinifier;
+
+void minifier_init(HtmlMinifier* m, MinifyEmit emit, void* user);
+void minifier_feed(HtmlMinifier* m, const char* data, size_t length);
+void minifier_finish(HtmlMinifier* m);
+
+// 压缩CSS：删除注释和多余空白，字符串原样保留；out 至少与输入等长，返回输出长度
+size_t minify_css(const char* css, size_t length, char* out);
+
+#endif /* MINIFY_H */
@@ -1 +1,45 @@
- 
\ No newline at end of file
+#ifndef OPTIMIZATION_H
+#define OPTIMIZATION_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdatomic.h>
+
+// 内容哈希（64位 FNV-1a），用于 ETag 和变更检测
+uint64_t content_hash(const void* data, size_t length);
+uint64_t content_hash_update(uint64_t hash, const void* data, size_t length);
+
+#define CONTENT_HASH_INIT 0xcbf29ce484222325ULL
+
+// 协作式取消：任务在阶段边界调用 cancel_requested，超出预算或被取消时尽早返回
+typedef struct {
+    atomic_int cancelled;
+    long long budget_ms;      // 任务的时间预算，0 表示不限
+    long long deadline_ns;    // 任务开始运行时由线程池设置，排队时间不计入预算
+} CancelToken;
+
+void cancel_token_init(CancelToken* token, long long budget_ms);
+void cancel_token_cancel(CancelToken* token);
+// 在任务运行期间重新开始计时，用于一个任务依次处理多个各自有预算的请求
+void cancel_token_restart(CancelToken* token);
+int cancel_requested(CancelToken* token);
+long long monotonic_ns(void);
+
+// 工作线程池
+typedef void (*WorkerTask)(void* arg);
+typedef struct WorkerPool WorkerPool;
+
+// 创建线程池；workers <= 1 时任务在提交线程中同步执行
+WorkerPool* worker_pool_create(int workers);
+// 提交任务，任务内部也可以继续提交任务
+int worker_pool_submit(WorkerPool* pool, WorkerTask task, void* arg);
+// 提交带时间预算的任务：任务开始运行时计时，运行期间可通过 worker_pool_current_token 取得令牌
+int worker_pool_submit_with_token(WorkerPool* pool, WorkerTask task, void* arg, CancelToken* token);
+// 当前线程正在运行的任务的令牌，没有时返回 NULL
+CancelToken* worker_pool_current_token(void);
+// 等待所有已提交（包括任务中再提交）的任务完成
+void worker_pool_wait(WorkerPool* pool);
+void worker_pool_destroy(WorkerPool* pool);
+int worker_pool_size(const WorkerPool* pool);
+
+#endif /* OPTIMIZATION_H */
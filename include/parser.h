@@ -4,6 +4,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include "source.h"
 
 // Markdown 块类型定义
 typedef enum {
@@ -23,11 +24,13 @@ typedef struct Block {
     struct Block* next;
 } Block;
 
-// 内存池结构体定义
+// 内存池结构体定义：用满时另开一块，已分配的内存不会移动
 typedef struct {
-    char* pool;
+    char* pool;               // 当前块，开头保存上一块的指针
     size_t used;
     size_t capacity;
+    size_t retired_used;      // 之前各块的用量合计
+    size_t reserved;          // 所有块的容量合计
 } MemPool;
 
 // 解析器配置结构体
@@ -38,24 +41,39 @@ typedef struct {
     char* syntax_theme;       // 代码高亮主题
 } ParserConfig;
 
+// 流式输出回调：HTML 按块依次交给调用者
+typedef void (*HtmlSink)(void* user, const char* data, size_t length);
+
 // 解析器上下文结构体
 typedef struct {
     MemPool* pool;           // 内存池
     ParserConfig config;     // 解析器配置
     Block* first_block;      // 第一个块
     Block* current_block;    // 当前处理的块
+    HtmlSink sink;           // 流式解析时不为 NULL：块完成后立即渲染写出，不保留块链表
+    void* sink_user;
+    int sink_list;           // 流式渲染时当前打开的列表类型
+    size_t block_count;      // 流式解析时已写出的块数
 } ParserContext;
 
 // 内存池操作函数
 MemPool* create_memory_pool(size_t initial_size);
 void* pool_alloc(MemPool* pool, size_t size);
+void reset_memory_pool(MemPool* pool);
 void destroy_memory_pool(MemPool* pool);
 
 // 高级解析函数
 ParserContext* create_parser_context(const ParserConfig* config);
+void reset_parser_context(ParserContext* ctx);
 void destroy_parser_context(ParserContext* ctx);
 int parse_markdown_with_context(ParserContext* ctx, const char* content);
+int parse_markdown_span(ParserContext* ctx, const char* content, size_t length);
+int parse_markdown_indexed(ParserContext* ctx, const char* content, size_t length, const LineIndex* lines);
 char* get_html_output(ParserContext* ctx);
+// 边解析边渲染：每完成一个块就把 HTML 交给 sink，内存只与最大的单个块有关；
+// 输出与 parse_markdown_indexed 加 get_html_output 逐字节相同
+int parse_markdown_streaming(ParserContext* ctx, const char* content, size_t length,
+                             HtmlSink sink, void* user);
 
 // 工具函数
 char* escape_html(const char* str);
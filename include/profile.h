@@ -0,0 +1,40 @@
+#ifndef PROFILE_H
+#define PROFILE_H
+
+// 构建各阶段的耗时分析（--profile）：每个线程把事件记录在自己的缓冲区中，构建结束后
+// 合并输出为 Chrome trace-event JSON（可在 chrome://tracing 或 Perfetto 中打开），并打印最慢的文章
+#define PROFILE_TRACE_FILE "blog-profile.json"
+#define PROFILE_TOP_POSTS 10
+
+typedef enum {
+    PROFILE_SCAN = 0,
+    PROFILE_READ,
+    PROFILE_FRONT_MATTER,
+    PROFILE_PARSE,
+    PROFILE_RENDER,
+    PROFILE_TEMPLATE,
+    PROFILE_WRITE,
+    PROFILE_COMPRESS,
+    PROFILE_PHASE_COUNT
+} ProfilePhase;
+
+// 一次计时；未启用分析时 start_ns 为 0，profile_end 直接返回
+typedef struct {
+    ProfilePhase phase;
+    const char* subject;      // 文章或文件路径，只保存指针，须保持有效直到 profile_report
+    long long start_ns;
+} ProfileSpan;
+
+// 须在创建线程池之前调用
+void profile_enable(void);
+int profile_enabled(void);
+
+ProfileSpan profile_begin(ProfilePhase phase, const char* subject);
+void profile_end(const ProfileSpan* span);
+
+// 写出 trace 文件并打印各阶段合计和最慢的 top_n 篇文章，之后停止记录
+int profile_report(const char* trace_path, int top_n);
+// 释放所有线程的缓冲区，须在工作线程退出之后调用
+void profile_shutdown(void);
+
+#endif /* PROFILE_H */
@@ -0,0 +1,32 @@
+#ifndef RENDER_SERVER_H
+#define RENDER_SERVER_H
+
+// 渲染服务：常驻进程通过 Unix 域套接字接收渲染请求，供编辑器实时预览使用
+// 模板只编译一次，每个工作线程保留一个 BlogRenderer（解析器内存池和缓冲区在请求间复用）
+//
+// 协议：整数均为 32 位大端无符号数，一个连接上可以连续发送多个请求，按顺序应答
+//   请求：mode、markdown 长度、title 长度、date 长度、author 长度、description 长度，
+//         随后依次是这六个长度对应的字节（mode 之外的五段）
+//         mode 为 RENDER_MODE_FRAGMENT 时只渲染 Markdown，为 RENDER_MODE_PAGE 时套用模板；
+//         四个元数据长度都为 0 时从 front matter 中读取
+//   应答：status（BlogStatus）、长度，随后是 HTML；status 不为 0 时是错误说明
+//   请求格式错误或超过 RENDER_MAX_REQUEST 时服务端回复 BLOG_ERROR_INVALID 并关闭连接
+
+#define RENDER_MODE_FRAGMENT 0
+#define RENDER_MODE_PAGE 1
+
+#define RENDER_HEADER_FIELDS 6
+#define RENDER_MAX_REQUEST (64 * 1024 * 1024)
+#define RENDER_SEND_TIMEOUT_MS 5000      // 客户端不读取应答时放弃该连接
+
+typedef struct {
+    const char* socket_path;
+    const char* template_path;   // 文章模板，RENDER_MODE_PAGE 使用
+    int workers;
+    int budget_ms;               // 单个请求的时间预算，0 表示不限
+} RenderServerConfig;
+
+// 运行渲染服务，收到 SIGINT/SIGTERM 后删除套接字文件并返回
+int run_render_server(const RenderServerConfig* config);
+
+#endif /* RENDER_SERVER_H */
@@ -0,0 +1,26 @@
+#ifndef SCAN_H
+#define SCAN_H
+
+#include "optimization.h"
+
+// 扫描到的源文件，路径包含扫描根目录前缀（如 posts/2024/05/hello.md）
+typedef struct {
+    char* path;
+    long long size;
+    long long mtime_ns;
+} ScanEntry;
+
+typedef struct {
+    ScanEntry* entries;
+    int count;
+    int capacity;
+} ScanResult;
+
+// 递归扫描目录中的 Markdown 文件；子目录分发到线程池并行遍历，同时收集大小和修改时间
+int scan_markdown_files(const char* root, WorkerPool* workers, ScanResult* result);
+void free_scan_result(ScanResult* result);
+
+// 按文件大小从大到小排序，便于并行处理时先调度耗时最长的文件
+void sort_scan_by_size(ScanResult* result);
+
+#endif /* SCAN_H */
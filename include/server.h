@@ -0,0 +1,22 @@
+#ifndef SERVER_H
+#define SERVER_H
+
+#include "watch.h"
+
+#define SERVER_DEFAULT_PORT 8000
+#define SERVER_MAX_REQUEST 8192          // 请求头最大长度
+#define SERVER_CACHE_LIMIT (256 * 1024)  // 超过此大小的文件用 sendfile 发送
+#define SERVER_IDLE_TIMEOUT 30           // 空闲连接超时(秒)
+
+// 预览服务器配置
+typedef struct {
+    const char* root;        // 站点根目录（生成器输出目录）
+    const char* host;        // 监听地址
+    int port;                // 监听端口
+    Watcher* watcher;        // 可选：在同一个事件循环里处理文件变更
+} ServerConfig;
+
+// 运行单线程 epoll 预览服务器，收到 SIGINT/SIGTERM 后返回
+int run_preview_server(const ServerConfig* config);
+
+#endif /* SERVER_H */
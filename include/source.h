@@ -0,0 +1,49 @@
+#ifndef SOURCE_H
+#define SOURCE_H
+
+#include <stddef.h>
+
+// 不超过该大小的文件读入线程内复用的缓冲区，更大的文件直接 mmap（见 source_set_mmap）
+#define SOURCE_SMALL_FILE (64 * 1024)
+
+// 只读 front matter 时每次读取的大小，找不到结束的 "---" 才继续扩大
+#define SOURCE_HEADER_CHUNK 4096
+
+// 行索引：starts[i] 为第 i 行相对 base 的起始偏移，解析器据此定位行尾
+typedef struct {
+    const char* base;
+    size_t* starts;
+    size_t count;
+    size_t capacity;
+} LineIndex;
+
+// 只读的源文件视图；data 不以 '\0' 结尾，长度由 length 给出，BOM 已跳过
+typedef struct {
+    const char* data;
+    size_t length;
+    void* map;                // mmap 区域，未映射时为 NULL
+    size_t map_length;
+    char* owned;              // 自行分配的缓冲区
+    int uses_scratch;         // 使用了线程内的复用缓冲区
+    LineIndex lines;          // source_index_lines 建立的行索引
+    size_t error_offset;      // 第一个非法 UTF-8 字节的偏移
+} SourceFile;
+
+int source_open(SourceFile* src, const char* path);
+// 关闭后大文件也读入内存：--watch 期间编辑器可能原地截短正在映射的文件，
+// 访问截掉的部分会触发 SIGBUS；需在工作线程启动前调用
+void source_set_mmap(int enabled);
+// 只读取文件开头直到 front matter 结束，不读正文；data 中可能包含正文的开头部分
+int source_open_header(SourceFile* src, const char* path);
+void source_close(SourceFile* src);
+
+// 一遍扫描完成 UTF-8 校验并建立行索引
+// 返回 1 表示合法；0 表示非法 UTF-8，error_offset 为出错字节的偏移；-1 表示内存不足
+int source_index_lines(SourceFile* src);
+// 只校验 UTF-8、不建立行索引，流式生成的大文件使用；返回值同 source_index_lines
+int source_validate_utf8(SourceFile* src);
+// lines 为 NULL 时只校验
+int scan_utf8_lines(const char* data, size_t length, LineIndex* lines, size_t* error_offset);
+void free_line_index(LineIndex* lines);
+
+#endif /* SOURCE_H */
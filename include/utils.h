@@ -5,24 +5,29 @@
 #include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
+#include "optimization.h"
+#include "memstats.h"
 
-// ڴ׷ٺ
-#ifdef DEBUG
-    #define ALLOC(size) tracked_malloc(size, __FILE__, __LINE__)
-    #define FREE(ptr) tracked_free(ptr, __FILE__, __LINE__)
-#else
-    #define ALLOC(size) malloc(size)
-    #define FREE(ptr) free(ptr)
-#endif
-
-// ڴ׷ٺ
-void* tracked_malloc(size_t size, const char* file, int line);
-void tracked_free(void* ptr, const char* file, int line);
+// ڴ꣺ MEM_GENERAL ͳ
+#define ALLOC(size) mem_malloc(MEM_GENERAL, size)
+#define FREE(ptr) mem_free(MEM_GENERAL, ptr)
 
 // Ŀ¼
 void mkdir_p(const char* path);
 void copy_directory(const char* src, const char* dest);
 
+// Դͬͳ
+typedef struct {
+    int copied;
+    int linked;
+    int unchanged;
+    int failed;
+} SyncStats;
+
+// ݹͬĿ¼δ仯ļhard_link ΪʱʹӲ
+int sync_directory(const char* src, const char* dest, WorkerPool* workers,
+                   int hard_link, SyncStats* stats);
+
 // ַ
 void trim_whitespace(char* str);
 char* format_rss_date(const char* date);
@@ -35,13 +40,44 @@ int is_markdown_file(const char* filename);
 // ļϵͳ
 int file_exists(const char* path);
 long get_file_size(const char* path);
+struct stat;
+long long stat_mtime_ns(const struct stat* st);  // 뾫ȵ޸ʱ
 
 // HTMLURL뺯
 void html_encode(const char* src, char* dest, size_t dest_size);
 void url_encode(const char* src, char* dest, size_t dest_size);
 
-// ־
-void log_debug(const char* fmt, ...);
-void log_error(const char* fmt, ...);
+// ־˺д stderrÿϢԶ
+// ̳߳еϢд߳ԼĻ򻺳ʱһдмϵͳ
+typedef enum {
+    LOG_LEVEL_ERROR = 0,
+    LOG_LEVEL_WARN,           // --quiet ֻһ
+    LOG_LEVEL_INFO,           // Ĭ
+    LOG_LEVEL_DEBUG           // --verboseÿƪµĴ
+} LogLevel;
+
+#define LOG_BUFFER_SIZE 8192
+
+extern LogLevel log_level;
+
+#if defined(__GNUC__)
+__attribute__((format(printf, 3, 4)))
+#endif
+void log_write(LogLevel level, const char* prefix, const char* fmt, ...);
+void log_set_level(LogLevel level);
+// ʼͽʱ̳߳صãǶ
+void log_batch_begin(void);
+void log_batch_end(void);
+// дǰ̻߳Ϣ
+void log_flush(void);
+
+// жϼֵرյļκθʽ
+#define log_message(level, ...) \
+    do { if ((level) <= log_level) log_write(level, "", __VA_ARGS__); } while (0)
+#define log_error(...) log_write(LOG_LEVEL_ERROR, "Error: ", __VA_ARGS__)
+#define log_warn(...) \
+    do { if (LOG_LEVEL_WARN <= log_level) log_write(LOG_LEVEL_WARN, "Warning: ", __VA_ARGS__); } while (0)
+#define log_info(...) log_message(LOG_LEVEL_INFO, __VA_ARGS__)
+#define log_debug(...) log_message(LOG_LEVEL_DEBUG, __VA_ARGS__)
 
 #endif /* UTILS_H */
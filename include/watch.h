@@ -0,0 +1,23 @@
+#ifndef WATCH_H
+#define WATCH_H
+
+#include "generator.h"
+
+// 事件去抖时间：最后一次事件后等待这么久再重建
+#define WATCH_DEBOUNCE_MS 150
+
+// 文件监视器，持有常驻的生成器上下文
+typedef struct Watcher Watcher;
+
+// 监视器操作
+Watcher* watcher_create(GeneratorContext* ctx, const char* posts_dir, const char* template_dir);
+void watcher_destroy(Watcher* watcher);
+int watcher_fd(const Watcher* watcher);
+int watcher_read_events(Watcher* watcher);
+int watcher_timeout_ms(const Watcher* watcher);
+int watcher_flush(Watcher* watcher);
+
+// 监视模式主循环，收到 SIGINT/SIGTERM 后返回
+int run_watch_mode(GeneratorContext* ctx, const char* posts_dir, const char* template_dir);
+
+#endif /* WATCH_H */
@@ -0,0 +1,87 @@
+#ifndef WRITER_H
+#define WRITER_H
+
+#include <stddef.h>
+#include <stdio.h>
+#include <stdatomic.h>
+
+// 写出结果
+typedef enum {
+    WRITE_FAILED = 0,
+    WRITE_WRITTEN,
+    WRITE_UNCHANGED,        // 磁盘上的内容完全相同，未改动文件（mtime 保持不变）
+    WRITE_QUEUED            // 已交给批量写出，结果在 flush 时才知道
+} WriteResult;
+
+// 写出统计，可在多个线程间共享
+typedef struct {
+    atomic_int written;
+    atomic_int unchanged;
+    atomic_int failed;
+} WriterStats;
+
+// 输出过滤器：设置后写入缓冲区的数据先交给过滤器（如 HTML 压缩），由它用 output_append_raw 写回
+typedef void (*OutputFilter)(void* user, const char* data, size_t length);
+
+// 页面输出缓冲区：整页生成完毕后再一次性提交
+typedef struct {
+    char* data;
+    size_t length;
+    size_t capacity;
+    int failed;             // 内存分配失败，提交时报错
+    OutputFilter filter;
+    void* filter_user;
+} OutputBuffer;
+
+void output_init(OutputBuffer* out);
+void output_free(OutputBuffer* out);
+// 接管 mem_malloc(MEM_OUTPUT) 分配、以 '\0' 结尾的数据
+void output_adopt(OutputBuffer* out, char* data, size_t length);
+void output_set_filter(OutputBuffer* out, OutputFilter filter, void* user);
+void output_append(OutputBuffer* out, const char* data, size_t length);
+// 直接追加到缓冲区，不经过过滤器
+void output_append_raw(OutputBuffer* out, const char* data, size_t length);
+void output_puts(OutputBuffer* out, const char* str);
+void output_putc(OutputBuffer* out, char c);
+void output_printf(OutputBuffer* out, const char* fmt, ...);
+
+// 内容与磁盘上的文件不同时，写入临时文件再 rename 替换，不会留下半截文件
+WriteResult write_output_file(const char* path, const char* data, size_t length, WriterStats* stats);
+WriteResult output_commit(OutputBuffer* out, const char* path, WriterStats* stats);
+
+// 流式写出：内容分块写入临时文件，同时与磁盘上的旧文件逐段比较，提交时内容相同则丢弃临时文件
+// 用于放不进内存的大页面；path 在提交或放弃前必须保持有效
+typedef struct {
+    const char* path;
+    char tmp_path[1100];
+    FILE* fp;
+    FILE* existing;           // 旧文件，已发现不同或不存在时为 NULL
+    size_t existing_length;
+    size_t length;
+    char* buffer;             // 临时文件的 stdio 缓冲区
+    int failed;
+} OutputStream;
+
+int output_stream_open(OutputStream* stream, const char* path, size_t buffer_size);
+void output_stream_write(OutputStream* stream, const char* data, size_t length);
+WriteResult output_stream_commit(OutputStream* stream, WriterStats* stats);
+void output_stream_abort(OutputStream* stream);
+
+// 批量写出后端（Linux io_uring）：一次提交多个文件的 open/write/close/rename
+// 内核或环境不支持时 output_batch_create 返回 NULL，调用者改用 write_output_file
+#define OUTPUT_BATCH_FILES 64
+
+typedef struct OutputBatch OutputBatch;
+
+// 某个排队的文件最终写出失败时在 flush 中调用（持有批处理的锁），调用者据此把对应文章标记为需要重新渲染
+typedef void (*BatchFailure)(void* user, const char* path);
+
+OutputBatch* output_batch_create(WriterStats* stats, BatchFailure on_failure, void* user);
+// 排队写出 data（取得所有权，完成后释放；须由 mem_malloc(MEM_OUTPUT, ...) 分配）；通常返回 WRITE_QUEUED，
+// 内容与磁盘相同时立即返回 WRITE_UNCHANGED
+WriteResult output_batch_add(OutputBatch* batch, const char* path, char* data, size_t length);
+// 提交并等待所有排队的文件，返回失败的文件数
+int output_batch_flush(OutputBatch* batch);
+void output_batch_destroy(OutputBatch* batch);
+
+#endif /* WRITER_H */
@@ -0,0 +1,610 @@
+#include "../include/assets.h"
+#include "../include/optimization.h"
+#include "../include/minify.h"
+#include "../include/utils.h"
+#include <sys/stat.h>
+#include <dirent.h>
+#include <errno.h>
+#include <ctype.h>
+
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+// 需要指纹化的资源类型
+static int is_fingerprintable(const char* name) {
+    static const char* exts[] = {
+        ".css", ".js", ".png", ".jpg", ".jpeg", ".gif", ".svg", ".webp", ".ico", ".avif"
+    };
+    size_t len = strlen(name);
+
+    for (size_t i = 0; i < sizeof(exts)/sizeof(exts[0]); i++) {
+        size_t ext_len = strlen(exts[i]);
+        if (len > ext_len && strcmp(name + len - ext_len, exts[i]) == 0) return 1;
+    }
+    return 0;
+}
+
+static int compare_assets(const void* a, const void* b) {
+    return strcmp(((const AssetEntry*)a)->path, ((const AssetEntry*)b)->path);
+}
+
+const char* lookup_asset(const AssetManifest* assets, const char* path) {
+    if (!assets || !path || assets->count == 0) return NULL;
+
+    AssetEntry key = { .path = (char*)path };
+    AssetEntry* entry = bsearch(&key, assets->entries, assets->count, sizeof(AssetEntry), compare_assets);
+    return entry ? entry->hashed_path : NULL;
+}
+
+void free_asset_manifest(AssetManifest* assets) {
+    if (!assets) return;
+
+    for (int i = 0; i < assets->count; i++) {
+        free(assets->entries[i].path);
+        free(assets->entries[i].hashed_path);
+    }
+    free(assets->entries);
+    memset(assets, 0, sizeof(AssetManifest));
+}
+
+static AssetEntry* add_asset(AssetManifest* assets, const char* path) {
+    if (assets->count == assets->capacity) {
+        int new_capacity = assets->capacity ? assets->capacity * 2 : 64;
+        AssetEntry* entries = realloc(assets->entries, new_capacity * sizeof(AssetEntry));
+        if (!entries) return NULL;
+        assets->entries = entries;
+        assets->capacity = new_capacity;
+    }
+
+    AssetEntry* entry = &assets->entries[assets->count];
+    memset(entry, 0, sizeof(AssetEntry));
+    entry->path = strdup(path);
+    if (!entry->path) return NULL;
+
+    assets->count++;
+    return entry;
+}
+
+// 递归收集源目录中的资源
+static void collect_assets(const char* src_dir, const char* rel_dir, AssetManifest* assets) {
+    char dir_path[1024];
+    if (rel_dir[0]) snprintf(dir_path, sizeof(dir_path), "%s/%s", src_dir, rel_dir);
+    else snprintf(dir_path, sizeof(dir_path), "%s", src_dir);
+
+    DIR* dir = opendir(dir_path);
+    if (!dir) return;
+
+    struct dirent* entry;
+    while ((entry = readdir(dir)) != NULL) {
+        if (entry->d_name[0] == '.' || strpbrk(entry->d_name, "\t\n")) continue;
+
+        char rel_path[1024];
+        char full_path[2100];
+        if (rel_dir[0]) snprintf(rel_path, sizeof(rel_path), "%s/%s", rel_dir, entry->d_name);
+        else snprintf(rel_path, sizeof(rel_path), "%s", entry->d_name);
+        snprintf(full_path, sizeof(full_path), "%s/%s", src_dir, rel_path);
+
+        struct stat st;
+        if (stat(full_path, &st) != 0) continue;
+
+        if (S_ISDIR(st.st_mode)) {
+            collect_assets(src_dir, rel_path, assets);
+        } else if (S_ISREG(st.st_mode) && is_fingerprintable(entry->d_name)) {
+            AssetEntry* asset = add_asset(assets, rel_path);
+            if (asset) {
+                asset->size = (long long)st.st_size;
+                asset->mtime_ns = stat_mtime_ns(&st);
+            }
+        }
+    }
+    closedir(dir);
+}
+
+// 读取上次构建保存的清单：path \t hashed_path \t size \t mtime_ns
+static void load_manifest(const char* manifest_path, AssetManifest* assets) {
+    FILE* fp = fopen(manifest_path, "r");
+    if (!fp) return;
+
+    char line[2200];
+    while (fgets(line, sizeof(line), fp)) {
+        char* path = strtok(line, "\t");
+        char* hashed = strtok(NULL, "\t");
+        char* size = strtok(NULL, "\t");
+        char* mtime = strtok(NULL, "\n");
+        if (!path || !hashed || !size || !mtime) continue;
+
+        AssetEntry* entry = add_asset(assets, path);
+        if (!entry) break;
+        entry->hashed_path = strdup(hashed);
+        entry->size = atoll(size);
+        entry->mtime_ns = atoll(mtime);
+    }
+    fclose(fp);
+
+    qsort(assets->entries, assets->count, sizeof(AssetEntry), compare_assets);
+}
+
+static int save_manifest(const char* manifest_path, const AssetManifest* assets) {
+    char tmp_path[1100];
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", manifest_path);
+
+    FILE* fp = fopen(tmp_path, "w");
+    if (!fp) return 0;
+
+    for (int i = 0; i < assets->count; i++) {
+        const AssetEntry* entry = &assets->entries[i];
+        if (!entry->hashed_path) continue;
+        fprintf(fp, "%s\t%s\t%lld\t%lld\n", entry->path, entry->hashed_path,
+                entry->size, entry->mtime_ns);
+    }
+
+    int success = fclose(fp) == 0;
+    if (success) success = rename(tmp_path, manifest_path) == 0;
+    if (!success) remove(tmp_path);
+    return success;
+}
+
+// 在扩展名前插入指纹：css/style.css -> css/style.3fa9c1d2.css
+static char* build_hashed_path(const char* path, uint64_t hash) {
+    const char* slash = strrchr(path, '/');
+    const char* dot = strrchr(path, '.');
+    if (!dot || (slash && dot < slash)) dot = path + strlen(path);
+
+    size_t size = strlen(path) + ASSET_HASH_DIGITS + 2;
+    char* hashed = malloc(size);
+    if (hashed) {
+        snprintf(hashed, size, "%.*s.%0*llx%s", (int)(dot - path), path,
+                 ASSET_HASH_DIGITS, (unsigned long long)(hash >> (64 - 4 * ASSET_HASH_DIGITS)), dot);
+    }
+    return hashed;
+}
+
+static int hash_file(const char* path, uint64_t* hash_out) {
+    FILE* fp = fopen(path, "rb");
+    if (!fp) return 0;
+
+    char buffer[65536];
+    uint64_t hash = CONTENT_HASH_INIT;
+    size_t n;
+    while ((n = fread(buffer, 1, sizeof(buffer), fp)) > 0) {
+        hash = content_hash_update(hash, buffer, n);
+    }
+    int success = !ferror(fp);
+    fclose(fp);
+
+    *hash_out = hash;
+    return success;
+}
+
+static int copy_file_contents(const char* src, const char* dest) {
+    FILE* in = fopen(src, "rb");
+    if (!in) return 0;
+    FILE* out = fopen(dest, "wb");
+    if (!out) {
+        fclose(in);
+        return 0;
+    }
+
+    char buffer[65536];
+    size_t n;
+    int success = 1;
+    while (success && (n = fread(buffer, 1, sizeof(buffer), in)) > 0) {
+        success = fwrite(buffer, 1, n, out) == n;
+    }
+    success = !ferror(in) && success;
+    fclose(in);
+    success = fclose(out) == 0 && success;
+    if (!success) remove(dest);
+    return success;
+}
+
+// 单个资源的指纹任务
+typedef struct {
+    AssetEntry* entry;
+    const char* src_dir;
+    const char* dest_dir;
+    int failed;
+} FingerprintTask;
+
+// 确保带指纹的文件存在：内容寻址，已存在且大小一致即可跳过
+static int materialize_hashed(const char* src_dir, const char* dest_dir, const AssetEntry* entry) {
+    char hashed_full[2100];
+    snprintf(hashed_full, sizeof(hashed_full), "%s/%s", dest_dir, entry->hashed_path);
+
+    struct stat st;
+    if (stat(hashed_full, &st) == 0 && (long long)st.st_size == entry->size) return 1;
+    remove(hashed_full);
+
+#ifndef _WIN32
+    // 优先链接到已同步的普通副本，不占额外空间
+    char plain_full[2100];
+    snprintf(plain_full, sizeof(plain_full), "%s/%s", dest_dir, entry->path);
+    if (link(plain_full, hashed_full) == 0) return 1;
+#endif
+
+    char src_full[2100];
+    snprintf(src_full, sizeof(src_full), "%s/%s", src_dir, entry->path);
+    return copy_file_contents(src_full, hashed_full);
+}
+
+static void fingerprint_task(void* arg) {
+    FingerprintTask* task = (FingerprintTask*)arg;
+    AssetEntry* entry = task->entry;
+
+    char src_full[2100];
+    snprintf(src_full, sizeof(src_full), "%s/%s", task->src_dir, entry->path);
+
+    uint64_t hash;
+    if (!hash_file(src_full, &hash)) {
+        task->failed = 1;
+        return;
+    }
+
+    entry->hashed_path = build_hashed_path(entry->path, hash);
+    if (!entry->hashed_path || !materialize_hashed(task->src_dir, task->dest_dir, entry)) {
+        task->failed = 1;
+    }
+}
+
+int fingerprint_assets(GeneratorContext* ctx, const char* src_dir, const char* dest_dir) {
+    if (!ctx || !src_dir || !dest_dir) return 0;
+
+    char manifest_path[1024];
+    snprintf(manifest_path, sizeof(manifest_path), "%s/%s", ctx->output_dir, ASSET_MANIFEST_FILE);
+
+    AssetManifest previous = {0};
+    AssetManifest current = {0};
+    load_manifest(manifest_path, &previous);
+    collect_assets(src_dir, "", &current);
+
+    FingerprintTask* tasks = calloc(current.count + 1, sizeof(FingerprintTask));
+    if (!tasks) {
+        free_asset_manifest(&previous);
+        free_asset_manifest(&current);
+        ctx->last_error = GEN_ERROR_MEMORY;
+        return 0;
+    }
+
+    int reused = 0;
+    int hashed = 0;
+    for (int i = 0; i < current.count; i++) {
+        AssetEntry* entry = &current.entries[i];
+        AssetEntry key = { .path = entry->path };
+        AssetEntry* old = previous.count ?
+            bsearch(&key, previous.entries, previous.count, sizeof(AssetEntry), compare_assets) : NULL;
+
+        // 大小和修改时间都未变时沿用上次的指纹，无需重新读取文件
+        if (old && old->hashed_path && old->size == entry->size && old->mtime_ns == entry->mtime_ns) {
+            entry->hashed_path = strdup(old->hashed_path);
+            if (entry->hashed_path && materialize_hashed(src_dir, dest_dir, entry)) {
+                reused++;
+                continue;
+            }
+            free(entry->hashed_path);
+            entry->hashed_path = NULL;
+        }
+
+        tasks[i].entry = entry;
+        tasks[i].src_dir = src_dir;
+        tasks[i].dest_dir = dest_dir;
+        if (!worker_pool_submit(ctx->workers, fingerprint_task, &tasks[i])) {
+            fingerprint_task(&tasks[i]);
+        }
+        hashed++;
+    }
+    worker_pool_wait(ctx->workers);
+
+    int failed = 0;
+    for (int i = 0; i < current.count; i++) {
+        if (tasks[i].failed) {
+            log_error("Could not fingerprint asset %s", current.entries[i].path);
+            failed++;
+        }
+    }
+    free(tasks);
+
+    qsort(current.entries, current.count, sizeof(AssetEntry), compare_assets);
+    if (!save_manifest(manifest_path, &current)) {
+        log_warn("Could not save asset manifest %s", manifest_path);
+    }
+
+    free_asset_manifest(&previous);
+    free_asset_manifest(&ctx->assets);
+    ctx->assets = current;
+
+    log_info("Fingerprinted %d asset(s): %d hashed, %d unchanged, %d failed",
+           current.count, hashed, reused, failed);
+    if (failed) ctx->last_error = GEN_ERROR_IO;
+    return failed == 0;
+}
+
+// 样式表中的一条顶层规则
+typedef struct {
+    const char* text;
+    size_t length;
+} CssRule;
+
+// 按顶层的 "}" 或 ";" 把压缩后的CSS切分为规则
+static int split_css_rules(const char* css, size_t length, CssRule** rules_out) {
+    int count = 0;
+    int capacity = 0;
+    CssRule* rules = NULL;
+    size_t start = 0;
+    int depth = 0;
+
+    for (size_t i = 0; i < length; i++) {
+        char c = css[i];
+        if (c == '"' || c == '\'') {
+            while (++i < length && css[i] != c) {
+                if (css[i] == '\\') i++;
+            }
+            if (i + 1 < length) continue;
+        } else if (c == '{') {
+            depth++;
+            if (i + 1 < length) continue;
+        } else if (c == '}' && depth > 0) {
+            depth--;
+        } else if (c != ';' && i + 1 < length) {
+            continue;
+        }
+        // 规则在顶层结束，或到达末尾（收下未结束的剩余部分）
+        if (depth != 0 && i + 1 < length) continue;
+        if (i >= length) i = length - 1;
+
+        if (count == capacity) {
+            capacity = capacity ? capacity * 2 : 32;
+            CssRule* grown = realloc(rules, capacity * sizeof(CssRule));
+            if (!grown) {
+                free(rules);
+                return -1;
+            }
+            rules = grown;
+        }
+        rules[count].text = css + start;
+        rules[count].length = i + 1 - start;
+        count++;
+        start = i + 1;
+    }
+
+    *rules_out = rules;
+    return count;
+}
+
+// 规则的选择器中包含关键选择器之一时保留在页面内
+static int is_critical_rule(const CssRule* rule, const char* critical) {
+    if (!critical || !*critical) return 0;
+
+    const char* brace = memchr(rule->text, '{', rule->length);
+    if (!brace) return 0;
+
+    const char* selector = rule->text;
+    while (selector < brace) {
+        const char* end = selector;
+        while (end < brace && *end != ',') end++;
+
+        const char* item = critical;
+        while (*item) {
+            while (*item == ',' || *item == ' ') item++;
+            size_t item_len = strcspn(item, ",");
+            while (item_len > 0 && item[item_len - 1] == ' ') item_len--;
+            if (item_len > 0 && item_len == (size_t)(end - selector) &&
+                strncmp(item, selector, item_len) == 0) {
+                return 1;
+            }
+            item += item_len;
+            while (*item && *item != ',') item++;
+        }
+        selector = end + 1;
+    }
+    return 0;
+}
+
+// 查找下一个可提取的 <style> 块；带 media 属性或包含模板占位符的块保留原样
+static const char* find_style_block(const char* ptr, const char** css_start,
+                                    const char** css_end, const char** block_end) {
+    while ((ptr = strstr(ptr, "<style")) != NULL) {
+        const char* open_end = strchr(ptr, '>');
+        if (!open_end) return NULL;
+        const char* close = strstr(open_end, "</style>");
+        if (!close) return NULL;
+
+        int extractable = (ptr[6] == '>' || isspace((unsigned char)ptr[6]));
+        for (const char* p = ptr; extractable && p < open_end; p++) {
+            if (strncmp(p, "media", 5) == 0) extractable = 0;
+        }
+        for (const char* p = open_end; extractable && p < close; p++) {
+            if (p[0] == '{' && p[1] == '{') extractable = 0;
+        }
+
+        if (extractable) {
+            *css_start = open_end + 1;
+            *css_end = close;
+            *block_end = close + strlen("</style>");
+            return ptr;
+        }
+        ptr = close;
+    }
+    return NULL;
+}
+
+// 写出共享样式表；文件名由内容决定，已存在时无需重写
+static int write_stylesheet(const char* output_dir, const char* hashed_path,
+                            const char* css, size_t length) {
+    char full_path[2100];
+    snprintf(full_path, sizeof(full_path), "%s/assets/%s", output_dir, hashed_path);
+
+    struct stat st;
+    if (stat(full_path, &st) == 0 && (size_t)st.st_size == length) return 1;
+
+    char dir[2100];
+    snprintf(dir, sizeof(dir), "%s", full_path);
+    char* slash = strrchr(dir, '/');
+    if (slash) *slash = '\0';
+    mkdir_p(dir);
+
+    char tmp_path[2200];
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", full_path);
+    FILE* fp = fopen(tmp_path, "wb");
+    if (!fp) return 0;
+
+    int success = fwrite(css, 1, length, fp) == length;
+    success = fclose(fp) == 0 && success;
+    if (success) success = rename(tmp_path, full_path) == 0;
+    if (!success) remove(tmp_path);
+    return success;
+}
+
+static int append_text(char** buffer, size_t* length, size_t* capacity,
+                       const char* text, size_t text_len) {
+    if (*length + text_len + 1 > *capacity) {
+        size_t new_capacity = (*length + text_len + 1) * 2;
+        char* grown = mem_realloc(MEM_RENDER, *buffer, new_capacity);
+        if (!grown) return 0;
+        *buffer = grown;
+        *capacity = new_capacity;
+    }
+    memcpy(*buffer + *length, text, text_len);
+    *length += text_len;
+    (*buffer)[*length] = '\0';
+    return 1;
+}
+
+char* extract_template_styles(GeneratorContext* ctx, const char* template_content) {
+    if (!ctx || !template_content) return NULL;
+
+    // 第一遍：收集并压缩所有可提取的样式
+    size_t template_len = strlen(template_content);
+    char* css = malloc(template_len + 1);
+    if (!css) return NULL;
+
+    size_t css_len = 0;
+    int blocks = 0;
+    const char* ptr = template_content;
+    const char *css_start, *css_end, *block_end;
+    while ((ptr = find_style_block(ptr, &css_start, &css_end, &block_end)) != NULL) {
+        css_len += minify_css(css_start, css_end - css_start, css + css_len);
+        ptr = block_end;
+        blocks++;
+    }
+
+    if (blocks == 0) {
+        free(css);
+        return mem_strdup(MEM_RENDER, template_content);
+    }
+
+    // 去重：相同的规则只保留最后一次出现，不改变层叠顺序
+    CssRule* rules = NULL;
+    int rule_count = split_css_rules(css, css_len, &rules);
+    if (rule_count < 0) {
+        free(css);
+        return NULL;
+    }
+
+    char* shared = malloc(css_len + 1);
+    char* critical = malloc(css_len + 1);
+    if (!shared || !critical) {
+        free(shared);
+        free(critical);
+        free(rules);
+        free(css);
+        return NULL;
+    }
+
+    size_t shared_len = 0;
+    size_t critical_len = 0;
+    int duplicates = 0;
+    for (int i = 0; i < rule_count; i++) {
+        int repeated = 0;
+        for (int j = i + 1; j < rule_count && !repeated; j++) {
+            repeated = rules[j].length == rules[i].length &&
+                       memcmp(rules[j].text, rules[i].text, rules[i].length) == 0;
+        }
+        if (repeated) {
+            duplicates++;
+            continue;
+        }
+
+        if (is_critical_rule(&rules[i], ctx->config->critical_css)) {
+            memcpy(critical + critical_len, rules[i].text, rules[i].length);
+            critical_len += rules[i].length;
+        } else {
+            memcpy(shared + shared_len, rules[i].text, rules[i].length);
+            shared_len += rules[i].length;
+        }
+    }
+    free(rules);
+    free(css);
+
+    // 共享样式表以内容指纹命名，浏览器只需下载一次
+    char* stylesheet = NULL;
+    if (shared_len > 0) {
+        stylesheet = build_hashed_path("css/site.css", content_hash(shared, shared_len));
+        if (!stylesheet || !write_stylesheet(ctx->output_dir, stylesheet, shared, shared_len)) {
+            log_error("Could not write shared stylesheet");
+            free(stylesheet);
+            free(shared);
+            free(critical);
+            ctx->last_error = GEN_ERROR_IO;
+            return NULL;
+        }
+    }
+
+    // 第二遍：第一个样式块替换为关键样式和样式表链接，其余样式块连同所在行删除
+    char* result = NULL;
+    size_t result_len = 0;
+    size_t result_capacity = 0;
+    int ok = append_text(&result, &result_len, &result_capacity, "", 0);
+    int first = 1;
+    const char* literal = template_content;
+    ptr = template_content;
+
+    while (ok && (ptr = find_style_block(ptr, &css_start, &css_end, &block_end)) != NULL) {
+        const char* cut_start = ptr;
+        const char* cut_end = block_end;
+        if (!first) {
+            while (cut_start > literal && (cut_start[-1] == ' ' || cut_start[-1] == '\t')) cut_start--;
+            if (cut_start == template_content || cut_start[-1] == '\n') {
+                if (*cut_end == '\r') cut_end++;
+                if (*cut_end == '\n') cut_end++;
+            } else {
+                cut_start = ptr;
+            }
+        }
+        ok = append_text(&result, &result_len, &result_capacity, literal, cut_start - literal);
+
+        if (ok && first) {
+            if (critical_len > 0) {
+                ok = append_text(&result, &result_len, &result_capacity, "<style>", 7) &&
+                     append_text(&result, &result_len, &result_capacity, critical, critical_len) &&
+                     append_text(&result, &result_len, &result_capacity, "</style>", 8);
+            }
+            if (ok && stylesheet) {
+                char link[1200];
+                int link_len = snprintf(link, sizeof(link),
+                                        "<link rel=\"stylesheet\" href=\"assets/%s\">", stylesheet);
+                ok = append_text(&result, &result_len, &result_capacity, link, link_len);
+            }
+            first = 0;
+        }
+
+        literal = cut_end;
+        ptr = block_end;
+    }
+    if (ok) ok = append_text(&result, &result_len, &result_capacity, literal, strlen(literal));
+
+    if (ok) {
+        log_info("Extracted %d style block(s): %zu bytes shared%s%s, %zu bytes inline, %d duplicate rule(s)",
+               blocks, shared_len, stylesheet ? " as assets/" : "", stylesheet ? stylesheet : "",
+               critical_len, duplicates);
+    } else {
+        mem_free(MEM_RENDER, result);
+        result = NULL;
+        ctx->last_error = GEN_ERROR_MEMORY;
+    }
+
+    free(stylesheet);
+    free(shared);
+    free(critical);
+    return result;
+}
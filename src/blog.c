@@ -0,0 +1,233 @@
+#include "../include/blog.h"
+#include "../include/parser.h"
+#include "../include/generator.h"
+#include "../include/memstats.h"
+#include "../include/optimization.h"
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define BLOG_ERROR_SIZE 256
+
+struct BlogRenderer {
+    ParserContext* parser;    // 每次渲染前清空，内存池的最大块保留下来
+    LineIndex lines;          // 行索引的数组同样复用
+    char* output;             // *_arena 函数的结果
+    size_t output_capacity;
+    char error[BLOG_ERROR_SIZE];
+};
+
+struct BlogTemplate {
+    CompiledTemplate* compiled;
+};
+
+BlogRenderer* blog_renderer_create(void) {
+    BlogRenderer* renderer = mem_calloc(MEM_PARSER, 1, sizeof(BlogRenderer));
+    if (!renderer) return NULL;
+
+    renderer->parser = create_parser_context(NULL);
+    if (!renderer->parser) {
+        mem_free(MEM_PARSER, renderer);
+        return NULL;
+    }
+    return renderer;
+}
+
+void blog_renderer_destroy(BlogRenderer* renderer) {
+    if (!renderer) return;
+    destroy_parser_context(renderer->parser);
+    free_line_index(&renderer->lines);
+    mem_free(MEM_OUTPUT, renderer->output);
+    mem_free(MEM_PARSER, renderer);
+}
+
+#if defined(__GNUC__)
+__attribute__((format(printf, 3, 4)))
+#endif
+static BlogStatus fail(BlogRenderer* renderer, BlogStatus status, const char* fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    vsnprintf(renderer->error, sizeof(renderer->error), fmt, args);
+    va_end(args);
+    return status;
+}
+
+// 与构建时相同的路径：一遍完成 UTF-8 校验和行索引，再按行索引解析
+// 成功时 *html 为 get_html_output 的结果（文档为空时为 NULL）
+static BlogStatus render_html(BlogRenderer* renderer, const char* markdown, size_t length, char** html) {
+    *html = NULL;
+    renderer->error[0] = '\0';
+
+    size_t error_offset;
+    int scan = scan_utf8_lines(markdown, length, &renderer->lines, &error_offset);
+    if (scan == 0) {
+        size_t line = 1;
+        for (size_t i = 0; i < error_offset; i++) {
+            if (markdown[i] == '\n') line++;
+        }
+        return fail(renderer, BLOG_ERROR_ENCODING, "Invalid UTF-8 at line %zu (byte offset %zu)", line, error_offset);
+    }
+    if (scan < 0) return fail(renderer, BLOG_ERROR_MEMORY, "Out of memory while indexing lines");
+
+    reset_parser_context(renderer->parser);
+    if (!parse_markdown_indexed(renderer->parser, markdown, length, &renderer->lines)) {
+        if (cancel_requested(worker_pool_current_token())) {
+            return fail(renderer, BLOG_ERROR_TIMEOUT, "Rendering exceeded the time budget");
+        }
+        return fail(renderer, BLOG_ERROR_MEMORY, "Could not parse markdown content");
+    }
+    if (!renderer->parser->first_block) return BLOG_OK;
+
+    *html = get_html_output(renderer->parser);
+    if (!*html) return fail(renderer, BLOG_ERROR_MEMORY, "Could not render HTML");
+    return BLOG_OK;
+}
+
+// 复制到调用者的缓冲区；放不下时只报告需要的长度
+static BlogStatus copy_out(const char* data, size_t length, char* out, size_t capacity, size_t* out_length) {
+    if (out_length) *out_length = length;
+    if (!out || capacity < length + 1) return BLOG_ERROR_TOO_SMALL;
+    memcpy(out, data, length);
+    out[length] = '\0';
+    return BLOG_OK;
+}
+
+static BlogStatus copy_arena(BlogRenderer* renderer, const char* data, size_t length,
+                             const char** html, size_t* html_length) {
+    if (length + 1 > renderer->output_capacity) {
+        size_t capacity = renderer->output_capacity ? renderer->output_capacity : 4096;
+        while (capacity < length + 1) capacity *= 2;
+        char* output = mem_realloc(MEM_OUTPUT, renderer->output, capacity);
+        if (!output) return fail(renderer, BLOG_ERROR_MEMORY, "Could not grow the output buffer");
+        renderer->output = output;
+        renderer->output_capacity = capacity;
+    }
+    memcpy(renderer->output, data, length);
+    renderer->output[length] = '\0';
+    *html = renderer->output;
+    if (html_length) *html_length = length;
+    return BLOG_OK;
+}
+
+BlogStatus blog_render_markdown(BlogRenderer* renderer, const char* markdown, size_t length,
+                                char* out, size_t capacity, size_t* out_length) {
+    if (!renderer || (!markdown && length)) return BLOG_ERROR_INVALID;
+
+    char* html;
+    BlogStatus status = render_html(renderer, markdown ? markdown : "", length, &html);
+    if (status == BLOG_OK) status = copy_out(html ? html : "", html ? strlen(html) : 0, out, capacity, out_length);
+    mem_free(MEM_RENDER, html);
+    return status;
+}
+
+BlogStatus blog_render_markdown_arena(BlogRenderer* renderer, const char* markdown, size_t length,
+                                      const char** html, size_t* html_length) {
+    if (!renderer || !html || (!markdown && length)) return BLOG_ERROR_INVALID;
+
+    char* fragment;
+    BlogStatus status = render_html(renderer, markdown ? markdown : "", length, &fragment);
+    if (status == BLOG_OK) {
+        status = copy_arena(renderer, fragment ? fragment : "", fragment ? strlen(fragment) : 0, html, html_length);
+    }
+    mem_free(MEM_RENDER, fragment);
+    return status;
+}
+
+BlogTemplate* blog_template_compile(const char* source, size_t length) {
+    if (!source) return NULL;
+
+    // 模板编译需要以 '\0' 结尾的文本
+    char* text = malloc(length + 1);
+    if (!text) return NULL;
+    memcpy(text, source, length);
+    text[length] = '\0';
+
+    BlogTemplate* tpl = malloc(sizeof(BlogTemplate));
+    if (tpl) {
+        tpl->compiled = compile_template(text);
+        if (!tpl->compiled) {
+            free(tpl);
+            tpl = NULL;
+        }
+    }
+    free(text);
+    return tpl;
+}
+
+void blog_template_destroy(BlogTemplate* tpl) {
+    if (!tpl) return;
+    destroy_template(tpl->compiled);
+    free(tpl);
+}
+
+// 渲染整页，结果由 render_template 分配（MEM_OUTPUT）
+static BlogStatus render_page(BlogRenderer* renderer, const BlogTemplate* tpl, const char* markdown,
+                              size_t length, const BlogMetadata* metadata, char** page) {
+    *page = NULL;
+    char* html;
+    BlogStatus status = render_html(renderer, markdown ? markdown : "", length, &html);
+    if (status != BLOG_OK) return status;
+
+    PostMetadata* extracted = NULL;
+    PostMetadata fields = {0};
+    if (metadata) {
+        // render_template 只读取这些字段
+        fields.title = (char*)metadata->title;
+        fields.date = (char*)metadata->date;
+        fields.author = (char*)metadata->author;
+        fields.description = (char*)metadata->description;
+    } else {
+        extracted = extract_post_metadata_span(markdown ? markdown : "", length);
+        if (!extracted) {
+            mem_free(MEM_RENDER, html);
+            return fail(renderer, BLOG_ERROR_MEMORY, "Could not extract metadata");
+        }
+    }
+
+    *page = render_template(tpl->compiled, html ? html : "", extracted ? extracted : &fields);
+    free_post_metadata(extracted);
+    mem_free(MEM_RENDER, html);
+    if (!*page) return fail(renderer, BLOG_ERROR_MEMORY, "Could not apply template");
+    return BLOG_OK;
+}
+
+BlogStatus blog_render_page(BlogRenderer* renderer, const BlogTemplate* tpl,
+                            const char* markdown, size_t length, const BlogMetadata* metadata,
+                            char* out, size_t capacity, size_t* out_length) {
+    if (!renderer || !tpl || (!markdown && length)) return BLOG_ERROR_INVALID;
+
+    char* page;
+    BlogStatus status = render_page(renderer, tpl, markdown, length, metadata, &page);
+    if (status == BLOG_OK) status = copy_out(page, strlen(page), out, capacity, out_length);
+    mem_free(MEM_OUTPUT, page);
+    return status;
+}
+
+BlogStatus blog_render_page_arena(BlogRenderer* renderer, const BlogTemplate* tpl,
+                                  const char* markdown, size_t length, const BlogMetadata* metadata,
+                                  const char** html, size_t* html_length) {
+    if (!renderer || !tpl || !html || (!markdown && length)) return BLOG_ERROR_INVALID;
+
+    char* page;
+    BlogStatus status = render_page(renderer, tpl, markdown, length, metadata, &page);
+    if (status == BLOG_OK) status = copy_arena(renderer, page, strlen(page), html, html_length);
+    mem_free(MEM_OUTPUT, page);
+    return status;
+}
+
+const char* blog_renderer_error(const BlogRenderer* renderer) {
+    return renderer ? renderer->error : "";
+}
+
+const char* blog_status_message(BlogStatus status) {
+    switch (status) {
+        case BLOG_OK: return "Success";
+        case BLOG_ERROR_INVALID: return "Invalid argument";
+        case BLOG_ERROR_MEMORY: return "Memory allocation failed";
+        case BLOG_ERROR_ENCODING: return "Invalid UTF-8 input";
+        case BLOG_ERROR_TOO_SMALL: return "Output buffer too small";
+        case BLOG_ERROR_TIMEOUT: return "Time budget exceeded";
+        default: return "Unknown error";
+    }
+}
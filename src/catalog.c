@@ -0,0 +1,344 @@
+#include "../include/catalog.h"
+#include "../include/writer.h"
+#include "../include/memstats.h"
+#include "../include/utils.h"
+#include <sys/stat.h>
+
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#define CACHE_NO_STRING 0xFFFFFFFFu
+
+// 文件布局：CacheHeader，entry_count 个 CacheRecord，tag_count 个 uint32 标签偏移，字符串表
+// 所有字符串以 '\0' 结尾，用相对字符串表的偏移引用；相同的字符串（如标签）只存一份
+typedef struct {
+    char magic[4];
+    uint32_t version;
+    uint32_t entry_count;
+    uint32_t tag_count;
+    uint64_t render_key;
+    uint64_t strings_size;
+} CacheHeader;
+
+typedef struct {
+    uint32_t source_path;
+    uint32_t output_name;
+    uint32_t title;
+    uint32_t date;
+    uint32_t author;
+    uint32_t description;
+    uint32_t permalink;
+    uint32_t tag_start;
+    uint32_t tag_count;
+    uint32_t reserved;
+    int64_t size;
+    int64_t mtime_ns;
+} CacheRecord;
+
+static const char cache_magic[4] = {'B', 'C', 'A', 'T'};
+
+int catalog_cache_owns(const CatalogCache* cache, const void* ptr) {
+    const char* p = (const char*)ptr;
+    if (!cache || !p) return 0;
+
+    if (cache->map && p >= (const char*)cache->map && p < (const char*)cache->map + cache->map_length) {
+        return 1;
+    }
+    return cache->metadata && p >= (const char*)cache->metadata &&
+           p < (const char*)(cache->metadata + cache->count);
+}
+
+void close_catalog_cache(CatalogCache* cache) {
+    if (!cache) return;
+
+#ifndef _WIN32
+    if (cache->map) munmap(cache->map, cache->map_length);
+#else
+    free(cache->map);
+#endif
+    mem_free(MEM_CATALOG, cache->metadata);
+    mem_free(MEM_CATALOG, cache->tags);
+    memset(cache, 0, sizeof(CatalogCache));
+}
+
+static void cache_path(const GeneratorContext* ctx, char* path, size_t size) {
+    snprintf(path, size, "%s/%s", ctx->output_dir, CATALOG_CACHE_FILE);
+}
+
+// 把整个缓存文件映射为只读内存；Windows 上读入缓冲区
+static void* map_file(const char* path, size_t* length) {
+#ifndef _WIN32
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return NULL;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(CacheHeader)) {
+        close(fd);
+        return NULL;
+    }
+
+    void* map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) return NULL;
+
+    *length = (size_t)st.st_size;
+    return map;
+#else
+    FILE* fp = fopen(path, "rb");
+    if (!fp) return NULL;
+
+    fseek(fp, 0, SEEK_END);
+    long size = ftell(fp);
+    rewind(fp);
+
+    char* data = size >= (long)sizeof(CacheHeader) ? malloc(size) : NULL;
+    if (data && fread(data, 1, size, fp) != (size_t)size) {
+        free(data);
+        data = NULL;
+    }
+    fclose(fp);
+
+    *length = data ? (size_t)size : 0;
+    return data;
+#endif
+}
+
+// 校验字符串偏移并返回指针；字符串表以 '\0' 结尾，保证每个字符串都有终止符
+static int resolve_string(const char* strings, uint64_t strings_size, uint32_t offset,
+                          int optional, char** out) {
+    if (offset == CACHE_NO_STRING) {
+        *out = NULL;
+        return optional;
+    }
+    if (offset >= strings_size) return 0;
+
+    *out = (char*)(strings + offset);
+    return 1;
+}
+
+int load_catalog_cache(GeneratorContext* ctx) {
+    if (!ctx || ctx->catalog.count > 0) return 0;
+
+    char path[1024];
+    cache_path(ctx, path, sizeof(path));
+
+    CatalogCache* cache = &ctx->catalog_cache;
+    size_t length = 0;
+    void* map = map_file(path, &length);
+    if (!map) return 0;
+
+    const CacheHeader* header = (const CacheHeader*)map;
+    uint64_t records_size = (uint64_t)header->entry_count * sizeof(CacheRecord);
+    uint64_t tags_size = (uint64_t)header->tag_count * sizeof(uint32_t);
+
+    // 头部的长度字段不可信：每一部分先单独与文件长度比较，求和才不会回绕
+    int sized = header->strings_size > 0 && header->strings_size <= length &&
+                records_size <= length && tags_size <= length &&
+                sizeof(CacheHeader) + records_size + tags_size + header->strings_size == length;
+    const char* strings = (const char*)map + sizeof(CacheHeader);
+    if (sized) strings += records_size + tags_size;
+    if (memcmp(header->magic, cache_magic, sizeof(cache_magic)) != 0 ||
+        header->version != CATALOG_CACHE_VERSION || !sized ||
+        strings[header->strings_size - 1] != '\0') {
+        log_warn("Ignoring invalid catalog cache %s", path);
+        cache->map = map;
+        cache->map_length = length;
+        close_catalog_cache(cache);
+        return 0;
+    }
+
+    const CacheRecord* records = (const CacheRecord*)((const char*)map + sizeof(CacheHeader));
+    const uint32_t* tag_offsets = (const uint32_t*)((const char*)(records + header->entry_count));
+    int count = (int)header->entry_count;
+
+    cache->map = map;
+    cache->map_length = length;
+    cache->render_key = header->render_key;
+    cache->metadata = mem_calloc(MEM_CATALOG, count + 1, sizeof(PostMetadata));
+    cache->tags = mem_malloc(MEM_CATALOG, (header->tag_count + 1) * sizeof(char*));
+    ctx->catalog.entries = mem_malloc(MEM_CATALOG, (count + 1) * sizeof(CatalogEntry));
+    if (!cache->metadata || !cache->tags || !ctx->catalog.entries) {
+        mem_free(MEM_CATALOG, ctx->catalog.entries);
+        ctx->catalog.entries = NULL;
+        close_catalog_cache(cache);
+        return 0;
+    }
+    cache->count = count;
+    ctx->catalog.capacity = count + 1;
+
+    int valid = 1;
+    for (uint32_t i = 0; valid && i < header->tag_count; i++) {
+        valid = resolve_string(strings, header->strings_size, tag_offsets[i], 0, &cache->tags[i]);
+    }
+
+    for (int i = 0; valid && i < count; i++) {
+        const CacheRecord* record = &records[i];
+        PostMetadata* metadata = &cache->metadata[i];
+        CatalogEntry* entry = &ctx->catalog.entries[i];
+
+        valid = resolve_string(strings, header->strings_size, record->source_path, 0, &entry->source_path) &&
+                resolve_string(strings, header->strings_size, record->output_name, 0, &entry->output_name) &&
+                resolve_string(strings, header->strings_size, record->title, 1, &metadata->title) &&
+                resolve_string(strings, header->strings_size, record->date, 1, &metadata->date) &&
+                resolve_string(strings, header->strings_size, record->author, 1, &metadata->author) &&
+                resolve_string(strings, header->strings_size, record->description, 1, &metadata->description) &&
+                resolve_string(strings, header->strings_size, record->permalink, 1, &metadata->permalink) &&
+                (uint64_t)record->tag_start + record->tag_count <= header->tag_count;
+        if (!valid) break;
+
+        metadata->tags = record->tag_count ? &cache->tags[record->tag_start] : NULL;
+        metadata->tag_count = (int)record->tag_count;
+        entry->metadata = metadata;
+        entry->size = record->size;
+        entry->mtime_ns = record->mtime_ns;
+    }
+
+    if (!valid) {
+        log_warn("Ignoring corrupt catalog cache %s", path);
+        mem_free(MEM_CATALOG, ctx->catalog.entries);
+        memset(&ctx->catalog, 0, sizeof(PostCatalog));
+        close_catalog_cache(cache);
+        return 0;
+    }
+
+    ctx->catalog.count = count;
+    rebuild_catalog_index(&ctx->catalog);
+    log_info("Loaded %d post(s) from catalog cache", count);
+    return 1;
+}
+
+// 保存时使用的字符串表：开放寻址去重，标签和作者等重复的字符串只写一次
+typedef struct {
+    OutputBuffer data;
+    uint32_t* slots;          // 偏移+1，0 为空
+    size_t slot_count;
+    size_t used;
+} StringTable;
+
+static int string_table_init(StringTable* table, size_t expected) {
+    output_init(&table->data);
+    table->slot_count = 256;
+    while (table->slot_count < expected * 2) table->slot_count *= 2;
+    table->slots = calloc(table->slot_count, sizeof(uint32_t));
+    table->used = 0;
+    return table->slots != NULL;
+}
+
+static void string_table_free(StringTable* table) {
+    output_free(&table->data);
+    free(table->slots);
+}
+
+static int string_table_grow(StringTable* table) {
+    size_t new_count = table->slot_count * 2;
+    uint32_t* slots = calloc(new_count, sizeof(uint32_t));
+    if (!slots) return 0;
+
+    for (size_t i = 0; i < table->slot_count; i++) {
+        if (!table->slots[i]) continue;
+        const char* str = table->data.data + table->slots[i] - 1;
+        size_t slot = content_hash(str, strlen(str)) & (new_count - 1);
+        while (slots[slot]) slot = (slot + 1) & (new_count - 1);
+        slots[slot] = table->slots[i];
+    }
+    free(table->slots);
+    table->slots = slots;
+    table->slot_count = new_count;
+    return 1;
+}
+
+static uint32_t string_table_add(StringTable* table, const char* str) {
+    if (!str) return CACHE_NO_STRING;
+    if (table->used * 2 >= table->slot_count && !string_table_grow(table)) {
+        table->data.failed = 1;
+        return CACHE_NO_STRING;
+    }
+
+    size_t length = strlen(str);
+    size_t slot = content_hash(str, length) & (table->slot_count - 1);
+    while (table->slots[slot]) {
+        const char* existing = table->data.data + table->slots[slot] - 1;
+        if (strcmp(existing, str) == 0) return table->slots[slot] - 1;
+        slot = (slot + 1) & (table->slot_count - 1);
+    }
+
+    uint32_t offset = (uint32_t)table->data.length;
+    output_append(&table->data, str, length + 1);
+    table->slots[slot] = offset + 1;
+    table->used++;
+    return offset;
+}
+
+int save_catalog_cache(GeneratorContext* ctx) {
+    if (!ctx) return 0;
+
+    PostCatalog* catalog = &ctx->catalog;
+    uint32_t tag_total = 0;
+    for (int i = 0; i < catalog->count; i++) {
+        if (catalog->entries[i].metadata) tag_total += catalog->entries[i].metadata->tag_count;
+    }
+
+    CacheRecord* records = calloc(catalog->count + 1, sizeof(CacheRecord));
+    uint32_t* tag_offsets = malloc((tag_total + 1) * sizeof(uint32_t));
+    StringTable strings;
+    int success = records && tag_offsets && string_table_init(&strings, catalog->count * 4);
+    if (!success) {
+        free(records);
+        free(tag_offsets);
+        return 0;
+    }
+
+    uint32_t tag_index = 0;
+    for (int i = 0; i < catalog->count; i++) {
+        const CatalogEntry* entry = &catalog->entries[i];
+        const PostMetadata* metadata = entry->metadata;
+        CacheRecord* record = &records[i];
+
+        record->source_path = string_table_add(&strings, entry->source_path);
+        record->output_name = string_table_add(&strings, entry->output_name);
+        record->title = string_table_add(&strings, metadata ? metadata->title : NULL);
+        record->date = string_table_add(&strings, metadata ? metadata->date : NULL);
+        record->author = string_table_add(&strings, metadata ? metadata->author : NULL);
+        record->description = string_table_add(&strings, metadata ? metadata->description : NULL);
+        record->permalink = string_table_add(&strings, metadata ? metadata->permalink : NULL);
+        record->tag_start = tag_index;
+        record->tag_count = metadata ? (uint32_t)metadata->tag_count : 0;
+        for (uint32_t t = 0; t < record->tag_count; t++) {
+            tag_offsets[tag_index++] = string_table_add(&strings, metadata->tags[t]);
+        }
+        record->size = entry->size;
+        record->mtime_ns = entry->mtime_ns;
+    }
+    if (strings.data.length == 0) output_putc(&strings.data, '\0');
+
+    CacheHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, cache_magic, sizeof(cache_magic));
+    header.version = CATALOG_CACHE_VERSION;
+    header.entry_count = (uint32_t)catalog->count;
+    header.tag_count = tag_total;
+    header.render_key = ctx->catalog_cache.render_key;
+    header.strings_size = strings.data.length;
+
+    OutputBuffer out;
+    output_init(&out);
+    output_append(&out, (const char*)&header, sizeof(header));
+    output_append(&out, (const char*)records, catalog->count * sizeof(CacheRecord));
+    output_append(&out, (const char*)tag_offsets, tag_total * sizeof(uint32_t));
+    output_append(&out, strings.data.data, strings.data.length);
+
+    char path[1024];
+    cache_path(ctx, path, sizeof(path));
+    success = !strings.data.failed && !out.failed &&
+              write_output_file(path, out.data, out.length, NULL) != WRITE_FAILED;
+    if (!success) log_warn("Could not save catalog cache %s", path);
+
+    output_free(&out);
+    string_table_free(&strings);
+    free(records);
+    free(tag_offsets);
+    return success;
+}
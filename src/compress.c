@@ -0,0 +1,344 @@
+#include "../include/compress.h"
+#include "../include/optimization.h"
+#include "../include/profile.h"
+#include "../include/utils.h"
+#include <sys/stat.h>
+#include <errno.h>
+#include <dirent.h>
+
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+#ifndef _WIN32
+#include <unistd.h>
+#include <fcntl.h>
+#endif
+
+// 写入 gzip 头注释字段的内容哈希标记
+#define HASH_COMMENT_PREFIX "blog-generator:"
+
+// 单个压缩任务
+typedef struct {
+    char* path;
+    CompressResult result;
+} CompressTask;
+
+// 路径从上下文的内存池分配，保留到上下文销毁：性能分析记录直接引用这些路径
+typedef struct {
+    CompressTask* tasks;
+    int count;
+    int capacity;
+    MemPool* paths;
+} CompressList;
+
+static int is_compressible(const char* name) {
+    static const char* exts[] = {".html", ".xml", ".css", ".js"};
+    size_t len = strlen(name);
+
+    for (size_t i = 0; i < sizeof(exts)/sizeof(exts[0]); i++) {
+        size_t ext_len = strlen(exts[i]);
+        if (len > ext_len && strcmp(name + len - ext_len, exts[i]) == 0) return 1;
+    }
+    return 0;
+}
+
+// 使 .gz 的修改时间与原文件一致，预览服务器据此判断压缩版本是否过期
+static void sync_mtime(const char* input_path, const char* gz_path) {
+#ifndef _WIN32
+    struct stat st;
+    if (stat(input_path, &st) == 0) {
+        struct timespec times[2] = { st.st_atim, st.st_mtim };
+        utimensat(AT_FDCWD, gz_path, times, 0);
+    }
+#else
+    (void)input_path;
+    (void)gz_path;
+#endif
+}
+
+#ifdef HAVE_ZLIB
+
+static char* read_file(const char* path, size_t* size_out) {
+    FILE* fp = fopen(path, "rb");
+    if (!fp) return NULL;
+
+    fseek(fp, 0, SEEK_END);
+    long size = ftell(fp);
+    rewind(fp);
+    if (size < 0) {
+        fclose(fp);
+        return NULL;
+    }
+
+    char* data = mem_malloc(MEM_OUTPUT, size ? size : 1);
+    if (data && fread(data, 1, size, fp) != (size_t)size) {
+        mem_free(MEM_OUTPUT, data);
+        data = NULL;
+    }
+    fclose(fp);
+
+    *size_out = size;
+    return data;
+}
+
+// 读取已有 .gz 文件头中的注释字段
+static int read_gzip_comment(const char* gz_path, char* comment, size_t size) {
+    unsigned char header[512];
+    FILE* fp = fopen(gz_path, "rb");
+    if (!fp) return 0;
+
+    size_t len = fread(header, 1, sizeof(header), fp);
+    fclose(fp);
+    if (len < 10 || header[0] != 0x1f || header[1] != 0x8b || header[2] != 8) return 0;
+
+    int flags = header[3];
+    size_t pos = 10;
+    if (flags & 0x04) {                 // FEXTRA
+        if (pos + 2 > len) return 0;
+        pos += 2 + (header[pos] | (header[pos + 1] << 8));
+    }
+    if (flags & 0x08) {                 // FNAME
+        while (pos < len && header[pos]) pos++;
+        pos++;
+    }
+    if (!(flags & 0x10) || pos >= len) return 0;  // FCOMMENT
+
+    size_t j = 0;
+    while (pos < len && header[pos] && j + 1 < size) {
+        comment[j++] = (char)header[pos++];
+    }
+    comment[j] = '\0';
+    return pos < len && header[pos] == '\0';
+}
+
+static int write_gzip(const char* gz_path, const char* data, size_t size, const char* comment) {
+    char tmp_path[1100];
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", gz_path);
+
+    z_stream stream;
+    memset(&stream, 0, sizeof(stream));
+    if (deflateInit2(&stream, Z_BEST_COMPRESSION, Z_DEFLATED, 15 + 16, 9, Z_DEFAULT_STRATEGY) != Z_OK) {
+        return 0;
+    }
+
+    gz_header header;
+    memset(&header, 0, sizeof(header));
+    header.comment = (Bytef*)comment;
+    header.os = 3;  // Unix
+    deflateSetHeader(&stream, &header);
+
+    uLong bound = deflateBound(&stream, size) + strlen(comment) + 1;
+    unsigned char* out = mem_malloc(MEM_OUTPUT, bound);
+    if (!out) {
+        deflateEnd(&stream);
+        return 0;
+    }
+
+    stream.next_in = (Bytef*)data;
+    stream.avail_in = (uInt)size;
+    stream.next_out = out;
+    stream.avail_out = (uInt)bound;
+    int status = deflate(&stream, Z_FINISH);
+    size_t out_len = stream.total_out;
+    deflateEnd(&stream);
+
+    int success = 0;
+    if (status == Z_STREAM_END) {
+        FILE* fp = fopen(tmp_path, "wb");
+        if (fp) {
+            success = fwrite(out, 1, out_len, fp) == out_len;
+            success = fclose(fp) == 0 && success;
+            if (success) {
+                success = rename(tmp_path, gz_path) == 0;
+            }
+            if (!success) remove(tmp_path);
+        }
+    }
+
+    mem_free(MEM_OUTPUT, out);
+    return success;
+}
+
+CompressResult compress_file_if_changed(const char* input_path, const char* output_path) {
+    char gz_path[1024];
+    snprintf(gz_path, sizeof(gz_path), "%s.gz", output_path);
+
+    size_t size = 0;
+    char* data = read_file(input_path, &size);
+    if (!data) return COMPRESS_FAILED;
+
+    char comment[64];
+    snprintf(comment, sizeof(comment), HASH_COMMENT_PREFIX "%016llx",
+             (unsigned long long)content_hash(data, size));
+
+    char existing[64];
+    CompressResult result;
+    if (read_gzip_comment(gz_path, existing, sizeof(existing)) && strcmp(existing, comment) == 0) {
+        result = COMPRESS_UNCHANGED;
+    } else {
+        result = write_gzip(gz_path, data, size, comment) ? COMPRESS_WRITTEN : COMPRESS_FAILED;
+    }
+    mem_free(MEM_OUTPUT, data);
+
+    if (result != COMPRESS_FAILED) sync_mtime(input_path, gz_path);
+    return result;
+}
+
+#else
+
+// 没有 zlib 时退回调用系统命令
+CompressResult compress_file_if_changed(const char* input_path, const char* output_path) {
+    char cmd[512];
+#ifdef _WIN32
+    snprintf(cmd, sizeof(cmd), "powershell Compress-Archive -Path \"%s\" -DestinationPath \"%s.zip\"",
+             input_path, output_path);
+#else
+    snprintf(cmd, sizeof(cmd), "gzip -9 -c \"%s\" > \"%s.gz\"", input_path, output_path);
+#endif
+    if (system(cmd) != 0) return COMPRESS_FAILED;
+    snprintf(cmd, sizeof(cmd), "%s.gz", output_path);
+    sync_mtime(input_path, cmd);
+    return COMPRESS_WRITTEN;
+}
+
+#endif
+
+// 文件压缩函数
+int compress_file(const char* input_path, const char* output_path) {
+    return compress_file_if_changed(input_path, output_path) != COMPRESS_FAILED;
+}
+
+static int add_task(CompressList* list, const char* path) {
+    if (list->count == list->capacity) {
+        int new_capacity = list->capacity ? list->capacity * 2 : 256;
+        CompressTask* tasks = mem_realloc(MEM_OUTPUT, list->tasks, new_capacity * sizeof(CompressTask));
+        if (!tasks) return 0;
+        list->tasks = tasks;
+        list->capacity = new_capacity;
+    }
+
+    size_t length = strlen(path);
+    char* copy = pool_alloc(list->paths, length + 1);
+    if (!copy) return 0;
+    memcpy(copy, path, length + 1);
+    list->tasks[list->count].path = copy;
+    list->tasks[list->count].result = COMPRESS_FAILED;
+    list->count++;
+    return 1;
+}
+
+// 递归收集需要压缩的文件，同时删除原文件已不存在的 .gz
+static void collect_files(const char* dir_path, CompressList* list) {
+    DIR* dir = opendir(dir_path);
+    if (!dir) return;
+
+    struct dirent* entry;
+    while ((entry = readdir(dir)) != NULL) {
+        if (entry->d_name[0] == '.') continue;
+
+        char path[1024];
+        snprintf(path, sizeof(path), "%s/%s", dir_path, entry->d_name);
+
+        struct stat st;
+        if (stat(path, &st) != 0) continue;
+
+        if (S_ISDIR(st.st_mode)) {
+            collect_files(path, list);
+        } else if (is_compressible(entry->d_name)) {
+            add_task(list, path);
+        } else {
+            size_t len = strlen(path);
+            if (len > 3 && strcmp(path + len - 3, ".gz") == 0) {
+                path[len - 3] = '\0';
+                if (is_compressible(path) && stat(path, &st) != 0) {
+                    path[len - 3] = '.';
+                    remove(path);
+                }
+            }
+        }
+    }
+    closedir(dir);
+}
+
+static void compress_task(void* arg) {
+    CompressTask* task = (CompressTask*)arg;
+    ProfileSpan span = profile_begin(PROFILE_COMPRESS, task->path);
+    task->result = compress_file_if_changed(task->path, task->path);
+    profile_end(&span);
+}
+
+// 统计压缩结果，返回失败的文件数
+static int report_results(const CompressTask* tasks, int count) {
+    int written = 0;
+    int unchanged = 0;
+    int failed = 0;
+    for (int i = 0; i < count; i++) {
+        switch (tasks[i].result) {
+            case COMPRESS_WRITTEN: written++; break;
+            case COMPRESS_UNCHANGED: unchanged++; break;
+            default:
+                log_error("Could not compress %s", tasks[i].path);
+                failed++;
+                break;
+        }
+    }
+    log_info("Compressed %d file(s), %d unchanged, %d failed", written, unchanged, failed);
+    return failed;
+}
+
+static void run_tasks(GeneratorContext* ctx, CompressTask* tasks, int count) {
+    for (int i = 0; i < count; i++) {
+        if (!worker_pool_submit(ctx->workers, compress_task, &tasks[i])) {
+            compress_task(&tasks[i]);
+        }
+    }
+    worker_pool_wait(ctx->workers);
+}
+
+static int compare_paths(const void* a, const void* b) {
+    return strcmp(*(char* const*)a, *(char* const*)b);
+}
+
+int compress_rewritten_outputs(GeneratorContext* ctx) {
+    if (!ctx || !ctx->rewritten.count) return 1;
+
+    CompressTask* tasks = mem_malloc(MEM_OUTPUT, ctx->rewritten.count * sizeof(CompressTask));
+    if (!tasks) {
+        clear_rewritten_outputs(ctx);
+        ctx->last_error = GEN_ERROR_MEMORY;
+        return 0;
+    }
+
+    // 同一页面可能在一次重建中写了多次（如标签页），排序后只压缩一次
+    qsort(ctx->rewritten.paths, ctx->rewritten.count, sizeof(char*), compare_paths);
+    int count = 0;
+    for (int i = 0; i < ctx->rewritten.count; i++) {
+        char* path = ctx->rewritten.paths[i];
+        if ((i > 0 && strcmp(path, ctx->rewritten.paths[i - 1]) == 0) || !is_compressible(path)) continue;
+        tasks[count].path = path;
+        tasks[count].result = COMPRESS_FAILED;
+        count++;
+    }
+
+    run_tasks(ctx, tasks, count);
+    int failed = report_results(tasks, count);
+    mem_free(MEM_OUTPUT, tasks);
+    clear_rewritten_outputs(ctx);
+    if (failed) ctx->last_error = GEN_ERROR_IO;
+    return failed == 0;
+}
+
+int compress_site(GeneratorContext* ctx) {
+    if (!ctx || !ctx->output_dir) return 0;
+
+    CompressList list = {0};
+    list.paths = ctx->pool;
+    collect_files(ctx->output_dir, &list);
+
+    run_tasks(ctx, list.tasks, list.count);
+    int failed = report_results(list.tasks, list.count);
+    mem_free(MEM_OUTPUT, list.tasks);
+    if (failed) ctx->last_error = GEN_ERROR_IO;
+    return failed == 0;
+}
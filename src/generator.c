@@ -1,7 +1,19 @@
 #include "../include/generator.h"
+#include "../include/assets.h"
+#include "../include/minify.h"
+#include "../include/writer.h"
+#include "../include/source.h"
+#include "../include/scan.h"
+#include "../include/profile.h"
+#include "../include/memstats.h"
+#include "../include/catalog.h"
+#include "../include/utils.h"
+#include <stdatomic.h>
 #include <sys/stat.h>
 #include <time.h>
 #include <ctype.h>
+#include <errno.h>
+#include <stdarg.h>
 
 #ifdef _WIN32
 #include <direct.h>
@@ -19,25 +31,12 @@
 #endif
 
 // 函数声明
-static int process_single_post(GeneratorContext* ctx, const char* post_path);
-static char* read_utf8_file(const char* path, size_t* size_out);
-
-// ļǷ
-static int file_exists(const char* path) {
-    return access(path, F_OK) == 0;
-}
-
-// ��������������Ƿ���Markdown�ļ�
-static int is_markdown_file(const char* filename) {
-    const char* ext = strrchr(filename, '.');
-    return ext && strcmp(ext, ".md") == 0;
-}
 
 // ��������������·��
 static char* join_path(const char* dir, const char* file) {
     size_t dir_len = strlen(dir);
     size_t file_len = strlen(file);
-    char* path = malloc(dir_len + file_len + 2);
+    char* path = mem_malloc(MEM_OUTPUT, dir_len + file_len + 2);
     
     if (path) {
         strcpy(path, dir);
@@ -52,20 +51,73 @@ static char* join_path(const char* dir, const char* file) {
 }
 
 // �����������Ĳ���
+// 并行处理文章时，目录的查找和修改必须串行
+static void lock_catalog(GeneratorContext* ctx) {
+#ifndef _WIN32
+    pthread_mutex_lock(&ctx->catalog_lock);
+#else
+    (void)ctx;
+#endif
+}
+
+static void unlock_catalog(GeneratorContext* ctx) {
+#ifndef _WIN32
+    pthread_mutex_unlock(&ctx->catalog_lock);
+#else
+    (void)ctx;
+#endif
+}
+
+// 当前线程正在处理的文章的诊断信息；并行处理时 ctx->last_error 会被其他线程覆盖
+static _Thread_local PostFailure* current_failure = NULL;
+
+// 当前线程正在渲染的文章路径，用于按文章记录各阶段耗时
+static _Thread_local const char* current_post = NULL;
+
+// 报告文章处理错误：输出错误信息，并记录到当前文章的诊断中（只保留最先出现、最具体的一条）
+static void post_error(GeneratorContext* ctx, GeneratorError error, const char* fmt, ...) {
+    int saved_errno = errno;
+    char message[sizeof(((PostFailure*)0)->message)];
+    
+    va_list args;
+    va_start(args, fmt);
+    vsnprintf(message, sizeof(message), fmt, args);
+    va_end(args);
+    
+    log_error("%s", message);
+    ctx->last_error = error;
+    if (current_failure && !current_failure->message[0]) {
+        current_failure->error = error;
+        current_failure->sys_errno = saved_errno;
+        memcpy(current_failure->message, message, sizeof(message));
+    }
+}
+
+// 在阶段边界检查当前任务是否超出时间预算或已被取消；是则记录诊断并返回 1
+static int post_cancelled(GeneratorContext* ctx, const char* stage) {
+    CancelToken* token = worker_pool_current_token();
+    if (!cancel_requested(token)) return 0;
+    
+    post_error(ctx, GEN_ERROR_TIMEOUT, "Exceeded time budget of %lld ms during %s", token->budget_ms, stage);
+    return 1;
+}
+
+static void batch_write_failed(void* user, const char* path);
+
 GeneratorContext* create_generator_context(const BlogConfig* config, const char* output_dir) {
-    GeneratorContext* ctx = (GeneratorContext*)malloc(sizeof(GeneratorContext));
+    GeneratorContext* ctx = mem_malloc(MEM_GENERAL, sizeof(GeneratorContext));
     if (!ctx) return NULL;
     
     ctx->pool = create_memory_pool(1024 * 1024);  // 1MB
     if (!ctx->pool) {
-        free(ctx);
+        mem_free(MEM_GENERAL, ctx);
         return NULL;
     }
     
     ctx->config = (BlogConfig*)pool_alloc(ctx->pool, sizeof(BlogConfig));
     if (!ctx->config) {
         destroy_memory_pool(ctx->pool);
-        free(ctx);
+        mem_free(MEM_GENERAL, ctx);
         return NULL;
     }
     
@@ -75,22 +127,102 @@ GeneratorContext* create_generator_context(const BlogConfig* config, const char*
     ctx->output_dir = (char*)pool_alloc(ctx->pool, dir_len + 1);
     if (!ctx->output_dir) {
         destroy_memory_pool(ctx->pool);
-        free(ctx);
+        mem_free(MEM_GENERAL, ctx);
         return NULL;
     }
     strcpy(ctx->output_dir, output_dir);
     
     ctx->template_dir = NULL;
-    ctx->start_time = time(NULL);
     ctx->last_error = GEN_SUCCESS;
     
+    memset(&ctx->catalog, 0, sizeof(ctx->catalog));
+    memset(&ctx->tag_index, 0, sizeof(ctx->tag_index));
+    memset(&ctx->assets, 0, sizeof(ctx->assets));
+    memset(&ctx->writes, 0, sizeof(ctx->writes));
+    memset(&ctx->catalog_cache, 0, sizeof(ctx->catalog_cache));
+    memset(&ctx->failures, 0, sizeof(ctx->failures));
+    memset(&ctx->output_names, 0, sizeof(ctx->output_names));
+    memset(&ctx->posts_scan, 0, sizeof(ctx->posts_scan));
+    memset(&ctx->rewritten, 0, sizeof(ctx->rewritten));
+    ctx->post_template = NULL;
+    ctx->catalog_changed = 0;
+#ifndef _WIN32
+    pthread_mutex_init(&ctx->catalog_lock, NULL);
+#endif
+    
+    ctx->workers = worker_pool_create(config->parallel_workers);
+    if (!ctx->workers) {
+        destroy_memory_pool(ctx->pool);
+        mem_free(MEM_GENERAL, ctx);
+        return NULL;
+    }
+    
+    // io_uring 不可用时（非 Linux、内核过旧或被沙箱禁止）回退到普通写出
+    ctx->output_batch = config->use_io_uring ? output_batch_create(&ctx->writes, batch_write_failed, ctx) : NULL;
+    if (config->use_io_uring && !ctx->output_batch) {
+        log_warn("io_uring is not available, using POSIX writes");
+    }
+    
     return ctx;
 }
 
+static void clear_tag_index(TagIndex* index) {
+    for (int i = 0; i < index->count; i++) {
+        mem_free(MEM_CATALOG, index->tags[i].name);
+        mem_free(MEM_CATALOG, index->tags[i].posts);
+    }
+    index->count = 0;
+}
+
+// 目录条目可能直接引用 mmap 的目录缓存，只释放自行分配的部分
+static void free_catalog_string(GeneratorContext* ctx, char* str) {
+    if (!catalog_cache_owns(&ctx->catalog_cache, str)) mem_free(MEM_CATALOG, str);
+}
+
+static void free_catalog_metadata(GeneratorContext* ctx, PostMetadata* metadata) {
+    if (!catalog_cache_owns(&ctx->catalog_cache, metadata)) free_post_metadata(metadata);
+}
+
+static void clear_output_names(OutputNames* names) {
+    for (int i = 0; i < names->slot_count; i++) {
+        mem_free(MEM_CATALOG, names->slots[i].name);
+        mem_free(MEM_CATALOG, names->slots[i].owner);
+    }
+    mem_free(MEM_CATALOG, names->slots);
+    memset(names, 0, sizeof(OutputNames));
+}
+
+static void release_catalog_entry(GeneratorContext* ctx, CatalogEntry* entry) {
+    free_catalog_string(ctx, entry->source_path);
+    free_catalog_string(ctx, entry->output_name);
+    free_catalog_metadata(ctx, entry->metadata);
+}
+
 void destroy_generator_context(GeneratorContext* ctx) {
     if (ctx) {
+        for (int i = 0; i < ctx->catalog.count; i++) {
+            release_catalog_entry(ctx, &ctx->catalog.entries[i]);
+        }
+        mem_free(MEM_CATALOG, ctx->catalog.entries);
+        mem_free(MEM_CATALOG, ctx->catalog.slots);
+        close_catalog_cache(&ctx->catalog_cache);
+        clear_post_failures(ctx);
+        mem_free(MEM_GENERAL, ctx->failures.items);
+        clear_output_names(&ctx->output_names);
+        free_scan_result(&ctx->posts_scan);
+        clear_rewritten_outputs(ctx);
+        mem_free(MEM_OUTPUT, ctx->rewritten.paths);
+        clear_tag_index(&ctx->tag_index);
+        mem_free(MEM_CATALOG, ctx->tag_index.tags);
+        destroy_template(ctx->post_template);
+        free_asset_manifest(&ctx->assets);
+        output_batch_destroy(ctx->output_batch);
+        worker_pool_destroy(ctx->workers);
+#ifndef _WIN32
+        pthread_mutex_destroy(&ctx->catalog_lock);
+#endif
         destroy_memory_pool(ctx->pool);
-        free(ctx);
+        mem_free(MEM_GENERAL, ctx);
     }
 }
 
@@ -109,16 +241,62 @@ void create_directory_structure(const char* base_dir) {
         char* path = join_path(base_dir, dirs[i]);
         if (path) {
             MKDIR(path);
-            free(path);
+            mem_free(MEM_OUTPUT, path);
+        }
+    }
+}
+
+// 复制指定长度的字符串
+static char* copy_string(MemSubsystem subsystem, const char* str, size_t len) {
+    char* copy = mem_malloc(subsystem, len + 1);
+    if (copy) {
+        memcpy(copy, str, len);
+        copy[len] = '\0';
+    }
+    return copy;
+}
+
+// 解析标签列表，支持 [a, b, c] 和 a, b, c 两种写法
+static void parse_tag_list(PostMetadata* metadata, const char* value) {
+    const char* p = value;
+    if (*p == '[') p++;
+    
+    while (*p) {
+        while (*p == ',' || isspace((unsigned char)*p)) p++;
+        if (!*p || *p == ']') break;
+        
+        const char* start = p;
+        while (*p && *p != ',' && *p != ']') p++;
+        const char* end = p;
+        while (end > start && isspace((unsigned char)end[-1])) end--;
+        
+        // 去掉引号
+        if (end - start >= 2 && (*start == '"' || *start == '\'') && end[-1] == *start) {
+            start++;
+            end--;
         }
+        if (end == start) continue;
+        
+        char** tags = mem_realloc(MEM_CATALOG, metadata->tags, (metadata->tag_count + 1) * sizeof(char*));
+        if (!tags) return;
+        metadata->tags = tags;
+        
+        tags[metadata->tag_count] = copy_string(MEM_CATALOG, start, end - start);
+        if (tags[metadata->tag_count]) metadata->tag_count++;
     }
 }
 
 // ��ȡ����Ԫ����
 PostMetadata* extract_post_metadata(const char* markdown_content) {
     if (!markdown_content) return NULL;
+    return extract_post_metadata_span(markdown_content, strlen(markdown_content));
+}
+
+// 从长度确定的文本中提取元数据，内容无需以 '\0' 结尾
+PostMetadata* extract_post_metadata_span(const char* markdown_content, size_t length) {
+    if (!markdown_content) return NULL;
     
-    PostMetadata* metadata = malloc(sizeof(PostMetadata));
+    PostMetadata* metadata = mem_malloc(MEM_CATALOG, sizeof(PostMetadata));
     if (!metadata) return NULL;
     
     // Initialize default values
@@ -131,22 +309,23 @@ PostMetadata* extract_post_metadata(const char* markdown_content) {
     metadata->permalink = NULL;
     
     // Check for YAML front matter
-    if (strncmp(markdown_content, "---\n", 4) != 0) {
+    if (length < 4 || strncmp(markdown_content, "---\n", 4) != 0) {
         return metadata;
     }
     
     const char* ptr = markdown_content + 4;
+    const char* end = markdown_content + length;
     char line[1024];
     int in_metadata = 1;
     
-    while (*ptr && in_metadata) {
+    while (ptr < end && in_metadata) {
         // Read line
-        const char* eol = strchr(ptr, '\n');
+        const char* eol = memchr(ptr, '\n', end - ptr);
         if (!eol) break;
         
         size_t line_len = eol - ptr;
         if (line_len >= sizeof(line)) line_len = sizeof(line) - 1;
-        strncpy(line, ptr, line_len);
+        memcpy(line, ptr, line_len);
         line[line_len] = '\0';
         
         // Move to next line
@@ -183,7 +362,7 @@ PostMetadata* extract_post_metadata(const char* markdown_content) {
         }
         
         // Store metadata
-        char* str_value = strdup(value);
+        char* str_value = mem_strdup(MEM_CATALOG, value);
         if (!str_value) continue;
         
         if (strcmp(key, "title") == 0) {
@@ -194,8 +373,11 @@ PostMetadata* extract_post_metadata(const char* markdown_content) {
             metadata->author = str_value;
         } else if (strcmp(key, "description") == 0) {
             metadata->description = str_value;
+        } else if (strcmp(key, "tags") == 0) {
+            parse_tag_list(metadata, str_value);
+            mem_free(MEM_CATALOG, str_value);
         } else {
-            free(str_value);  // Not a recognized field
+            mem_free(MEM_CATALOG, str_value);  // Not a recognized field
         }
     }
     
@@ -207,415 +389,1471 @@ PostMetadata* extract_post_metadata(const char* markdown_content) {
     return metadata;
 }
 
-// ������������
-char* generate_permalink(const char* title, const char* date) {
-    if (!title || !date) return NULL;
-    
-    char* permalink = malloc(strlen(title) + strlen(date) + 2);
-    if (!permalink) return NULL;
-    
-    // �򻯵�������������
-    sprintf(permalink, "%s-%s", date, title);
-    
-    // ���ո�ת��Ϊ���ַ�
-    for (char* p = permalink; *p; p++) {
-        if (isspace(*p)) *p = '-';
+// 释放文章元数据
+void free_post_metadata(PostMetadata* metadata) {
+    if (!metadata) return;
+    
+    mem_free(MEM_CATALOG, metadata->title);
+    mem_free(MEM_CATALOG, metadata->date);
+    mem_free(MEM_CATALOG, metadata->author);
+    mem_free(MEM_CATALOG, metadata->description);
+    mem_free(MEM_CATALOG, metadata->permalink);
+    for (int i = 0; i < metadata->tag_count; i++) {
+        mem_free(MEM_CATALOG, metadata->tags[i]);
     }
-    
-    return permalink;
+    mem_free(MEM_CATALOG, metadata->tags);
+    mem_free(MEM_CATALOG, metadata);
 }
 
-// ��������
-int process_posts(GeneratorContext* ctx, const char* posts_dir) {
-    if (!ctx || !posts_dir) {
-        if (ctx) ctx->last_error = GEN_ERROR_MEMORY;
-        printf("Error: Invalid context or posts directory\n");
+// 比较两份元数据中影响列表页的字段
+static int same_string(const char* a, const char* b) {
+    if (!a || !b) return a == b;
+    return strcmp(a, b) == 0;
+}
+
+static int metadata_equal(const PostMetadata* a, const PostMetadata* b) {
+    if (!same_string(a->title, b->title) ||
+        !same_string(a->date, b->date) ||
+        !same_string(a->author, b->author) ||
+        !same_string(a->description, b->description) ||
+        a->tag_count != b->tag_count) {
         return 0;
     }
-    
-    printf("Processing posts from directory: %s\n", posts_dir);
-    
-    int success = 1;
-    int retry_count = 0;
-    
-    while (retry_count < ctx->config->retry_count) {
-        if (has_operation_timeout(ctx)) {
-            ctx->last_error = GEN_ERROR_TIMEOUT;
-            printf("Error: Operation timed out\n");
-            return 0;
-        }
-        
-#ifdef _WIN32
-        WIN32_FIND_DATA find_data;
-        char search_path[MAX_PATH];
-        snprintf(search_path, sizeof(search_path), "%s\\*.md", posts_dir);
-        
-        printf("Searching for markdown files in: %s\n", search_path);
-        
-        HANDLE find_handle = FindFirstFile(search_path, &find_data);
-        if (find_handle == INVALID_HANDLE_VALUE) {
-            ctx->last_error = GEN_ERROR_IO;
-            printf("Error: Could not find any markdown files (error code: %lu)\n", GetLastError());
-            return 0;
-        }
-        
-        do {
-            if (!(find_data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)) {
-                char* post_path = join_path(posts_dir, find_data.cFileName);
-                if (post_path && is_markdown_file(post_path)) {
-                    printf("Processing file: %s\n", post_path);
-                    if (!process_single_post(ctx, post_path)) {
-                        printf("Error: Failed to process post: %s\n", post_path);
-                        success = 0;
-                        break;
-                    }
-                }
-                free(post_path);
-            }
-        } while (FindNextFile(find_handle, &find_data));
-        
-        FindClose(find_handle);
-#else
-        DIR* dir = opendir(posts_dir);
-        if (!dir) {
-            ctx->last_error = GEN_ERROR_IO;
-            printf("Error: Could not open posts directory\n");
-            return 0;
-        }
-        
-        struct dirent* entry;
-        while ((entry = readdir(dir)) != NULL) {
-            if (has_operation_timeout(ctx)) {
-                closedir(dir);
-                ctx->last_error = GEN_ERROR_TIMEOUT;
-                printf("Error: Operation timed out while processing directory\n");
-                return 0;
-            }
-            
-            char* post_path = join_path(posts_dir, entry->d_name);
-            if (post_path && is_markdown_file(post_path)) {
-                printf("Processing file: %s\n", post_path);
-                if (!process_single_post(ctx, post_path)) {
-                    printf("Error: Failed to process post: %s\n", post_path);
-                    success = 0;
-                    break;
-                }
-            }
-            free(post_path);
+    for (int i = 0; i < a->tag_count; i++) {
+        if (strcmp(a->tags[i], b->tags[i]) != 0) return 0;
+    }
+    return 1;
+}
+
+// 根据标题生成输出文件名
+static void build_output_name(const PostMetadata* metadata, char* output_name, size_t size) {
+    if (metadata->title) {
+        snprintf(output_name, size, "%s.html", metadata->title);
+        // Replace spaces with hyphens
+        for (char* p = output_name; *p; p++) {
+            if (isspace((unsigned char)*p)) *p = '-';
         }
-        closedir(dir);
-#endif
-        
-        if (success) break;
-        
-        printf("Retrying after failure (attempt %d)...\n", retry_count + 1);
-        sleep_with_backoff(++retry_count, ctx->config->retry_delay);
+    } else {
+        snprintf(output_name, size, "post.html");
     }
-    
-    return success;
 }
 
-// 生成文章页面
-int generate_post_page(GeneratorContext* ctx, const char* markdown_content, PostMetadata* metadata) {
-    if (!ctx || !markdown_content || !metadata) {
-        printf("Error: Invalid parameters for generate_post_page\n");
-        if (ctx) ctx->last_error = GEN_ERROR_MEMORY;
-        return 0;
+// 文章目录操作：按源路径的哈希索引查找，数万篇文章时避免线性扫描
+static size_t catalog_slot(const PostCatalog* catalog, const char* source_path) {
+    return content_hash(source_path, strlen(source_path)) & (size_t)(catalog->slot_count - 1);
+}
+
+static void index_catalog_entry(PostCatalog* catalog, int index) {
+    size_t slot = catalog_slot(catalog, catalog->entries[index].source_path);
+    while (catalog->slots[slot]) slot = (slot + 1) & (size_t)(catalog->slot_count - 1);
+    catalog->slots[slot] = index + 1;
+}
+
+// 条目下标变化（删除、排序、批量加载）后重建索引；内存不足时退回线性查找
+void rebuild_catalog_index(PostCatalog* catalog) {
+    int slot_count = 64;
+    while (slot_count < catalog->count * 2) slot_count *= 2;
+    
+    if (slot_count != catalog->slot_count) {
+        mem_free(MEM_CATALOG, catalog->slots);
+        catalog->slots = mem_malloc(MEM_CATALOG, slot_count * sizeof(int));
+        catalog->slot_count = catalog->slots ? slot_count : 0;
     }
+    if (!catalog->slots) return;
     
-    printf("Creating parser context...\n");
-    ParserContext* parser_ctx = create_parser_context(NULL);
-    if (!parser_ctx) {
-        printf("Error: Could not create parser context\n");
-        ctx->last_error = GEN_ERROR_MEMORY;
-        return 0;
+    memset(catalog->slots, 0, catalog->slot_count * sizeof(int));
+    for (int i = 0; i < catalog->count; i++) {
+        index_catalog_entry(catalog, i);
     }
-    
-    int success = 0;
-    
-    // Skip YAML front matter
-    const char* content_start = markdown_content;
-    if (strncmp(content_start, "---\n", 4) == 0) {
-        content_start += 4;
-        while (*content_start) {
-            const char* eol = strchr(content_start, '\n');
-            if (!eol) break;
-            
-            size_t line_len = eol - content_start;
-            if (line_len == 3 && strncmp(content_start, "---", 3) == 0) {
-                content_start = eol + 1;
-                while (*content_start == '\n') content_start++;  // Skip extra newlines
-                break;
+}
+
+CatalogEntry* find_catalog_entry(GeneratorContext* ctx, const char* source_path) {
+    if (!ctx || !source_path) return NULL;
+    
+    PostCatalog* catalog = &ctx->catalog;
+    if (!catalog->slots) {
+        for (int i = 0; i < catalog->count; i++) {
+            if (strcmp(catalog->entries[i].source_path, source_path) == 0) {
+                return &catalog->entries[i];
             }
-            content_start = eol + 1;
         }
+        return NULL;
     }
     
-    printf("Parsing markdown content...\n");
-    if (parse_markdown_with_context(parser_ctx, content_start)) {
-        printf("Getting HTML output...\n");
-        char* html_content = get_html_output(parser_ctx);
-        
-        if (html_content) {
-            printf("HTML content generated successfully\n");
-            
-            // Generate output filename
-            char output_name[256];
-            if (metadata->title) {
-                char* clean_title = strdup(metadata->title);
-                if (clean_title) {
-                    // Replace spaces with hyphens
-                    for (char* p = clean_title; *p; p++) {
-                        if (isspace(*p)) *p = '-';
-                    }
-                    snprintf(output_name, sizeof(output_name), "%s.html", clean_title);
-                    free(clean_title);
-                } else {
-                    strcpy(output_name, "post.html");
-                }
-            } else {
-                strcpy(output_name, "post.html");
-            }
-            
-            printf("Output filename: %s\n", output_name);
-            char* output_path = join_path(ctx->output_dir, output_name);
-            
-            if (output_path) {
-                printf("Opening output file: %s\n", output_path);
-                FILE* fp = fopen(output_path, "w");
-                if (fp) {
-                    printf("Reading template file...\n");
-                    char* template_path = join_path("templates", "post.html");
-                    if (template_path) {
-                        size_t template_size;
-                        char* template_content = read_utf8_file(template_path, &template_size);
-                        if (template_content) {
-                            printf("Applying template...\n");
-                            char* page = apply_template(template_content, html_content, metadata);
-                            if (page) {
-                                printf("Writing output file...\n");
-                                if (fputs(page, fp) >= 0) {
-                                    success = 1;
-                                    printf("Post page generated successfully\n");
-                                } else {
-                                    printf("Error: Could not write to output file\n");
-                                }
-                                free(page);
-                            } else {
-                                printf("Error: Could not apply template\n");
-                            }
-                            free(template_content);
-                        } else {
-                            printf("Error: Could not read template file\n");
-                        }
-                        free(template_path);
-                    } else {
-                        printf("Error: Could not create template path\n");
-                    }
-                    fclose(fp);
-                } else {
-                    printf("Error: Could not create output file\n");
-                }
-                free(output_path);
-            } else {
-                printf("Error: Could not create output path\n");
-            }
-            free(html_content);
-        } else {
-            printf("Error: Could not generate HTML content\n");
-        }
-    } else {
-        printf("Error: Could not parse markdown content\n");
+    for (size_t slot = catalog_slot(catalog, source_path); catalog->slots[slot];
+         slot = (slot + 1) & (size_t)(catalog->slot_count - 1)) {
+        CatalogEntry* entry = &catalog->entries[catalog->slots[slot] - 1];
+        if (strcmp(entry->source_path, source_path) == 0) return entry;
     }
-    
-    destroy_parser_context(parser_ctx);
-    return success;
+    return NULL;
 }
 
-// 生成索引页面
-int generate_index_page(GeneratorContext* ctx) {
-    if (!ctx || !ctx->config) {
-        if (ctx) ctx->last_error = GEN_ERROR_MEMORY;
-        return 0;
+static CatalogEntry* add_catalog_entry(PostCatalog* catalog, const char* source_path) {
+    if (catalog->count == catalog->capacity) {
+        int new_capacity = catalog->capacity ? catalog->capacity * 2 : 64;
+        CatalogEntry* entries = mem_realloc(MEM_CATALOG, catalog->entries, new_capacity * sizeof(CatalogEntry));
+        if (!entries) return NULL;
+        catalog->entries = entries;
+        catalog->capacity = new_capacity;
     }
     
-    char* index_path = join_path(ctx->output_dir, "index.html");
-    if (!index_path) {
-        ctx->last_error = GEN_ERROR_MEMORY;
-        return 0;
-    }
+    CatalogEntry* entry = &catalog->entries[catalog->count];
+    memset(entry, 0, sizeof(CatalogEntry));
+    entry->source_path = mem_strdup(MEM_CATALOG, source_path);
+    if (!entry->source_path) return NULL;
     
-    FILE* fp = fopen(index_path, "w");
-    if (!fp) {
-        free(index_path);
-        ctx->last_error = GEN_ERROR_IO;
-        return 0;
+    catalog->count++;
+    if (catalog->count * 2 > catalog->slot_count) {
+        rebuild_catalog_index(catalog);
+    } else {
+        index_catalog_entry(catalog, catalog->count - 1);
     }
-    
-    fprintf(fp, "<!DOCTYPE html>\n");
-    fprintf(fp, "<html>\n<head>\n");
-    fprintf(fp, "<title>%s</title>\n", ctx->config->blog_title);
-    fprintf(fp, "</head>\n<body>\n");
-    fprintf(fp, "<h1>%s</h1>\n", ctx->config->blog_title);
-    fprintf(fp, "</body>\n</html>\n");
-    
-    fclose(fp);
-    free(index_path);
-    return 1;
+    return &catalog->entries[catalog->count - 1];
 }
 
-// 生成标签页面
-int generate_tag_pages(GeneratorContext* ctx) {
-    if (!ctx) return 0;
-    
-    char* tags_dir = join_path(ctx->output_dir, "tags");
-    if (!tags_dir) {
-        ctx->last_error = GEN_ERROR_MEMORY;
-        return 0;
+// 输出文件名索引：文件名由标题生成，不同目录下的同名文章（posts/2023/.. 和 posts/2024/..）会冲突
+static OutputNameSlot* find_output_name(const OutputNames* names, const char* name) {
+    size_t mask = (size_t)names->slot_count - 1;
+    for (size_t slot = content_hash(name, strlen(name)) & mask; names->slots[slot].name; slot = (slot + 1) & mask) {
+        OutputNameSlot* entry = &names->slots[slot];
+        if (entry->owner && strcmp(entry->name, name) == 0) return entry;
     }
-    
-    int result = MKDIR(tags_dir) == 0 || errno == EEXIST;
-    free(tags_dir);
-    return result;
+    return NULL;
 }
 
-// 生成归档页面
-int generate_archive_page(GeneratorContext* ctx) {
-    if (!ctx) return 0;
-    
-    char* archive_path = join_path(ctx->output_dir, "archive.html");
-    if (!archive_path) {
-        ctx->last_error = GEN_ERROR_MEMORY;
-        return 0;
+// 扩容时丢弃已删除的槽位
+static int grow_output_names(OutputNames* names, int min_live) {
+    int slot_count = 64;
+    while (slot_count < min_live * 2) slot_count *= 2;
+    
+    OutputNameSlot* slots = mem_calloc(MEM_CATALOG, slot_count, sizeof(OutputNameSlot));
+    if (!slots) return 0;
+    
+    int used = 0;
+    for (int i = 0; i < names->slot_count; i++) {
+        OutputNameSlot* old = &names->slots[i];
+        if (!old->owner) {
+            mem_free(MEM_CATALOG, old->name);
+            continue;
+        }
+        size_t slot = content_hash(old->name, strlen(old->name)) & (size_t)(slot_count - 1);
+        while (slots[slot].name) slot = (slot + 1) & (size_t)(slot_count - 1);
+        slots[slot] = *old;
+        used++;
     }
-    
-    FILE* fp = fopen(archive_path, "w");
-    if (!fp) {
-        free(archive_path);
-        ctx->last_error = GEN_ERROR_IO;
-        return 0;
+    mem_free(MEM_CATALOG, names->slots);
+    names->slots = slots;
+    names->slot_count = slot_count;
+    names->used = used;
+    return 1;
+}
+
+static int set_output_name_owner(OutputNames* names, const char* name, const char* owner) {
+    OutputNameSlot* entry = find_output_name(names, name);
+    if (entry) {
+        if (strcmp(entry->owner, owner) == 0) return 1;
+        char* copy = mem_strdup(MEM_CATALOG, owner);
+        if (!copy) return 0;
+        mem_free(MEM_CATALOG, entry->owner);
+        entry->owner = copy;
+        return 1;
     }
     
-    fprintf(fp, "<html><body><h1>Archives</h1></body></html>\n");
-    fclose(fp);
+    if ((names->used + 1) * 2 > names->slot_count && !grow_output_names(names, names->used + 1)) return 0;
     
-    free(archive_path);
+    size_t mask = (size_t)names->slot_count - 1;
+    size_t slot = content_hash(name, strlen(name)) & mask;
+    while (names->slots[slot].name) slot = (slot + 1) & mask;
+    char* name_copy = mem_strdup(MEM_CATALOG, name);
+    char* owner_copy = mem_strdup(MEM_CATALOG, owner);
+    if (!name_copy || !owner_copy) {
+        mem_free(MEM_CATALOG, name_copy);
+        mem_free(MEM_CATALOG, owner_copy);
+        return 0;
+    }
+    names->slots[slot].name = name_copy;
+    names->slots[slot].owner = owner_copy;
+    names->used++;
     return 1;
 }
 
-// 生成RSS订阅
-int generate_rss_feed(GeneratorContext* ctx) {
-    if (!ctx || !ctx->config) return 0;
-    
-    char* rss_path = join_path(ctx->output_dir, "feed.xml");
-    if (!rss_path) {
-        ctx->last_error = GEN_ERROR_MEMORY;
-        return 0;
+// 首次使用时由目录（可能来自上次构建的缓存）建立；旧缓存中重复的文件名归第一个条目
+static int output_names_ready(GeneratorContext* ctx) {
+    OutputNames* names = &ctx->output_names;
+    if (names->slots) return 1;
+    if (!grow_output_names(names, ctx->catalog.count + 1)) return 0;
+    
+    for (int i = 0; i < ctx->catalog.count; i++) {
+        const CatalogEntry* entry = &ctx->catalog.entries[i];
+        if (entry->output_name && !find_output_name(names, entry->output_name) &&
+            !set_output_name_owner(names, entry->output_name, entry->source_path)) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+// 文件名是否属于 owner；索引尚未建立时没有冲突可言
+static int owns_output_name(const GeneratorContext* ctx, const char* name, const char* owner) {
+    if (!ctx->output_names.slots) return 1;
+    const OutputNameSlot* entry = find_output_name(&ctx->output_names, name);
+    return !entry || strcmp(entry->owner, owner) == 0;
+}
+
+static void release_output_name(GeneratorContext* ctx, const char* name, const char* owner) {
+    if (!ctx->output_names.slots) return;
+    OutputNameSlot* entry = find_output_name(&ctx->output_names, name);
+    if (entry && strcmp(entry->owner, owner) == 0) {
+        mem_free(MEM_CATALOG, entry->owner);
+        entry->owner = NULL;
+    }
+}
+
+// 由源路径生成文件名后缀：去掉顶层目录和扩展名，其余非字母数字的 ASCII 字符替换为 '-'
+static void build_path_slug(const char* post_path, char* slug, size_t size) {
+    const char* start = strchr(post_path, '/');
+    start = start && start[1] ? start + 1 : post_path;
+    const char* end = strrchr(start, '.');
+    if (!end || strchr(end, '/')) end = start + strlen(start);
+    
+    size_t length = 0;
+    for (const char* p = start; p < end && length + 1 < size; p++) {
+        unsigned char c = (unsigned char)*p;
+        char out = (isalnum(c) || c >= 0x80) ? (char)c : '-';
+        if (out == '-' && (length == 0 || slug[length - 1] == '-')) continue;
+        slug[length++] = out;
+    }
+    while (length > 0 && slug[length - 1] == '-') length--;
+    slug[length] = '\0';
+}
+
+// 在渲染前为文章登记输出文件名：标题对应的文件名已属于其他文章时改用 "标题-路径后缀.html"，
+// 再冲突时追加序号。登记的文件名在构建之间随目录缓存保持稳定
+static int claim_output_name(GeneratorContext* ctx, const char* post_path, const PostMetadata* metadata,
+                             char* output_name, size_t size) {
+    char base[256];
+    build_output_name(metadata, base, sizeof(base));
+    size_t stem = strlen(base) - strlen(".html");
+    char slug[128];
+    build_path_slug(post_path, slug, sizeof(slug));
+    
+    lock_catalog(ctx);
+    int claimed = output_names_ready(ctx);
+    for (int attempt = 0; claimed; attempt++) {
+        if (attempt == 0) {
+            snprintf(output_name, size, "%s", base);
+        } else if (attempt == 1) {
+            snprintf(output_name, size, "%.*s-%s.html", (int)stem, base, slug);
+        } else {
+            snprintf(output_name, size, "%.*s-%s-%d.html", (int)stem, base, slug, attempt);
+        }
+        if (owns_output_name(ctx, output_name, post_path)) {
+            claimed = set_output_name_owner(&ctx->output_names, output_name, post_path);
+            if (claimed) find_output_name(&ctx->output_names, output_name)->write_failed = 0;
+            break;
+        }
     }
+    unlock_catalog(ctx);
     
-    FILE* fp = fopen(rss_path, "w");
-    if (!fp) {
-        free(rss_path);
-        ctx->last_error = GEN_ERROR_IO;
-        return 0;
+    if (claimed && strcmp(output_name, base) != 0) {
+        log_warn("%s: output file %s is used by another post, writing %s", post_path, base, output_name);
+    }
+    return claimed;
+}
+
+// 批量写出的页面在 flush 时失败：清除所属文章的渲染记录，下次增量构建重新渲染；
+// 文章尚未写入目录时由 update_catalog_entry 根据 write_failed 处理
+static void batch_write_failed(void* user, const char* path) {
+    GeneratorContext* ctx = (GeneratorContext*)user;
+    size_t dir_len = strlen(ctx->output_dir);
+    if (strncmp(path, ctx->output_dir, dir_len) != 0) return;
+    const char* name = path + dir_len;
+    if (*name == PATH_SEPARATOR) name++;
+    
+    lock_catalog(ctx);
+    OutputNameSlot* slot = ctx->output_names.slots ? find_output_name(&ctx->output_names, name) : NULL;
+    if (slot) {
+        slot->write_failed = 1;
+        CatalogEntry* entry = find_catalog_entry(ctx, slot->owner);
+        if (entry) {
+            entry->size = 0;
+            entry->mtime_ns = 0;
+        }
+    }
+    unlock_catalog(ctx);
+}
+
+// 删除页面及其 .gz，否则预览服务和 gzip_static 仍会返回已删除的页面
+static int remove_page(const char* path) {
+    char gz_path[1100];
+    snprintf(gz_path, sizeof(gz_path), "%s.gz", path);
+    remove(gz_path);
+    return remove(path) == 0;
+}
+
+// 从目录中移除文章并删除其输出文件；文件已属于其他文章时保留
+int remove_post(GeneratorContext* ctx, const char* post_path) {
+    CatalogEntry* entry = find_catalog_entry(ctx, post_path);
+    if (!entry) return 0;
+    
+    if (entry->output_name && owns_output_name(ctx, entry->output_name, post_path)) {
+        char* output_path = join_path(ctx->output_dir, entry->output_name);
+        if (output_path) {
+            remove_page(output_path);
+            mem_free(MEM_OUTPUT, output_path);
+        }
+        release_output_name(ctx, entry->output_name, post_path);
     }
     
-    fprintf(fp, "<?xml version=\"1.0\" encoding=\"UTF-8\" ?>\n");
-    fprintf(fp, "<rss version=\"2.0\">\n");
-    fprintf(fp, "<channel>\n");
-    fprintf(fp, "    <title>%s</title>\n", ctx->config->blog_title);
-    fprintf(fp, "    <link>%s</link>\n", ctx->config->base_url);
-    fprintf(fp, "    <description>%s</description>\n", ctx->config->blog_description);
-    fprintf(fp, "    <language>en-us</language>\n");
-    fprintf(fp, "    <pubDate>%s</pubDate>\n", "Mon, 01 Jan 2024 00:00:00 GMT");
-    fprintf(fp, "</channel>\n");
-    fprintf(fp, "</rss>\n");
+    release_catalog_entry(ctx, entry);
     
-    fclose(fp);
-    free(rss_path);
+    int index = (int)(entry - ctx->catalog.entries);
+    memmove(entry, entry + 1, (ctx->catalog.count - index - 1) * sizeof(CatalogEntry));
+    ctx->catalog.count--;
+    rebuild_catalog_index(&ctx->catalog);
+    ctx->catalog_changed = 1;
     return 1;
 }
 
-// 生成站点地图
-int generate_sitemap(GeneratorContext* ctx) {
-    if (!ctx) return 0;
-    
-    char* sitemap_path = join_path(ctx->output_dir, "sitemap.xml");
-    if (!sitemap_path) {
-        ctx->last_error = GEN_ERROR_MEMORY;
-        return 0;
+// 根据目录重建标签索引
+static TagEntry* find_or_add_tag(TagIndex* index, const char* name) {
+    for (int i = 0; i < index->count; i++) {
+        if (strcmp(index->tags[i].name, name) == 0) return &index->tags[i];
     }
     
-    FILE* fp = fopen(sitemap_path, "w");
-    if (!fp) {
-        free(sitemap_path);
-        ctx->last_error = GEN_ERROR_IO;
-        return 0;
+    if (index->count == index->capacity) {
+        int new_capacity = index->capacity ? index->capacity * 2 : 32;
+        TagEntry* tags = mem_realloc(MEM_CATALOG, index->tags, new_capacity * sizeof(TagEntry));
+        if (!tags) return NULL;
+        index->tags = tags;
+        index->capacity = new_capacity;
     }
     
-    fprintf(fp, "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n");
-    fprintf(fp, "<urlset xmlns=\"http://www.sitemaps.org/schemas/sitemap/0.9\">\n");
-    fprintf(fp, "</urlset>\n");
+    TagEntry* tag = &index->tags[index->count];
+    memset(tag, 0, sizeof(TagEntry));
+    tag->name = mem_strdup(MEM_CATALOG, name);
+    if (!tag->name) return NULL;
     
-    fclose(fp);
-    free(sitemap_path);
-    return 1;
+    index->count++;
+    return tag;
 }
 
-// 模板处理函数
-char* apply_template(const char* template_content, const char* content, const PostMetadata* metadata) {
-    if (!template_content || !content || !metadata) return NULL;
-    
-    // 预估需要的缓冲区大小
-    size_t buffer_size = strlen(template_content) + strlen(content) * 2;
-    if (metadata->title) buffer_size += strlen(metadata->title) * 2;
-    if (metadata->date) buffer_size += strlen(metadata->date) * 2;
-    if (metadata->author) buffer_size += strlen(metadata->author) * 2;
-    if (metadata->description) buffer_size += strlen(metadata->description) * 2;
+void rebuild_tag_index(GeneratorContext* ctx) {
+    if (!ctx) return;
     
-    char* result = malloc(buffer_size);
-    if (!result) return NULL;
+    clear_tag_index(&ctx->tag_index);
+    for (int i = 0; i < ctx->catalog.count; i++) {
+        PostMetadata* metadata = ctx->catalog.entries[i].metadata;
+        if (!metadata) continue;
+        
+        for (int t = 0; t < metadata->tag_count; t++) {
+            TagEntry* tag = find_or_add_tag(&ctx->tag_index, metadata->tags[t]);
+            if (!tag) continue;
+            
+            if (tag->count == tag->capacity) {
+                int new_capacity = tag->capacity ? tag->capacity * 2 : 8;
+                int* posts = mem_realloc(MEM_CATALOG, tag->posts, new_capacity * sizeof(int));
+                if (!posts) continue;
+                tag->posts = posts;
+                tag->capacity = new_capacity;
+            }
+            tag->posts[tag->count++] = i;
+        }
+    }
+}
+
+// ������������
+char* generate_permalink(const char* title, const char* date) {
+    if (!title || !date) return NULL;
     
-    // 简单的模板替换
-    char* current = result;
-    const char* template_ptr = template_content;
+    char* permalink = mem_malloc(MEM_CATALOG, strlen(title) + strlen(date) + 2);
+    if (!permalink) return NULL;
+    
+    // �򻯵�������������
+    sprintf(permalink, "%s-%s", date, title);
     
-    while (*template_ptr) {
-        if (strncmp(template_ptr, "{{content}}", 10) == 0) {
-            if (content) {
-                strcpy(current, content);
-                current += strlen(content);
+    // ���ո�ת��Ϊ���ַ�
+    for (char* p = permalink; *p; p++) {
+        if (isspace(*p)) *p = '-';
+    }
+    
+    return permalink;
+}
+
+// 并行处理文章的任务参数
+typedef struct {
+    GeneratorContext* ctx;
+    const ScanEntry* source;  // 扫描时（读取之前）取得的路径、大小和修改时间
+    int metadata_only;        // 只读取 front matter，不渲染正文
+    int needs_render;         // 只读元数据时发现输出页面不存在，需要完整渲染
+    CancelToken token;        // 单篇文章的时间预算，由线程池在任务开始时计时
+} PostTask;
+
+static int process_scanned_post(GeneratorContext* ctx, const ScanEntry* scanned);
+
+// 只有文件被占用、描述符耗尽之类的临时 I/O 错误值得重试，格式错误重试也不会成功
+static int is_transient_failure(const PostFailure* failure) {
+    if (failure->error != GEN_ERROR_IO) return 0;
+    
+    switch (failure->sys_errno) {
+        case EINTR:
+        case EAGAIN:
+        case EBUSY:
+        case EMFILE:
+        case ENFILE:
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+static void sleep_ms(int ms) {
+#ifdef _WIN32
+    Sleep(ms);
+#else
+    struct timespec ts = { ms / 1000, (long)(ms % 1000) * 1000000L };
+    nanosleep(&ts, NULL);
+#endif
+}
+
+static void record_post_failure(GeneratorContext* ctx, const char* path, PostFailure* failure) {
+    if (!failure->message[0]) {
+        snprintf(failure->message, sizeof(failure->message), "%s", get_error_message(failure->error));
+    }
+    failure->source_path = mem_strdup(MEM_GENERAL, path);
+    if (!failure->source_path) return;
+    
+    lock_catalog(ctx);
+    PostFailures* list = &ctx->failures;
+    if (list->count == list->capacity) {
+        int new_capacity = list->capacity ? list->capacity * 2 : 16;
+        PostFailure* items = mem_realloc(MEM_GENERAL, list->items, new_capacity * sizeof(PostFailure));
+        if (items) {
+            list->items = items;
+            list->capacity = new_capacity;
+        }
+    }
+    if (list->count < list->capacity) {
+        list->items[list->count++] = *failure;
+    } else {
+        mem_free(MEM_GENERAL, failure->source_path);
+    }
+    unlock_catalog(ctx);
+}
+
+// 处理一篇文章；失败只影响这一篇，临时 I/O 错误在短暂等待后单独重试
+static void process_post_task(void* arg) {
+    PostTask* task = (PostTask*)arg;
+    GeneratorContext* ctx = task->ctx;
+    PostFailure failure;
+    int result = 0;
+    
+    current_failure = &failure;
+    for (int attempt = 1; ; attempt++) {
+        memset(&failure, 0, sizeof(failure));
+        failure.error = GEN_ERROR_MEMORY;
+        
+        if (task->metadata_only) {
+            result = process_post_metadata(ctx, task->source->path);
+            if (result < 0) {
+                task->needs_render = 1;
+                break;
             }
-            template_ptr += 10;
-        } else if (strncmp(template_ptr, "{{title}}", 8) == 0) {
-            if (metadata->title) {
-                strcpy(current, metadata->title);
-                current += strlen(metadata->title);
+        } else {
+            log_debug("Processing file: %s", task->source->path);
+            result = process_scanned_post(ctx, task->source);
+        }
+        
+        if (result || !is_transient_failure(&failure) || attempt >= ctx->config->retry_count) break;
+        
+        log_warn("Transient error on %s (%s), retrying...", task->source->path, strerror(failure.sys_errno));
+        sleep_ms(POST_RETRY_DELAY_MS << (attempt - 1));
+    }
+    current_failure = NULL;
+    
+    if (!result) {
+        log_error("Failed to process post: %s", task->source->path);
+        record_post_failure(ctx, task->source->path, &failure);
+    }
+}
+
+// 源文件的大小和修改时间与上次渲染时相同且输出仍存在，则无需重新渲染
+static int post_is_current(GeneratorContext* ctx, const ScanEntry* file) {
+    if (!ctx->config->enable_incremental) return 0;
+    
+    CatalogEntry* entry = find_catalog_entry(ctx, file->path);
+    if (!entry || !entry->output_name ||
+        entry->size != file->size || entry->mtime_ns != file->mtime_ns) {
+        return 0;
+    }
+    
+    char* output_path = join_path(ctx->output_dir, entry->output_name);
+    int current = output_path && file_exists(output_path);
+    mem_free(MEM_OUTPUT, output_path);
+    return current;
+}
+
+static int compare_entries_by_source(const void* a, const void* b) {
+    return strcmp(((const CatalogEntry*)a)->source_path, ((const CatalogEntry*)b)->source_path);
+}
+
+// 渲染指纹：已编译模板的全部片段（包括解析后的资源路径）和影响页面输出的配置
+uint64_t render_fingerprint(const GeneratorContext* ctx) {
+    uint64_t hash = CONTENT_HASH_INIT;
+    const CompiledTemplate* tpl = ctx->post_template;
+    
+    for (int i = 0; tpl && i < tpl->segment_count; i++) {
+        const TemplateSegment* segment = &tpl->segments[i];
+        hash = content_hash_update(hash, &segment->type, sizeof(segment->type));
+        if (segment->text) hash = content_hash_update(hash, segment->text, segment->length);
+    }
+    hash = content_hash_update(hash, &ctx->config->enable_minify, sizeof(ctx->config->enable_minify));
+    return hash;
+}
+
+// 从目录中移除本次扫描没有找到的文章（例如上次缓存之后被删除的文件）
+static void remove_missing_posts(GeneratorContext* ctx, const ScanResult* scan) {
+    char* seen = mem_calloc(MEM_CATALOG, ctx->catalog.count + 1, 1);
+    if (!seen) return;
+    
+    for (int i = 0; i < scan->count; i++) {
+        CatalogEntry* entry = find_catalog_entry(ctx, scan->entries[i].path);
+        if (entry) seen[entry - ctx->catalog.entries] = 1;
+    }
+    for (int i = ctx->catalog.count - 1; i >= 0; i--) {
+        if (!seen[i]) {
+            log_info("Removing deleted post: %s", ctx->catalog.entries[i].source_path);
+            remove_post(ctx, ctx->catalog.entries[i].source_path);
+        }
+    }
+    mem_free(MEM_CATALOG, seen);
+}
+
+static void run_post_tasks(GeneratorContext* ctx, PostTask* tasks, int count) {
+    for (int i = 0; i < count; i++) {
+        cancel_token_init(&tasks[i].token, ctx->config->post_budget_ms);
+        if (!worker_pool_submit_with_token(ctx->workers, process_post_task, &tasks[i], &tasks[i].token)) {
+            process_post_task(&tasks[i]);
+        }
+    }
+    worker_pool_wait(ctx->workers);
+}
+
+// 处理扫描到的文章：大文件先调度，各文章在线程池上并行渲染或读取元数据
+// 单篇文章的失败记录在 ctx->failures 中，不影响其余文章；只有模板缺失等全局错误才返回 0
+static int process_scanned_posts(GeneratorContext* ctx, ScanResult* scan, int metadata_only) {
+    sort_scan_by_size(scan);
+    remove_missing_posts(ctx, scan);
+    
+    // 模板或配置与缓存中记录的不同时，所有文章都要重新渲染
+    if (!metadata_only && scan->count > 0) {
+        if (!ctx->post_template && !load_post_template(ctx)) {
+            log_error("Could not read template file");
+            return 0;
+        }
+        uint64_t key = render_fingerprint(ctx);
+        if (key != ctx->catalog_cache.render_key) {
+            for (int i = 0; i < ctx->catalog.count; i++) {
+                ctx->catalog.entries[i].size = 0;
+                ctx->catalog.entries[i].mtime_ns = 0;
             }
-            template_ptr += 8;
-        } else if (strncmp(template_ptr, "{{date}}", 8) == 0) {
-            if (metadata->date) {
-                strcpy(current, metadata->date);
-                current += strlen(metadata->date);
+            ctx->catalog_cache.render_key = key;
+        }
+    }
+    
+    PostTask* tasks = mem_malloc(MEM_SCAN, (scan->count + 1) * sizeof(PostTask));
+    if (!tasks) {
+        ctx->last_error = GEN_ERROR_MEMORY;
+        return 0;
+    }
+    
+    int pending = 0;
+    for (int i = 0; i < scan->count; i++) {
+        if (post_is_current(ctx, &scan->entries[i])) continue;
+        
+        PostTask* task = &tasks[pending++];
+        task->ctx = ctx;
+        task->source = &scan->entries[i];
+        task->metadata_only = metadata_only;
+        task->needs_render = 0;
+    }
+    
+    // 只读元数据时先不加载模板，只有缺少输出页面的文章才补渲染
+    if (metadata_only) {
+        run_post_tasks(ctx, tasks, pending);
+        
+        int render = 0;
+        for (int i = 0; i < pending; i++) {
+            if (tasks[i].needs_render) {
+                tasks[render] = tasks[i];
+                tasks[render].metadata_only = 0;
+                render++;
             }
-            template_ptr += 8;
-        } else if (strncmp(template_ptr, "{{author}}", 10) == 0) {
-            if (metadata->author) {
-                strcpy(current, metadata->author);
-                current += strlen(metadata->author);
+        }
+        log_info("Read metadata of %d post(s), %d need rendering", pending - render, render);
+        pending = render;
+    }
+    
+    // 模板在分发前加载，避免多个线程同时编译
+    if (pending > 0) {
+        if (!ctx->post_template && !load_post_template(ctx)) {
+            log_error("Could not read template file");
+            mem_free(MEM_SCAN, tasks);
+            return 0;
+        }
+        run_post_tasks(ctx, tasks, pending);
+        if (!metadata_only) log_info("Processed %d post(s), %d unchanged", pending, scan->count - pending);
+    }
+    mem_free(MEM_SCAN, tasks);
+    
+    // 完成顺序不确定，按源路径排序使标签页和站点地图的输出稳定
+    qsort(ctx->catalog.entries, ctx->catalog.count, sizeof(CatalogEntry), compare_entries_by_source);
+    rebuild_catalog_index(&ctx->catalog);
+    return 1;
+}
+
+static int scan_and_process_posts(GeneratorContext* ctx, const char* posts_dir, int metadata_only) {
+    if (!ctx || !posts_dir) {
+        if (ctx) ctx->last_error = GEN_ERROR_MEMORY;
+        log_error("Invalid context or posts directory");
+        return 0;
+    }
+    
+    log_info("Processing posts from directory: %s", posts_dir);
+    clear_post_failures(ctx);
+    
+    // 递归扫描（如 posts/YYYY/MM/），同时取得大小和修改时间
+    ScanResult* scan = &ctx->posts_scan;
+    free_scan_result(scan);
+    ProfileSpan span = profile_begin(PROFILE_SCAN, posts_dir);
+    int scanned = scan_markdown_files(posts_dir, ctx->workers, scan);
+    profile_end(&span);
+    if (!scanned) {
+        free_scan_result(scan);
+        ctx->last_error = GEN_ERROR_IO;
+        log_error("Could not scan posts directory %s (errno: %d)", posts_dir, errno);
+        return 0;
+    }
+    
+    log_info("Found %d markdown file(s)", scan->count);
+    int success = process_scanned_posts(ctx, scan, metadata_only);
+    
+    span = profile_begin(PROFILE_WRITE, NULL);
+    int flushed = flush_output(ctx);
+    profile_end(&span);
+    return flushed && success;
+}
+
+// ��������
+int process_posts(GeneratorContext* ctx, const char* posts_dir) {
+    return scan_and_process_posts(ctx, posts_dir, 0);
+}
+
+// 只根据 front matter 填充目录，用于快速重建列表页
+int process_posts_metadata(GeneratorContext* ctx, const char* posts_dir) {
+    return scan_and_process_posts(ctx, posts_dir, 1);
+}
+
+void clear_post_failures(GeneratorContext* ctx) {
+    for (int i = 0; i < ctx->failures.count; i++) {
+        mem_free(MEM_GENERAL, ctx->failures.items[i].source_path);
+    }
+    ctx->failures.count = 0;
+}
+
+// 汇总输出本次构建中失败的文章，返回失败数
+int report_post_failures(const GeneratorContext* ctx) {
+    if (!ctx || ctx->failures.count == 0) return 0;
+    
+    int timed_out = 0;
+    log_message(LOG_LEVEL_WARN, "%d post(s) failed:", ctx->failures.count);
+    for (int i = 0; i < ctx->failures.count; i++) {
+        const PostFailure* failure = &ctx->failures.items[i];
+        log_message(LOG_LEVEL_WARN, "  %s: %s", failure->source_path, failure->message);
+        if (failure->error == GEN_ERROR_TIMEOUT) timed_out++;
+    }
+    if (timed_out) {
+        log_message(LOG_LEVEL_WARN, "%d post(s) exceeded the per-post time budget (--post-budget)", timed_out);
+    }
+    return ctx->failures.count;
+}
+
+static void minify_to_buffer(void* user, const char* data, size_t length) {
+    output_append_raw((OutputBuffer*)user, data, length);
+}
+
+static void feed_minifier(void* user, const char* data, size_t length) {
+    minifier_feed((HtmlMinifier*)user, data, length);
+}
+
+// 开始一个 HTML 页面；启用压缩时写入 out 的内容边生成边压缩，缓冲区里只有压缩后的页面
+static void begin_html_page(GeneratorContext* ctx, OutputBuffer* out, HtmlMinifier* minifier) {
+    output_init(out);
+    if (ctx->config->enable_minify) {
+        minifier_init(minifier, minify_to_buffer, out);
+        output_set_filter(out, feed_minifier, minifier);
+    }
+}
+
+// 输出 minifier 中剩余的内容
+static void end_html_page(OutputBuffer* out) {
+    if (out->filter) {
+        HtmlMinifier* minifier = (HtmlMinifier*)out->filter_user;
+        output_set_filter(out, NULL, NULL);
+        minifier_finish(minifier);
+    }
+}
+
+void track_rewritten_outputs(GeneratorContext* ctx) {
+    ctx->rewritten.enabled = 1;
+}
+
+void clear_rewritten_outputs(GeneratorContext* ctx) {
+    for (int i = 0; i < ctx->rewritten.count; i++) {
+        mem_free(MEM_OUTPUT, ctx->rewritten.paths[i]);
+    }
+    ctx->rewritten.count = 0;
+}
+
+// 记录改写的页面；文章在线程池上并行渲染，与目录共用一把锁
+static void note_rewritten(GeneratorContext* ctx, const char* path, WriteResult result) {
+    if (!ctx->rewritten.enabled || (result != WRITE_WRITTEN && result != WRITE_QUEUED)) return;
+    
+    lock_catalog(ctx);
+    RewrittenOutputs* list = &ctx->rewritten;
+    if (list->count == list->capacity) {
+        int new_capacity = list->capacity ? list->capacity * 2 : 64;
+        char** paths = mem_realloc(MEM_OUTPUT, list->paths, new_capacity * sizeof(char*));
+        if (paths) {
+            list->paths = paths;
+            list->capacity = new_capacity;
+        }
+    }
+    if (list->count < list->capacity) {
+        list->paths[list->count] = mem_strdup(MEM_OUTPUT, path);
+        if (list->paths[list->count]) list->count++;
+    }
+    unlock_catalog(ctx);
+}
+
+// 提交整页输出；启用批量写出时缓冲区交给批处理，否则立即写出
+static int commit_page(GeneratorContext* ctx, OutputBuffer* out, const char* path) {
+    end_html_page(out);
+    WriteResult written;
+    if (ctx->output_batch && !out->failed) {
+        char* data = out->data ? out->data : mem_strdup(MEM_OUTPUT, "");
+        written = data ? output_batch_add(ctx->output_batch, path, data, out->length) : WRITE_FAILED;
+        out->data = NULL;
+    } else {
+        written = output_commit(out, path, &ctx->writes);
+    }
+    output_free(out);
+    note_rewritten(ctx, path, written);
+    int result = written != WRITE_FAILED;
+    if (!result) ctx->last_error = GEN_ERROR_IO;
+    return result;
+}
+
+static const char* template_value(const TemplateSegment* segment, const char* content,
+                                  const PostMetadata* metadata);
+
+// 渲染文章页面到 out；不压缩时按模板一次分配到位，压缩时模板各段直接送入 minifier，
+// 与流式生成一样不产生未压缩的整页
+static int render_post_page(GeneratorContext* ctx, const char* content, const PostMetadata* metadata,
+                            OutputBuffer* out, HtmlMinifier* minifier) {
+    if (!ctx->config->enable_minify) {
+        output_init(out);
+        char* page = render_template(ctx->post_template, content, metadata);
+        if (!page) return 0;
+        output_adopt(out, page, strlen(page));
+        return 1;
+    }
+    
+    begin_html_page(ctx, out, minifier);
+    const CompiledTemplate* tpl = ctx->post_template;
+    for (int i = 0; i < tpl->segment_count; i++) {
+        const TemplateSegment* segment = &tpl->segments[i];
+        if (segment->type == TPL_LITERAL) {
+            output_append(out, segment->text, segment->length);
+        } else {
+            const char* value = template_value(segment, content, metadata);
+            if (value) output_puts(out, value);
+        }
+    }
+    end_html_page(out);
+    return !out->failed;
+}
+
+// 等待批量写出完成
+int flush_output(GeneratorContext* ctx) {
+    if (!ctx || !ctx->output_batch) return 1;
+    
+    if (output_batch_flush(ctx->output_batch) > 0) {
+        ctx->last_error = GEN_ERROR_IO;
+        return 0;
+    }
+    return 1;
+}
+
+// 生成文章页面
+int generate_post_page(GeneratorContext* ctx, const char* markdown_content, size_t length,
+                       const LineIndex* lines, PostMetadata* metadata, const char* output_name) {
+    if (!ctx || !markdown_content || !metadata || !output_name) {
+        log_error("Invalid parameters for generate_post_page");
+        if (ctx) ctx->last_error = GEN_ERROR_MEMORY;
+        return 0;
+    }
+    
+    log_debug("Creating parser context...");
+    ParserContext* parser_ctx = create_parser_context(NULL);
+    if (!parser_ctx) {
+        post_error(ctx, GEN_ERROR_MEMORY, "Could not create parser context");
+        return 0;
+    }
+    
+    int success = 0;
+    
+    log_debug("Parsing markdown content...");
+    ProfileSpan span = profile_begin(PROFILE_PARSE, current_post);
+    // front matter 由解析器跳过；这里不能再跳一次，否则正文以 "---" 开头时会丢掉一段
+    int parsed = parse_markdown_indexed(parser_ctx, markdown_content, length, lines);
+    profile_end(&span);
+    if (post_cancelled(ctx, "parse")) {
+        parsed = 0;
+    } else if (!parsed) {
+        post_error(ctx, GEN_ERROR_MEMORY, "Could not parse markdown content");
+    }
+    
+    if (parsed) {
+        log_debug("Getting HTML output...");
+        span = profile_begin(PROFILE_RENDER, current_post);
+        char* html_content = get_html_output(parser_ctx);
+        profile_end(&span);
+        
+        if (html_content) {
+            log_debug("HTML content generated successfully");
+            
+            log_debug("Output filename: %s", output_name);
+            char* output_path = join_path(ctx->output_dir, output_name);
+            
+            if (output_path) {
+                // 页面完整渲染后才写出，模板出错时不会留下截断的文件
+                if (ctx->post_template || load_post_template(ctx)) {
+                    log_debug("Applying template...");
+                    OutputBuffer page;
+                    HtmlMinifier minifier;
+                    span = profile_begin(PROFILE_TEMPLATE, current_post);
+                    int rendered = render_post_page(ctx, html_content, metadata, &page, &minifier);
+                    profile_end(&span);
+                    if (!rendered) {
+                        output_free(&page);
+                        post_error(ctx, GEN_ERROR_MEMORY, "Could not apply template");
+                    } else if (post_cancelled(ctx, "template")) {
+                        output_free(&page);
+                    } else {
+                        log_debug("Writing output file: %s", output_path);
+                        span = profile_begin(PROFILE_WRITE, current_post);
+                        int written = commit_page(ctx, &page, output_path);
+                        profile_end(&span);
+                        if (written) {
+                            success = 1;
+                            log_debug("Post page generated successfully");
+                        } else {
+                            post_error(ctx, GEN_ERROR_IO, "Could not write %s (%s)", output_path, strerror(errno));
+                        }
+                    }
+                } else {
+                    post_error(ctx, GEN_ERROR_IO, "Could not read template file");
+                }
+                mem_free(MEM_OUTPUT, output_path);
+            } else {
+                post_error(ctx, GEN_ERROR_MEMORY, "Could not create output path");
+            }
+            mem_free(MEM_RENDER, html_content);
+        } else {
+            post_error(ctx, GEN_ERROR_MEMORY, "Could not generate HTML content");
+        }
+    }
+    
+    destroy_parser_context(parser_ctx);
+    return success;
+}
+
+// 流式写出的页面，启用压缩时先经过 minifier
+typedef struct {
+    OutputStream file;
+    HtmlMinifier minifier;
+    int minify;
+} PageStream;
+
+static void stream_to_file(void* user, const char* data, size_t length) {
+    output_stream_write((OutputStream*)user, data, length);
+}
+
+static void stream_page(void* user, const char* data, size_t length) {
+    PageStream* page = (PageStream*)user;
+    if (page->minify) {
+        minifier_feed(&page->minifier, data, length);
+    } else {
+        output_stream_write(&page->file, data, length);
+    }
+}
+
+// 超过 chunk_size 的文章流式生成：模板的字面量和元数据直接写出，{{content}} 处边解析边渲染，
+// 不保留块链表、整篇 HTML 和整页输出，内存与文章大小无关
+int generate_post_page_streaming(GeneratorContext* ctx, const char* markdown_content, size_t length,
+                                 PostMetadata* metadata, const char* output_name) {
+    if (!ctx || !markdown_content || !metadata || !output_name) {
+        log_error("Invalid parameters for generate_post_page_streaming");
+        if (ctx) ctx->last_error = GEN_ERROR_MEMORY;
+        return 0;
+    }
+    if (!ctx->post_template && !load_post_template(ctx)) {
+        post_error(ctx, GEN_ERROR_IO, "Could not read template file");
+        return 0;
+    }
+    
+    char* output_path = join_path(ctx->output_dir, output_name);
+    if (!output_path) {
+        post_error(ctx, GEN_ERROR_MEMORY, "Could not create output path");
+        return 0;
+    }
+    
+    ParserContext* parser_ctx = create_parser_context(NULL);
+    if (!parser_ctx) {
+        post_error(ctx, GEN_ERROR_MEMORY, "Could not create parser context");
+        mem_free(MEM_OUTPUT, output_path);
+        return 0;
+    }
+    
+    PageStream page;
+    page.minify = ctx->config->enable_minify;
+    if (!output_stream_open(&page.file, output_path, ctx->config->chunk_size * 1024)) {
+        post_error(ctx, GEN_ERROR_IO, "Could not write %s (%s)", output_path, strerror(errno));
+        destroy_parser_context(parser_ctx);
+        mem_free(MEM_OUTPUT, output_path);
+        return 0;
+    }
+    if (page.minify) minifier_init(&page.minifier, stream_to_file, &page.file);
+    
+    log_debug("Streaming %zu bytes to %s", length, output_path);
+    const CompiledTemplate* tpl = ctx->post_template;
+    int success = 1;
+    ProfileSpan span = profile_begin(PROFILE_PARSE, current_post);
+    for (int i = 0; i < tpl->segment_count && success; i++) {
+        const TemplateSegment* segment = &tpl->segments[i];
+        if (segment->type == TPL_LITERAL) {
+            stream_page(&page, segment->text, segment->length);
+        } else if (segment->type == TPL_CONTENT) {
+            // 模板中每个 {{content}} 都重新解析一遍，源文件是映射的，不需要缓存结果
+            success = parse_markdown_streaming(parser_ctx, markdown_content, length, stream_page, &page);
+            if (post_cancelled(ctx, "parse")) {
+                success = 0;
+            } else if (!success) {
+                post_error(ctx, GEN_ERROR_MEMORY, "Could not parse markdown content");
+            } else if (!parser_ctx->block_count) {
+                post_error(ctx, GEN_ERROR_MEMORY, "Could not generate HTML content");
+                success = 0;
+            }
+        } else {
+            const char* value = template_value(segment, NULL, metadata);
+            if (value) stream_page(&page, value, strlen(value));
+        }
+    }
+    profile_end(&span);
+    
+    if (success) {
+        if (page.minify) minifier_finish(&page.minifier);
+        span = profile_begin(PROFILE_WRITE, current_post);
+        WriteResult written = output_stream_commit(&page.file, &ctx->writes);
+        profile_end(&span);
+        note_rewritten(ctx, output_path, written);
+        success = written != WRITE_FAILED;
+        if (!success) post_error(ctx, GEN_ERROR_IO, "Could not write %s (%s)", output_path, strerror(errno));
+    } else {
+        output_stream_abort(&page.file);
+    }
+    
+    destroy_parser_context(parser_ctx);
+    mem_free(MEM_OUTPUT, output_path);
+    return success;
+}
+
+// 输出转义后的HTML文本
+static void write_escaped(OutputBuffer* out, const char* str) {
+    const char* run = str;
+    for (const char* p = str; *p; p++) {
+        const char* entity;
+        switch (*p) {
+            case '<': entity = "&lt;"; break;
+            case '>': entity = "&gt;"; break;
+            case '&': entity = "&amp;"; break;
+            case '"': entity = "&quot;"; break;
+            default: continue;
+        }
+        output_append(out, run, p - run);
+        output_puts(out, entity);
+        run = p + 1;
+    }
+    output_puts(out, run);
+}
+
+// 按日期倒序比较目录条目，无日期的排在最后
+static int compare_entries_by_date(const void* a, const void* b) {
+    const CatalogEntry* ea = *(const CatalogEntry* const*)a;
+    const CatalogEntry* eb = *(const CatalogEntry* const*)b;
+    const char* da = ea->metadata ? ea->metadata->date : NULL;
+    const char* db = eb->metadata ? eb->metadata->date : NULL;
+    
+    if (!da || !db) {
+        if (da != db) return da ? -1 : 1;
+    } else {
+        int cmp = strcmp(db, da);
+        if (cmp != 0) return cmp;
+    }
+    return strcmp(ea->source_path, eb->source_path);
+}
+
+// 返回按日期排序的目录条目指针数组，调用者负责释放
+static CatalogEntry** sorted_catalog(GeneratorContext* ctx) {
+    CatalogEntry** sorted = mem_malloc(MEM_CATALOG, (ctx->catalog.count + 1) * sizeof(CatalogEntry*));
+    if (!sorted) return NULL;
+    
+    for (int i = 0; i < ctx->catalog.count; i++) {
+        sorted[i] = &ctx->catalog.entries[i];
+    }
+    qsort(sorted, ctx->catalog.count, sizeof(CatalogEntry*), compare_entries_by_date);
+    return sorted;
+}
+
+// 输出一个文章链接列表项
+static void write_post_link(OutputBuffer* out, const CatalogEntry* entry, const char* prefix) {
+    const PostMetadata* metadata = entry->metadata;
+    
+    output_printf(out, "<li><a href=\"%s", prefix);
+    write_escaped(out, entry->output_name);
+    output_printf(out, "\">");
+    write_escaped(out, metadata && metadata->title ? metadata->title : entry->output_name);
+    output_printf(out, "</a>");
+    if (metadata && metadata->date) {
+        output_printf(out, " <small>");
+        write_escaped(out, metadata->date);
+        output_printf(out, "</small>");
+    }
+    output_printf(out, "</li>\n");
+}
+
+// 生成索引页面
+int generate_index_page(GeneratorContext* ctx) {
+    if (!ctx || !ctx->config) {
+        if (ctx) ctx->last_error = GEN_ERROR_MEMORY;
+        return 0;
+    }
+    
+    char* index_path = join_path(ctx->output_dir, "index.html");
+    if (!index_path) {
+        ctx->last_error = GEN_ERROR_MEMORY;
+        return 0;
+    }
+    
+    CatalogEntry** sorted = sorted_catalog(ctx);
+    if (!sorted) {
+        mem_free(MEM_OUTPUT, index_path);
+        ctx->last_error = GEN_ERROR_MEMORY;
+        return 0;
+    }
+    
+    OutputBuffer out;
+    HtmlMinifier minifier;
+    begin_html_page(ctx, &out, &minifier);
+    
+    output_printf(&out, "<!DOCTYPE html>\n");
+    output_printf(&out, "<html>\n<head>\n");
+    output_printf(&out, "<title>%s</title>\n", ctx->config->blog_title);
+    output_printf(&out, "</head>\n<body>\n");
+    output_printf(&out, "<h1>%s</h1>\n", ctx->config->blog_title);
+    output_printf(&out, "<ul>\n");
+    for (int i = 0; i < ctx->catalog.count; i++) {
+        write_post_link(&out, sorted[i], "");
+    }
+    output_printf(&out, "</ul>\n");
+    output_printf(&out, "</body>\n</html>\n");
+    
+    int result = commit_page(ctx, &out, index_path);
+    mem_free(MEM_CATALOG, sorted);
+    mem_free(MEM_OUTPUT, index_path);
+    return result;
+}
+
+// 根据标签名生成安全的文件名
+static void build_tag_file_name(const char* tag_name, char* file_name, size_t size) {
+    size_t j = 0;
+    for (const char* p = tag_name; *p && j + 6 < size; p++) {
+        unsigned char c = (unsigned char)*p;
+        file_name[j++] = (c >= 0x80 || isalnum(c) || c == '-' || c == '_') ? (char)c : '-';
+    }
+    strcpy(file_name + j, ".html");
+}
+
+static char* tag_page_path(GeneratorContext* ctx, const char* tag_name) {
+    char file_name[256];
+    char relative[300];
+    
+    build_tag_file_name(tag_name, file_name, sizeof(file_name));
+    snprintf(relative, sizeof(relative), "tags%c%s", PATH_SEPARATOR, file_name);
+    return join_path(ctx->output_dir, relative);
+}
+
+// 生成单个标签页面
+int generate_tag_page(GeneratorContext* ctx, const TagEntry* tag) {
+    if (!ctx || !tag) return 0;
+    
+    char* tag_path = tag_page_path(ctx, tag->name);
+    if (!tag_path) {
+        ctx->last_error = GEN_ERROR_MEMORY;
+        return 0;
+    }
+    
+    OutputBuffer out;
+    HtmlMinifier minifier;
+    begin_html_page(ctx, &out, &minifier);
+    
+    output_printf(&out, "<html><body><h1>");
+    write_escaped(&out, tag->name);
+    output_printf(&out, "</h1>\n<ul>\n");
+    for (int i = 0; i < tag->count; i++) {
+        write_post_link(&out, &ctx->catalog.entries[tag->posts[i]], "../");
+    }
+    output_printf(&out, "</ul>\n</body></html>\n");
+    
+    int result = commit_page(ctx, &out, tag_path);
+    mem_free(MEM_OUTPUT, tag_path);
+    return result;
+}
+
+// 删除不再使用的标签页面
+int remove_tag_page(GeneratorContext* ctx, const char* tag_name) {
+    if (!ctx || !tag_name) return 0;
+    
+    char* tag_path = tag_page_path(ctx, tag_name);
+    if (!tag_path) return 0;
+    
+    int result = remove_page(tag_path);
+    mem_free(MEM_OUTPUT, tag_path);
+    return result;
+}
+
+// 生成标签页面
+int generate_tag_pages(GeneratorContext* ctx) {
+    if (!ctx) return 0;
+    
+    char* tags_dir = join_path(ctx->output_dir, "tags");
+    if (!tags_dir) {
+        ctx->last_error = GEN_ERROR_MEMORY;
+        return 0;
+    }
+    
+    int result = MKDIR(tags_dir) == 0 || errno == EEXIST;
+    mem_free(MEM_OUTPUT, tags_dir);
+    if (!result) {
+        ctx->last_error = GEN_ERROR_IO;
+        return 0;
+    }
+    
+    rebuild_tag_index(ctx);
+    for (int i = 0; i < ctx->tag_index.count; i++) {
+        if (!generate_tag_page(ctx, &ctx->tag_index.tags[i])) return 0;
+    }
+    return 1;
+}
+
+// 生成归档页面
+int generate_archive_page(GeneratorContext* ctx) {
+    if (!ctx) return 0;
+    
+    char* archive_path = join_path(ctx->output_dir, "archive.html");
+    if (!archive_path) {
+        ctx->last_error = GEN_ERROR_MEMORY;
+        return 0;
+    }
+    
+    CatalogEntry** sorted = sorted_catalog(ctx);
+    if (!sorted) {
+        mem_free(MEM_OUTPUT, archive_path);
+        ctx->last_error = GEN_ERROR_MEMORY;
+        return 0;
+    }
+    
+    OutputBuffer out;
+    HtmlMinifier minifier;
+    begin_html_page(ctx, &out, &minifier);
+    
+    output_printf(&out, "<html><body><h1>Archives</h1>\n<ul>\n");
+    for (int i = 0; i < ctx->catalog.count; i++) {
+        write_post_link(&out, sorted[i], "");
+    }
+    output_printf(&out, "</ul>\n</body></html>\n");
+    
+    int result = commit_page(ctx, &out, archive_path);
+    mem_free(MEM_CATALOG, sorted);
+    mem_free(MEM_OUTPUT, archive_path);
+    return result;
+}
+
+// 生成RSS订阅
+int generate_rss_feed(GeneratorContext* ctx) {
+    if (!ctx || !ctx->config) return 0;
+    
+    char* rss_path = join_path(ctx->output_dir, "feed.xml");
+    if (!rss_path) {
+        ctx->last_error = GEN_ERROR_MEMORY;
+        return 0;
+    }
+    
+    CatalogEntry** sorted = sorted_catalog(ctx);
+    if (!sorted) {
+        mem_free(MEM_OUTPUT, rss_path);
+        ctx->last_error = GEN_ERROR_MEMORY;
+        return 0;
+    }
+    
+    OutputBuffer out;
+    output_init(&out);
+    
+    output_printf(&out, "<?xml version=\"1.0\" encoding=\"UTF-8\" ?>\n");
+    output_printf(&out, "<rss version=\"2.0\">\n");
+    output_printf(&out, "<channel>\n");
+    output_printf(&out, "    <title>%s</title>\n", ctx->config->blog_title);
+    output_printf(&out, "    <link>%s</link>\n", ctx->config->base_url);
+    output_printf(&out, "    <description>%s</description>\n", ctx->config->blog_description);
+    output_printf(&out, "    <language>en-us</language>\n");
+    output_printf(&out, "    <pubDate>%s</pubDate>\n", "Mon, 01 Jan 2024 00:00:00 GMT");
+    for (int i = 0; i < ctx->catalog.count; i++) {
+        const CatalogEntry* entry = sorted[i];
+        const PostMetadata* metadata = entry->metadata;
+        
+        output_printf(&out, "    <item>\n");
+        output_printf(&out, "        <title>");
+        write_escaped(&out, metadata && metadata->title ? metadata->title : entry->output_name);
+        output_printf(&out, "</title>\n");
+        output_printf(&out, "        <link>%s/", ctx->config->base_url);
+        write_escaped(&out, entry->output_name);
+        output_printf(&out, "</link>\n");
+        if (metadata && metadata->description) {
+            output_printf(&out, "        <description>");
+            write_escaped(&out, metadata->description);
+            output_printf(&out, "</description>\n");
+        }
+        output_printf(&out, "    </item>\n");
+    }
+    output_printf(&out, "</channel>\n");
+    output_printf(&out, "</rss>\n");
+    
+    int result = commit_page(ctx, &out, rss_path);
+    mem_free(MEM_CATALOG, sorted);
+    mem_free(MEM_OUTPUT, rss_path);
+    return result;
+}
+
+// 生成站点地图
+int generate_sitemap(GeneratorContext* ctx) {
+    if (!ctx) return 0;
+    
+    char* sitemap_path = join_path(ctx->output_dir, "sitemap.xml");
+    if (!sitemap_path) {
+        ctx->last_error = GEN_ERROR_MEMORY;
+        return 0;
+    }
+    
+    OutputBuffer out;
+    output_init(&out);
+    
+    output_printf(&out, "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n");
+    output_printf(&out, "<urlset xmlns=\"http://www.sitemaps.org/schemas/sitemap/0.9\">\n");
+    for (int i = 0; i < ctx->catalog.count; i++) {
+        output_printf(&out, "    <url><loc>%s/", ctx->config->base_url);
+        write_escaped(&out, ctx->catalog.entries[i].output_name);
+        output_printf(&out, "</loc></url>\n");
+    }
+    output_printf(&out, "</urlset>\n");
+    
+    int result = commit_page(ctx, &out, sitemap_path);
+    mem_free(MEM_OUTPUT, sitemap_path);
+    return result;
+}
+
+// 生成所有列表页面
+int generate_list_pages(GeneratorContext* ctx) {
+    int result = generate_index_page(ctx) &&
+                 generate_tag_pages(ctx) &&
+                 generate_archive_page(ctx) &&
+                 generate_rss_feed(ctx) &&
+                 generate_sitemap(ctx);
+    return flush_output(ctx) && result;
+}
+
+// 模板占位符表
+static const struct {
+    const char* name;
+    TemplateSegmentType type;
+} template_placeholders[] = {
+    {"content", TPL_CONTENT},
+    {"title", TPL_TITLE},
+    {"date", TPL_DATE},
+    {"author", TPL_AUTHOR},
+    {"description", TPL_DESCRIPTION}
+};
+
+static int add_template_segment(CompiledTemplate* tpl, int* capacity,
+                                TemplateSegmentType type, const char* text, size_t length) {
+    if (type == TPL_LITERAL && length == 0) return 1;
+    
+    if (tpl->segment_count == *capacity) {
+        int new_capacity = *capacity ? *capacity * 2 : 16;
+        TemplateSegment* segments = mem_realloc(MEM_RENDER, tpl->segments, new_capacity * sizeof(TemplateSegment));
+        if (!segments) return 0;
+        tpl->segments = segments;
+        *capacity = new_capacity;
+    }
+    
+    TemplateSegment* segment = &tpl->segments[tpl->segment_count++];
+    segment->type = type;
+    segment->text = text;
+    segment->length = length;
+    if (type == TPL_LITERAL) tpl->literal_length += length;
+    return 1;
+}
+
+// 解析 {{asset:路径}} 占位符，结果作为字面量保存在模板中
+static const char* resolve_asset_placeholder(CompiledTemplate* tpl, const AssetManifest* assets,
+                                             const char* path, size_t path_len) {
+    char** owned = mem_realloc(MEM_RENDER, tpl->owned_strings, (tpl->owned_count + 1) * sizeof(char*));
+    if (!owned) return NULL;
+    tpl->owned_strings = owned;
+    
+    char* name = copy_string(MEM_RENDER, path, path_len);
+    if (!name) return NULL;
+    
+    const char* hashed = lookup_asset(assets, name);
+    size_t size = strlen("assets/") + strlen(hashed ? hashed : name) + 1;
+    char* url = mem_malloc(MEM_RENDER, size);
+    if (url) snprintf(url, size, "assets/%s", hashed ? hashed : name);
+    mem_free(MEM_RENDER, name);
+    
+    if (url) owned[tpl->owned_count++] = url;
+    return url;
+}
+
+// 编译模板：一次性把模板切分为字面量和占位符片段
+CompiledTemplate* compile_template(const char* template_content) {
+    return compile_template_with_assets(template_content, NULL);
+}
+
+CompiledTemplate* compile_template_with_assets(const char* template_content, const AssetManifest* assets) {
+    if (!template_content) return NULL;
+    
+    CompiledTemplate* tpl = mem_calloc(MEM_RENDER, 1, sizeof(CompiledTemplate));
+    if (!tpl) return NULL;
+    
+    tpl->source = mem_strdup(MEM_RENDER, template_content);
+    if (!tpl->source) {
+        mem_free(MEM_RENDER, tpl);
+        return NULL;
+    }
+    
+    int capacity = 0;
+    const char* literal = tpl->source;
+    const char* ptr = tpl->source;
+    
+    while ((ptr = strstr(ptr, "{{")) != NULL) {
+        const char* name = ptr + 2;
+        const char* close = strstr(name, "}}");
+        if (!close) break;
+        
+        while (name < close && isspace((unsigned char)*name)) name++;
+        const char* name_end = close;
+        while (name_end > name && isspace((unsigned char)name_end[-1])) name_end--;
+        
+        TemplateSegmentType type = TPL_LITERAL;
+        for (size_t i = 0; i < sizeof(template_placeholders)/sizeof(template_placeholders[0]); i++) {
+            size_t len = strlen(template_placeholders[i].name);
+            if ((size_t)(name_end - name) == len &&
+                strncmp(name, template_placeholders[i].name, len) == 0) {
+                type = template_placeholders[i].type;
+                break;
             }
-            template_ptr += 10;
-        } else if (strncmp(template_ptr, "{{description}}", 14) == 0) {
-            if (metadata->description) {
-                strcpy(current, metadata->description);
-                current += strlen(metadata->description);
+        }
+        
+        const char* resolved = NULL;
+        if (type == TPL_LITERAL && name_end - name > 6 && strncmp(name, "asset:", 6) == 0) {
+            resolved = resolve_asset_placeholder(tpl, assets, name + 6, name_end - name - 6);
+            if (!resolved) {
+                destroy_template(tpl);
+                return NULL;
             }
-            template_ptr += 14;
-        } else if (strncmp(template_ptr, "}}", 2) == 0) {
-            // Skip closing brackets
-            template_ptr += 2;
+        } else if (type == TPL_LITERAL) {
+            // 未知占位符按原样保留
+            ptr += 2;
+            continue;
+        }
+        
+        if (!add_template_segment(tpl, &capacity, TPL_LITERAL, literal, ptr - literal) ||
+            !add_template_segment(tpl, &capacity, type, resolved, resolved ? strlen(resolved) : 0)) {
+            destroy_template(tpl);
+            return NULL;
+        }
+        ptr = close + 2;
+        literal = ptr;
+    }
+    
+    if (!add_template_segment(tpl, &capacity, TPL_LITERAL, literal, strlen(literal))) {
+        destroy_template(tpl);
+        return NULL;
+    }
+    
+    return tpl;
+}
+
+static const char* template_value(const TemplateSegment* segment, const char* content,
+                                  const PostMetadata* metadata) {
+    switch (segment->type) {
+        case TPL_CONTENT: return content;
+        case TPL_TITLE: return metadata->title;
+        case TPL_DATE: return metadata->date;
+        case TPL_AUTHOR: return metadata->author;
+        case TPL_DESCRIPTION: return metadata->description;
+        default: return NULL;
+    }
+}
+
+// 渲染编译后的模板，结果一次分配到位
+char* render_template(const CompiledTemplate* tpl, const char* content, const PostMetadata* metadata) {
+    if (!tpl || !content || !metadata) return NULL;
+    
+    size_t total = tpl->literal_length;
+    for (int i = 0; i < tpl->segment_count; i++) {
+        const TemplateSegment* segment = &tpl->segments[i];
+        if (segment->type == TPL_LITERAL) continue;
+        const char* value = template_value(segment, content, metadata);
+        if (value) total += strlen(value);
+    }
+    
+    char* result = mem_malloc(MEM_OUTPUT, total + 1);
+    if (!result) return NULL;
+    
+    char* current = result;
+    for (int i = 0; i < tpl->segment_count; i++) {
+        const TemplateSegment* segment = &tpl->segments[i];
+        if (segment->type == TPL_LITERAL) {
+            memcpy(current, segment->text, segment->length);
+            current += segment->length;
         } else {
-            *current++ = *template_ptr++;
+            const char* value = template_value(segment, content, metadata);
+            if (value) {
+                size_t len = strlen(value);
+                memcpy(current, value, len);
+                current += len;
+            }
         }
     }
     *current = '\0';
@@ -623,6 +1861,80 @@ char* apply_template(const char* template_content, const char* content, const Po
     return result;
 }
 
+void destroy_template(CompiledTemplate* tpl) {
+    if (tpl) {
+        for (int i = 0; i < tpl->owned_count; i++) {
+            mem_free(MEM_RENDER, tpl->owned_strings[i]);
+        }
+        mem_free(MEM_RENDER, tpl->owned_strings);
+        mem_free(MEM_RENDER, tpl->segments);
+        mem_free(MEM_RENDER, tpl->source);
+        mem_free(MEM_RENDER, tpl);
+    }
+}
+
+// 读取并编译文章模板，替换上下文中已有的模板
+int load_post_template(GeneratorContext* ctx) {
+    if (!ctx) return 0;
+    
+    char* template_path = join_path(ctx->template_dir ? ctx->template_dir : "templates", "post.html");
+    if (!template_path) {
+        ctx->last_error = GEN_ERROR_MEMORY;
+        return 0;
+    }
+    
+    SourceFile source;
+    if (!source_open(&source, template_path)) {
+        log_error("Could not open file %s", template_path);
+        mem_free(MEM_OUTPUT, template_path);
+        ctx->last_error = GEN_ERROR_IO;
+        return 0;
+    }
+    mem_free(MEM_OUTPUT, template_path);
+    
+    // 模板编译需要以 '\0' 结尾的文本，只在加载时复制一次
+    char* template_content = copy_string(MEM_RENDER, source.data, source.length);
+    source_close(&source);
+    if (!template_content) {
+        ctx->last_error = GEN_ERROR_MEMORY;
+        return 0;
+    }
+    
+    // 样式在编译时提取一次，之后每篇文章只包含一个 <link>
+    if (ctx->config->extract_styles) {
+        char* extracted = extract_template_styles(ctx, template_content);
+        mem_free(MEM_RENDER, template_content);
+        if (!extracted) {
+            if (ctx->last_error == GEN_SUCCESS) ctx->last_error = GEN_ERROR_MEMORY;
+            return 0;
+        }
+        template_content = extracted;
+    }
+    
+    CompiledTemplate* tpl = compile_template_with_assets(template_content, &ctx->assets);
+    mem_free(MEM_RENDER, template_content);
+    if (!tpl) {
+        ctx->last_error = GEN_ERROR_MEMORY;
+        return 0;
+    }
+    
+    destroy_template(ctx->post_template);
+    ctx->post_template = tpl;
+    return 1;
+}
+
+// 模板处理函数
+char* apply_template(const char* template_content, const char* content, const PostMetadata* metadata) {
+    if (!template_content || !content || !metadata) return NULL;
+    
+    CompiledTemplate* tpl = compile_template(template_content);
+    if (!tpl) return NULL;
+    
+    char* result = render_template(tpl, content, metadata);
+    destroy_template(tpl);
+    return result;
+}
+
 // 错误处理函数
 GeneratorError get_last_error(GeneratorContext* ctx) {
     return ctx ? ctx->last_error : GEN_ERROR_MEMORY;
@@ -640,27 +1952,13 @@ const char* get_error_message(GeneratorError error) {
             return "I/O operation failed";
         case GEN_ERROR_NETWORK:
             return "Network operation failed";
+        case GEN_ERROR_ENCODING:
+            return "Invalid UTF-8 input";
         default:
             return "Unknown error";
     }
 }
 
-// 超时检查函数
-int has_operation_timeout(GeneratorContext* ctx) {
-    if (!ctx || ctx->config->timeout_seconds <= 0) return 0;
-    return (time(NULL) - ctx->start_time) > ctx->config->timeout_seconds;
-}
-
-// 重试延迟函数
-void sleep_with_backoff(int retry_count, int base_delay) {
-    int delay = base_delay * (1 << (retry_count - 1));
-#ifdef _WIN32
-    Sleep(delay * 1000);
-#else
-    sleep(delay);
-#endif
-}
-
 // 增量构建检查
 int needs_rebuild(const char* source_file, const char* target_file) {
     struct stat source_stat, target_stat;
@@ -676,105 +1974,206 @@ int needs_rebuild(const char* source_file, const char* target_file) {
     return source_stat.st_mtime > target_stat.st_mtime;
 }
 
-// 文件压缩函数
-int compress_file(const char* input_path, const char* output_path) {
-    char cmd[512];
-#ifdef _WIN32
-    snprintf(cmd, sizeof(cmd), "powershell Compress-Archive -Path \"%s\" -DestinationPath \"%s.zip\"",
-             input_path, output_path);
-#else
-    snprintf(cmd, sizeof(cmd), "gzip -9 -c \"%s\" > \"%s.gz\"", input_path, output_path);
-#endif
-    return system(cmd) == 0;
+// 将渲染成功的文章写入目录，必要时清理旧的输出文件
+// output_name 为 claim_output_name 登记的文件名；source 为读取之前取得的大小和修改时间，
+// 为 NULL 表示只读取了元数据，不更新大小和修改时间
+static int update_catalog_entry(GeneratorContext* ctx, const char* post_path, PostMetadata* metadata,
+                                const char* output_name, const ScanEntry* source) {
+    lock_catalog(ctx);
+    CatalogEntry* entry = find_catalog_entry(ctx, post_path);
+    if (!entry) {
+        entry = add_catalog_entry(&ctx->catalog, post_path);
+        if (!entry) {
+            unlock_catalog(ctx);
+            free_post_metadata(metadata);
+            return 0;
+        }
+        ctx->catalog_changed = 1;
+    } else if (!entry->metadata || !metadata_equal(entry->metadata, metadata)) {
+        ctx->catalog_changed = 1;
+    }
+    
+    // 标题变化后删除旧页面，但旧文件名可能已经分配给了其他文章
+    if (entry->output_name && strcmp(entry->output_name, output_name) != 0 &&
+        owns_output_name(ctx, entry->output_name, post_path)) {
+        char* old_path = join_path(ctx->output_dir, entry->output_name);
+        if (old_path) {
+            remove_page(old_path);
+            mem_free(MEM_OUTPUT, old_path);
+        }
+        release_output_name(ctx, entry->output_name, post_path);
+    }
+    
+    free_catalog_string(ctx, entry->output_name);
+    entry->output_name = mem_strdup(MEM_CATALOG, output_name);
+    free_catalog_metadata(ctx, entry->metadata);
+    entry->metadata = metadata;
+    
+    // 只读取了元数据时保留上次渲染时记录的大小和修改时间：页面仍对应那个版本，
+    // 下次增量构建只重新渲染真正变化的文章；新加入目录的文章没有记录，下次会渲染。
+    // 页面还在批量写出队列中时，flush 失败会设置 write_failed，此时清空记录。
+    // 渲染后记录的是读取之前的大小和修改时间：读取期间文件又被改写时，下次构建会再渲染一次
+    const OutputNameSlot* slot = ctx->output_names.slots ? find_output_name(&ctx->output_names, output_name) : NULL;
+    if (slot && slot->write_failed) {
+        entry->size = 0;
+        entry->mtime_ns = 0;
+    } else if (source) {
+        entry->size = source->size;
+        entry->mtime_ns = source->mtime_ns;
+    }
+    int result = entry->output_name != NULL;
+    unlock_catalog(ctx);
+    return result;
 }
 
-// 读取UTF-8文件
-static char* read_utf8_file(const char* path, size_t* size_out) {
-    if (!path || !size_out) return NULL;
+// 处理单个文章；scanned 的大小和修改时间必须在读取文件之前取得
+static int process_scanned_post(GeneratorContext* ctx, const ScanEntry* scanned) {
+    const char* post_path = scanned ? scanned->path : NULL;
+    if (!ctx || !post_path) {
+        log_error("Invalid context or post path");
+        if (ctx) ctx->last_error = GEN_ERROR_MEMORY;
+        return 0;
+    }
     
-    FILE* fp = fopen(path, "rb");
-    if (!fp) {
-        printf("Error: Could not open file %s\n", path);
-        return NULL;
+    log_debug("Opening file: %s", post_path);
+    
+    // 源文件只读映射（小文件读入线程内缓冲区），解析器直接处理其中的文本
+    SourceFile source;
+    ProfileSpan span = profile_begin(PROFILE_READ, post_path);
+    if (!source_open(&source, post_path)) {
+        post_error(ctx, GEN_ERROR_IO, "Could not read file (%s)", strerror(errno));
+        return 0;
+    }
+    if (post_cancelled(ctx, "read")) {
+        source_close(&source);
+        return 0;
     }
     
-    // Get file size
-    fseek(fp, 0, SEEK_END);
-    long size = ftell(fp);
-    rewind(fp);
+    // 校验 UTF-8 并建立行索引，非法文件直接报告位置，而不是生成损坏的HTML；
+    // 超过 chunk_size 的文章流式生成，只校验不建立行索引
+    size_t stream_threshold = ctx->config->chunk_size * 1024;
+    int streaming = stream_threshold && source.length > stream_threshold;
+    int scan = streaming ? source_validate_utf8(&source) : source_index_lines(&source);
+    profile_end(&span);
+    if (scan != 1) {
+        if (scan == 0) {
+            size_t line = 1;
+            for (const char* p = source.data; (p = memchr(p, '\n', source.data + source.error_offset - p)) != NULL; p++) {
+                line++;
+            }
+            post_error(ctx, GEN_ERROR_ENCODING, "Invalid UTF-8 at line %zu (byte offset %zu)",
+                       line, source.error_offset);
+        } else {
+            post_error(ctx, GEN_ERROR_MEMORY, "Out of memory while indexing lines");
+        }
+        source_close(&source);
+        return 0;
+    }
     
-    // Allocate memory
-    char* content = malloc(size + 1);
-    if (!content) {
-        printf("Error: Could not allocate memory for file content\n");
-        fclose(fp);
-        return NULL;
+    if (streaming) {
+        log_debug("File size: %zu bytes, streaming", source.length);
+    } else {
+        log_debug("File size: %zu bytes, %zu line(s)", source.length, source.lines.count);
     }
+    log_debug("File content preview: %.*s...", (int)(source.length < 100 ? source.length : 100), source.data);
     
-    // Read file content
-    size_t read_size = fread(content, 1, size, fp);
-    fclose(fp);
+    log_debug("Extracting metadata...");
+    span = profile_begin(PROFILE_FRONT_MATTER, post_path);
+    PostMetadata* metadata = extract_post_metadata_span(source.data, source.length);
+    profile_end(&span);
+    if (!metadata) {
+        post_error(ctx, GEN_ERROR_MEMORY, "Could not extract metadata from file");
+        source_close(&source);
+        return 0;
+    }
+    if (post_cancelled(ctx, "front matter")) {
+        free_post_metadata(metadata);
+        source_close(&source);
+        return 0;
+    }
     
-    if (read_size != (size_t)size) {
-        printf("Error: Could not read entire file (read %zu of %ld bytes)\n", read_size, size);
-        free(content);
-        return NULL;
+    char output_name[512];
+    if (!claim_output_name(ctx, post_path, metadata, output_name, sizeof(output_name))) {
+        post_error(ctx, GEN_ERROR_MEMORY, "Could not allocate an output file name");
+        free_post_metadata(metadata);
+        source_close(&source);
+        return 0;
     }
     
-    // Remove UTF-8 BOM if present
-    if (size >= 3 && 
-        (unsigned char)content[0] == 0xEF &&
-        (unsigned char)content[1] == 0xBB &&
-        (unsigned char)content[2] == 0xBF) {
-        memmove(content, content + 3, size - 3);
-        size -= 3;
+    log_debug("Generating post page...");
+    const char* outer_post = current_post;
+    current_post = post_path;
+    int result = streaming ?
+        generate_post_page_streaming(ctx, source.data, source.length, metadata, output_name) :
+        generate_post_page(ctx, source.data, source.length, &source.lines, metadata, output_name);
+    current_post = outer_post;
+    if (!result) {
+        log_debug("Failed to generate post page");
+        free_post_metadata(metadata);
+    } else if (!update_catalog_entry(ctx, post_path, metadata, output_name, scanned)) {
+        post_error(ctx, GEN_ERROR_MEMORY, "Could not update post catalog");
+        result = 0;
     }
     
-    // Ensure null termination
-    content[size] = '\0';
-    *size_out = size;
+    source_close(&source);
     
-    return content;
+    return result;
 }
 
-// 处理单个文章
-static int process_single_post(GeneratorContext* ctx, const char* post_path) {
+// 处理单个文章（监视模式等没有扫描结果的调用方）：先取得大小和修改时间再读取
+int process_single_post(GeneratorContext* ctx, const char* post_path) {
+    ScanEntry scanned = { (char*)post_path, 0, 0 };
+    struct stat st;
+    if (post_path && stat(post_path, &st) == 0) {
+        scanned.size = (long long)st.st_size;
+        scanned.mtime_ns = stat_mtime_ns(&st);
+    }
+    return process_scanned_post(ctx, &scanned);
+}
+
+// 只读取文章的 front matter 并更新目录，不读取和渲染正文
+// 返回 1 成功，0 失败，-1 表示输出页面不存在，需要完整渲染
+int process_post_metadata(GeneratorContext* ctx, const char* post_path) {
     if (!ctx || !post_path) {
-        printf("Error: Invalid context or post path\n");
         if (ctx) ctx->last_error = GEN_ERROR_MEMORY;
         return 0;
     }
     
-    printf("Opening file: %s\n", post_path);
-    
-    size_t content_size;
-    char* content = read_utf8_file(post_path, &content_size);
-    if (!content) {
-        printf("Error: Could not read file (errno: %d)\n", errno);
-        ctx->last_error = GEN_ERROR_IO;
+    SourceFile source;
+    ProfileSpan span = profile_begin(PROFILE_READ, post_path);
+    int opened = source_open_header(&source, post_path);
+    profile_end(&span);
+    if (!opened) {
+        post_error(ctx, GEN_ERROR_IO, "Could not read file %s (%s)", post_path, strerror(errno));
         return 0;
     }
     
-    printf("File size: %zu bytes\n", content_size);
-    printf("File content preview: %.100s...\n", content);
-    
-    printf("Extracting metadata...\n");
-    PostMetadata* metadata = extract_post_metadata(content);
+    span = profile_begin(PROFILE_FRONT_MATTER, post_path);
+    PostMetadata* metadata = extract_post_metadata_span(source.data, source.length);
+    profile_end(&span);
+    source_close(&source);
     if (!metadata) {
-        printf("Error: Could not extract metadata from file\n");
-        free(content);
-        ctx->last_error = GEN_ERROR_MEMORY;
+        post_error(ctx, GEN_ERROR_MEMORY, "Could not extract metadata from %s", post_path);
         return 0;
     }
     
-    printf("Generating post page...\n");
-    int result = generate_post_page(ctx, content, metadata);
-    if (!result) {
-        printf("Error: Failed to generate post page\n");
+    char output_name[512];
+    if (!claim_output_name(ctx, post_path, metadata, output_name, sizeof(output_name))) {
+        post_error(ctx, GEN_ERROR_MEMORY, "Could not allocate an output file name");
+        free_post_metadata(metadata);
+        return 0;
+    }
+    char* output_path = join_path(ctx->output_dir, output_name);
+    int exists = output_path && file_exists(output_path);
+    mem_free(MEM_OUTPUT, output_path);
+    if (!exists) {
+        free_post_metadata(metadata);
+        return -1;
     }
     
-    free(metadata);
-    free(content);
-    
-    return result;
+    if (!update_catalog_entry(ctx, post_path, metadata, output_name, NULL)) {
+        post_error(ctx, GEN_ERROR_MEMORY, "Could not update post catalog");
+        return 0;
+    }
+    return 1;
 }
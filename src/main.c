@@ -14,25 +14,137 @@
 
 #include "../include/generator.h"
 #include "../include/parser.h"
+#include "../include/watch.h"
+#include "../include/server.h"
+#include "../include/compress.h"
+#include "../include/utils.h"
+#include "../include/assets.h"
+#include "../include/catalog.h"
+#include "../include/profile.h"
+#include "../include/memstats.h"
+#include "../include/render_server.h"
+#include "../include/source.h"
+
+// 单篇文章默认的处理时间预算
+#define DEFAULT_POST_BUDGET_MS 10000
+// 超过该大小(KB)的文章流式生成
+#define DEFAULT_CHUNK_SIZE_KB 4096
+// 渲染服务的工作线程数
+#define DEFAULT_RENDER_WORKERS 4
+
+static void print_usage(const char* program) {
+    printf("Usage: %s [--watch] [--serve] [--port N] [--link-assets] [--minify] [--inline-css SELECTORS] [--io-uring] [--list-only] [--post-budget MS] [--chunk-size KB] [--quiet|--verbose] [--profile] [--mem-stats] <output_dir>\n", program);
+    printf("       %s --serve-render SOCKET_PATH [--post-budget MS] [--quiet|--verbose]\n", program);
+    printf("  --watch    Build once, then rebuild changed posts and templates\n");
+    printf("  --serve    Serve the output directory over HTTP after building\n");
+    printf("  --port N   Port for --serve (default: %d)\n", SERVER_DEFAULT_PORT);
+    printf("  --link-assets  Hard-link assets into the output instead of copying\n");
+    printf("  --minify   Minify generated HTML pages (posts, index, tags, archive)\n");
+    printf("  --inline-css SELECTORS  Keep rules for these selectors inline (comma-separated)\n");
+    printf("  --io-uring Batch output writes through io_uring (Linux)\n");
+    printf("  --list-only  Rebuild list pages from front matter without rendering posts\n");
+    printf("  --post-budget MS  Time budget per post, 0 for none (default: %d)\n", DEFAULT_POST_BUDGET_MS);
+    printf("  --chunk-size KB  Stream posts larger than this instead of rendering them in memory, 0 to disable (default: %d)\n", DEFAULT_CHUNK_SIZE_KB);
+    printf("  --quiet    Only print warnings and errors\n");
+    printf("  --verbose  Also print each step of every post\n");
+    printf("  --profile    Record per-phase timings to %s and print the slowest posts\n", PROFILE_TRACE_FILE);
+    printf("  --mem-stats  Print per-subsystem allocation statistics on exit\n");
+    printf("  --serve-render PATH  Render markdown sent over a Unix socket instead of building the site\n");
+}
 
 int main(int argc, char* argv[]) {
-    if (argc != 2) {
-        printf("Usage: %s <output_dir>\n", argv[0]);
+    const char* output_dir = NULL;
+    int watch = 0;
+    int serve = 0;
+    int port = SERVER_DEFAULT_PORT;
+    int link_assets = 0;
+    int minify = 0;
+    const char* critical_css = NULL;
+    int io_uring = 0;
+    int list_only = 0;
+    int post_budget_ms = DEFAULT_POST_BUDGET_MS;
+    int chunk_size = DEFAULT_CHUNK_SIZE_KB;
+    int profile = 0;
+    const char* render_socket = NULL;
+    LogLevel level = LOG_LEVEL_INFO;
+#ifdef DEBUG
+    int mem_stats = 1;
+#else
+    int mem_stats = 0;
+#endif
+    
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--watch") == 0) {
+            watch = 1;
+        } else if (strcmp(argv[i], "--serve") == 0) {
+            serve = 1;
+        } else if (strcmp(argv[i], "--link-assets") == 0) {
+            link_assets = 1;
+        } else if (strcmp(argv[i], "--minify") == 0) {
+            minify = 1;
+        } else if (strcmp(argv[i], "--io-uring") == 0) {
+            io_uring = 1;
+        } else if (strcmp(argv[i], "--list-only") == 0) {
+            list_only = 1;
+        } else if (strcmp(argv[i], "--quiet") == 0) {
+            level = LOG_LEVEL_WARN;
+        } else if (strcmp(argv[i], "--verbose") == 0) {
+            level = LOG_LEVEL_DEBUG;
+        } else if (strcmp(argv[i], "--profile") == 0) {
+            profile = 1;
+        } else if (strcmp(argv[i], "--mem-stats") == 0) {
+            mem_stats = 1;
+        } else if (strcmp(argv[i], "--inline-css") == 0 && i + 1 < argc) {
+            critical_css = argv[++i];
+        } else if (strcmp(argv[i], "--post-budget") == 0 && i + 1 < argc) {
+            post_budget_ms = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--chunk-size") == 0 && i + 1 < argc) {
+            chunk_size = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--serve-render") == 0 && i + 1 < argc) {
+            render_socket = argv[++i];
+        } else if (strcmp(argv[i], "--port") == 0 && i + 1 < argc) {
+            port = atoi(argv[++i]);
+        } else if (argv[i][0] == '-' || output_dir) {
+            print_usage(argv[0]);
+            return 1;
+        } else {
+            output_dir = argv[i];
+        }
+    }
+    
+    // 渲染服务不构建站点，也不需要输出目录
+    if (render_socket) {
+        log_set_level(level);
+        RenderServerConfig render_config = {
+            .socket_path = render_socket,
+            .template_path = "templates/post.html",
+            .workers = DEFAULT_RENDER_WORKERS,
+            .budget_ms = post_budget_ms
+        };
+        int served = run_render_server(&render_config);
+        if (mem_stats) {
+            mem_stats_dump(stdout);
+        }
+        return served ? 0 : 1;
+    }
+    
+    if (!output_dir) {
+        print_usage(argv[0]);
         return 1;
     }
     
-    const char* output_dir = argv[1];
-    printf("Output directory: %s\n", output_dir);
+    log_set_level(level);
+    log_info("Output directory: %s", output_dir);
     
     // 创建输出目录
     if (mkdir(output_dir, 0755) != 0) {
         if (errno != EEXIST) {
-            printf("Error: Could not create output directory (errno: %d)\n", errno);
+            log_error("Could not create output directory (errno: %d)", errno);
             return 1;
         }
-        printf("Output directory already exists\n");
+        log_debug("Output directory already exists");
     } else {
-        printf("Created output directory\n");
+        log_debug("Created output directory");
     }
     
     // 创建博客配置
@@ -47,84 +159,151 @@ int main(int argc, char* argv[]) {
         .enable_compression = 1,
         .enable_incremental = 1,
         .parallel_workers = 4,
-        .chunk_size = 4096,
-        .timeout_seconds = 30,
+        .chunk_size = chunk_size > 0 ? (size_t)chunk_size : 0,
+        .post_budget_ms = post_budget_ms,
         .retry_count = 3,
-        .retry_delay = 1
+        .hard_link_assets = link_assets,
+        .enable_fingerprint = 1,
+        .enable_minify = minify,
+        .extract_styles = 1,
+        .critical_css = critical_css,
+        .use_io_uring = io_uring
     };
     
-    printf("Creating generator context...\n");
+    // 监视模式下文章会被原地改写，不映射文件
+    if (watch) {
+        source_set_mmap(0);
+    }
+    
+    // 工作线程创建之前开始计时
+    if (profile) {
+        profile_enable();
+    }
+    
+    log_debug("Creating generator context...");
     
     // 创建生成器上下文
     GeneratorContext* ctx = create_generator_context(&config, output_dir);
     if (!ctx) {
-        printf("Error: Could not create generator context\n");
+        log_error("Could not create generator context");
         return 1;
     }
     
-    printf("Creating directory structure...\n");
+    log_debug("Creating directory structure...");
     
     // 创建目录结构
     create_directory_structure(output_dir);
     
-    int success = 1;
-    int retry_count = 0;
+    // 映射上次构建的目录缓存：未变化的文章不再读取 front matter，也不重新渲染
+    if (config.enable_incremental) {
+        load_catalog_cache(ctx);
+    }
     
-    while (retry_count < config.retry_count) {
-        printf("Processing posts (attempt %d)...\n", retry_count + 1);
+    // 同步静态资源，未变化的文件直接跳过
+    if (file_exists("assets")) {
+        log_info("Syncing assets...");
+        char assets_dest[1024];
+        snprintf(assets_dest, sizeof(assets_dest), "%s/assets", output_dir);
         
-        // 处理文章
-        if (!process_posts(ctx, "posts")) {
-            GeneratorError error = get_last_error(ctx);
-            printf("Error processing posts: %s\n", get_error_message(error));
-            
-            if (error == GEN_ERROR_TIMEOUT) {
-                printf("Warning: Operation timed out, retrying...\n");
-                sleep_with_backoff(++retry_count, config.retry_delay);
-                continue;
-            } else {
-                printf("Error: %s\n", get_error_message(error));
-                success = 0;
-                break;
-            }
+        SyncStats stats;
+        if (!sync_directory("assets", assets_dest, ctx->workers, config.hard_link_assets, &stats)) {
+            log_warn("Some assets could not be synced");
         }
+        log_info("Assets: %d copied, %d linked, %d unchanged, %d failed",
+               stats.copied, stats.linked, stats.unchanged, stats.failed);
         
-        printf("Generating pages...\n");
+        // 模板通过 {{asset:路径}} 引用带指纹的文件名，需在渲染文章之前完成
+        if (config.enable_fingerprint) {
+            fingerprint_assets(ctx, "assets", assets_dest);
+        }
+    }
+    
+    int success = 1;
+    
+    // 处理文章；--list-only 时只读取 front matter，已有的文章页面保持不变
+    // 单篇文章失败不会中断构建，其余文章和列表页照常生成
+    log_info("Processing posts...");
+    int processed = list_only ? process_posts_metadata(ctx, "posts") : process_posts(ctx, "posts");
+    if (!processed) {
+        log_message(LOG_LEVEL_ERROR, "Error processing posts: %s", get_error_message(get_last_error(ctx)));
+        success = 0;
+    }
+    
+    if (success) {
+        log_info("Generating pages...");
         
         // 生成其他页面
-        if (!generate_index_page(ctx) ||
-            !generate_tag_pages(ctx) ||
-            !generate_archive_page(ctx) ||
-            !generate_rss_feed(ctx) ||
-            !generate_sitemap(ctx)) {
-            
-            GeneratorError error = get_last_error(ctx);
-            printf("Warning: Failed to generate pages (%s), retrying...\n",
-                   get_error_message(error));
-            sleep_with_backoff(++retry_count, config.retry_delay);
-            continue;
+        if (!generate_list_pages(ctx)) {
+            log_error("Failed to generate pages (%s)", get_error_message(get_last_error(ctx)));
+            success = 0;
         }
+    }
+    
+    if (success) {
+        // 内容未变的页面不会被重写，保持 mtime 以便 rsync/部署跳过
+        log_info("Output: %d file(s) written, %d unchanged, %d failed",
+               atomic_load(&ctx->writes.written), atomic_load(&ctx->writes.unchanged),
+               atomic_load(&ctx->writes.failed));
         
-        // 如果启用了压缩，压缩所有HTML和CSS文件
+        // 如果启用了压缩，在线程池上压缩所有HTML/XML/CSS/JS文件
         if (config.enable_compression) {
-            printf("Compressing static files...\n");
-            compress_file("public/style.css", "public/style.css");
-            // TODO: 压缩其他静态文件
+            log_info("Compressing static files...");
+            compress_site(ctx);
+        }
+    }
+    
+    // 只分析首次完整构建，之后的监视和预览不再记录
+    if (profile) {
+        profile_report(PROFILE_TRACE_FILE, PROFILE_TOP_POSTS);
+    }
+    
+    int failed_posts = report_post_failures(ctx);
+    if (success && !failed_posts) {
+        log_info("All operations completed successfully");
+    }
+    
+    // 预览服务器和监视模式：保留目录、标签索引和已编译模板，只重建变化的部分
+    if (success) {
+        if (serve) {
+            ServerConfig server_config = {
+                .root = output_dir,
+                .host = "127.0.0.1",
+                .port = port,
+                .watcher = watch ? watcher_create(ctx, "posts", "templates") : NULL
+            };
+            if (watch && !server_config.watcher) {
+                log_warn("Could not start watching, serving without rebuilds");
+            }
+            run_preview_server(&server_config);
+            watcher_destroy(server_config.watcher);
+        } else if (watch) {
+            run_watch_mode(ctx, "posts", "templates");
         }
-        
-        printf("All operations completed successfully\n");
-        break;  // 所有操作成功完成
+    }
+    
+    if (success && config.enable_incremental) {
+        save_catalog_cache(ctx);
     }
     
     // 清理资源
-    printf("Cleaning up...\n");
+    log_debug("Cleaning up...");
     destroy_generator_context(ctx);
+    profile_shutdown();
+    
+    // 统计一直在收集；清理之后仍未释放的字节数显示为 live
+    if (mem_stats) {
+        mem_stats_dump(stdout);
+    }
     
-    if (!success || retry_count >= config.retry_count) {
-        printf("Error: Failed to generate blog after %d retries\n", retry_count);
+    if (!success) {
+        log_error("Failed to generate blog");
+        return 1;
+    }
+    if (failed_posts) {
+        log_message(LOG_LEVEL_WARN, "Blog generated with %d failed post(s)", failed_posts);
         return 1;
     }
     
-    printf("Blog generation completed successfully!\n");
+    log_info("Blog generation completed successfully!");
     return 0;
 }
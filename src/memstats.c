@@ -0,0 +1,192 @@
+#include "../include/memstats.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+
+// 分配器记录的块大小；不支持的平台上只统计次数
+#if defined(__GLIBC__)
+#include <malloc.h>
+#define BLOCK_SIZE(ptr) malloc_usable_size(ptr)
+#elif defined(_WIN32)
+#include <malloc.h>
+#define BLOCK_SIZE(ptr) _msize(ptr)
+#elif defined(__APPLE__)
+#include <malloc/malloc.h>
+#define BLOCK_SIZE(ptr) malloc_size(ptr)
+#else
+#define BLOCK_SIZE(ptr) ((size_t)0)
+#endif
+
+// 每个子系统独占缓存行，不同子系统的计数不会互相争用
+typedef struct {
+    _Alignas(64) atomic_llong live_bytes;
+    atomic_llong peak_bytes;
+    atomic_llong total_bytes;
+    atomic_llong allocs;
+    atomic_llong frees;
+    atomic_llong size_classes[MEM_SIZE_CLASSES];
+} SubsystemStats;
+
+static SubsystemStats stats[MEM_SUBSYSTEM_COUNT];
+
+static struct {
+    _Alignas(64) atomic_llong live_bytes;
+    atomic_llong peak_bytes;
+} totals;
+
+static struct {
+    _Alignas(64) atomic_llong count;
+    atomic_llong used_total;
+    atomic_llong used_peak;
+    atomic_llong reserved_total;
+    atomic_llong reserved_peak;
+} arenas;
+
+static const char* subsystem_names[MEM_SUBSYSTEM_COUNT] = {
+    "general", "arena", "parser", "render", "output", "source", "catalog", "scan", "server"
+};
+
+static void update_peak(atomic_llong* peak, long long value) {
+    long long current = atomic_load_explicit(peak, memory_order_relaxed);
+    while (value > current &&
+           !atomic_compare_exchange_weak_explicit(peak, &current, value,
+                                                  memory_order_relaxed, memory_order_relaxed)) {
+    }
+}
+
+static int size_class(size_t size) {
+    if (size <= 16) return 0;
+#if defined(__GNUC__)
+    int bits = 64 - __builtin_clzll((unsigned long long)(size - 1));
+#else
+    int bits = 0;
+    for (size_t n = size - 1; n; n >>= 1) bits++;
+#endif
+    int cls = bits - 4;
+    return cls < MEM_SIZE_CLASSES ? cls : MEM_SIZE_CLASSES - 1;
+}
+
+static void record_alloc(MemSubsystem subsystem, void* ptr) {
+    SubsystemStats* s = &stats[subsystem];
+    long long size = (long long)BLOCK_SIZE(ptr);
+
+    long long live = atomic_fetch_add_explicit(&s->live_bytes, size, memory_order_relaxed) + size;
+    update_peak(&s->peak_bytes, live);
+    long long all = atomic_fetch_add_explicit(&totals.live_bytes, size, memory_order_relaxed) + size;
+    update_peak(&totals.peak_bytes, all);
+
+    atomic_fetch_add_explicit(&s->total_bytes, size, memory_order_relaxed);
+    atomic_fetch_add_explicit(&s->allocs, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&s->size_classes[size_class((size_t)size)], 1, memory_order_relaxed);
+}
+
+static void record_free(MemSubsystem subsystem, size_t block_size) {
+    SubsystemStats* s = &stats[subsystem];
+    atomic_fetch_sub_explicit(&s->live_bytes, (long long)block_size, memory_order_relaxed);
+    atomic_fetch_sub_explicit(&totals.live_bytes, (long long)block_size, memory_order_relaxed);
+    atomic_fetch_add_explicit(&s->frees, 1, memory_order_relaxed);
+}
+
+void* mem_malloc(MemSubsystem subsystem, size_t size) {
+    void* ptr = malloc(size);
+    if (ptr) record_alloc(subsystem, ptr);
+    return ptr;
+}
+
+void* mem_calloc(MemSubsystem subsystem, size_t count, size_t size) {
+    void* ptr = calloc(count, size);
+    if (ptr) record_alloc(subsystem, ptr);
+    return ptr;
+}
+
+// 扩容按一次释放加一次分配统计
+void* mem_realloc(MemSubsystem subsystem, void* ptr, size_t size) {
+    size_t old_size = ptr ? BLOCK_SIZE(ptr) : 0;
+    void* grown = realloc(ptr, size);
+    if (!grown) return NULL;
+
+    if (ptr) record_free(subsystem, old_size);
+    record_alloc(subsystem, grown);
+    return grown;
+}
+
+char* mem_strdup(MemSubsystem subsystem, const char* str) {
+    size_t length = strlen(str) + 1;
+    char* copy = mem_malloc(subsystem, length);
+    if (copy) memcpy(copy, str, length);
+    return copy;
+}
+
+void mem_free(MemSubsystem subsystem, void* ptr) {
+    if (!ptr) return;
+    record_free(subsystem, BLOCK_SIZE(ptr));
+    free(ptr);
+}
+
+void mem_stats_arena(size_t used, size_t reserved) {
+    atomic_fetch_add_explicit(&arenas.count, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&arenas.used_total, (long long)used, memory_order_relaxed);
+    atomic_fetch_add_explicit(&arenas.reserved_total, (long long)reserved, memory_order_relaxed);
+    update_peak(&arenas.used_peak, (long long)used);
+    update_peak(&arenas.reserved_peak, (long long)reserved);
+}
+
+static const char* format_size(long long bytes, char* buffer, size_t size) {
+    if (bytes >= 10LL * 1024 * 1024) {
+        snprintf(buffer, size, "%lld MB", bytes / (1024 * 1024));
+    } else if (bytes >= 10LL * 1024) {
+        snprintf(buffer, size, "%lld KB", bytes / 1024);
+    } else {
+        snprintf(buffer, size, "%lld B", bytes);
+    }
+    return buffer;
+}
+
+void mem_stats_dump(FILE* fp) {
+    char live[32], peak[32], total[32];
+
+    fprintf(fp, "Memory statistics:\n");
+    fprintf(fp, "  %-9s %10s %10s %10s %10s %10s\n", "subsystem", "live", "peak", "allocated", "allocs", "frees");
+    for (int i = 0; i < MEM_SUBSYSTEM_COUNT; i++) {
+        SubsystemStats* s = &stats[i];
+        long long allocs = atomic_load(&s->allocs);
+        if (!allocs) continue;
+        fprintf(fp, "  %-9s %10s %10s %10s %10lld %10lld\n", subsystem_names[i],
+                format_size(atomic_load(&s->live_bytes), live, sizeof(live)),
+                format_size(atomic_load(&s->peak_bytes), peak, sizeof(peak)),
+                format_size(atomic_load(&s->total_bytes), total, sizeof(total)),
+                allocs, atomic_load(&s->frees));
+    }
+    fprintf(fp, "  %-9s %10s %10s\n", "all",
+            format_size(atomic_load(&totals.live_bytes), live, sizeof(live)),
+            format_size(atomic_load(&totals.peak_bytes), peak, sizeof(peak)));
+
+    // 大小分布：每档的上限和分配次数，只列出非空的档
+    fprintf(fp, "  size classes:\n");
+    for (int i = 0; i < MEM_SUBSYSTEM_COUNT; i++) {
+        SubsystemStats* s = &stats[i];
+        if (!atomic_load(&s->allocs)) continue;
+        fprintf(fp, "    %-9s", subsystem_names[i]);
+        for (int c = 0; c < MEM_SIZE_CLASSES; c++) {
+            long long count = atomic_load(&s->size_classes[c]);
+            if (!count) continue;
+            if (c == MEM_SIZE_CLASSES - 1) {
+                fprintf(fp, " >%s:%lld", format_size(16LL << (c - 1), total, sizeof(total)), count);
+            } else {
+                fprintf(fp, " <=%s:%lld", format_size(16LL << c, total, sizeof(total)), count);
+            }
+        }
+        fputc('\n', fp);
+    }
+
+    long long count = atomic_load(&arenas.count);
+    if (count) {
+        fprintf(fp, "  arenas: %lld pool(s), mean used %s of %s reserved, high-water %s",
+                count,
+                format_size(atomic_load(&arenas.used_total) / count, live, sizeof(live)),
+                format_size(atomic_load(&arenas.reserved_total) / count, total, sizeof(total)),
+                format_size(atomic_load(&arenas.used_peak), peak, sizeof(peak)));
+        fprintf(fp, " (largest reservation %s)\n",
+                format_size(atomic_load(&arenas.reserved_peak), total, sizeof(total)));
+    }
+}
@@ -0,0 +1,337 @@
+#include "../include/minify.h"
+#include <string.h>
+#include <ctype.h>
+
+// 压缩器状态
+enum {
+    MS_TEXT = 0,      // 普通文本
+    MS_TAG_OPEN,      // 读取 "<" 之后的标签名
+    MS_TAG,           // 标签内的属性
+    MS_VALUE,         // 带引号的属性值（缓存中）
+    MS_VALUE_RAW,     // 过长的属性值，原样输出
+    MS_COMMENT,       // 注释，整体丢弃
+    MS_DECL,          // <!DOCTYPE> 或 <?xml ?>，原样输出
+    MS_RAW            // pre/code/script/style/textarea 的内容，原样输出
+};
+
+// 块级元素：与它们相邻且包含换行的空白可以安全删除
+static const char* block_tags[] = {
+    "address", "article", "aside", "blockquote", "body", "br", "dd", "details",
+    "div", "dl", "dt", "fieldset", "figcaption", "figure", "footer", "form",
+    "h1", "h2", "h3", "h4", "h5", "h6", "head", "header", "hr", "html", "li",
+    "link", "main", "meta", "nav", "noscript", "ol", "option", "p", "pre",
+    "script", "section", "style", "table", "tbody", "td", "tfoot", "th",
+    "thead", "title", "tr", "ul"
+};
+
+// 内容必须原样保留的元素
+static const char* raw_tags[] = {"pre", "code", "script", "style", "textarea"};
+
+static int in_list(const char* name, const char** list, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        if (strcmp(name, list[i]) == 0) return 1;
+    }
+    return 0;
+}
+
+static int is_space(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f';
+}
+
+static void out_flush(HtmlMinifier* m) {
+    if (m->out_len) {
+        m->emit(m->user, m->out, m->out_len);
+        m->out_len = 0;
+    }
+}
+
+static void out_char(HtmlMinifier* m, char c) {
+    if (m->out_len == MINIFY_OUT_SIZE) out_flush(m);
+    m->out[m->out_len++] = c;
+}
+
+static void out_data(HtmlMinifier* m, const char* data, size_t length) {
+    for (size_t i = 0; i < length; i++) {
+        out_char(m, data[i]);
+    }
+}
+
+void minifier_init(HtmlMinifier* m, MinifyEmit emit, void* user) {
+    memset(m, 0, sizeof(HtmlMinifier));
+    m->emit = emit;
+    m->user = user;
+    m->state = MS_TEXT;
+}
+
+// 输出挂起的空白：含换行且与块级标签相邻时丢弃，否则压缩为一个空格
+static void resolve_space(HtmlMinifier* m, int next_is_block) {
+    if (m->pending_space && m->started &&
+        !(m->pending_space == 2 && (m->after_block_tag || next_is_block))) {
+        out_char(m, ' ');
+    }
+    m->pending_space = 0;
+}
+
+// 属性值不含特殊字符时去掉引号
+static void flush_value(HtmlMinifier* m) {
+    int safe = m->value_len > 0 && m->value[m->value_len - 1] != '/';
+    for (size_t i = 0; safe && i < m->value_len; i++) {
+        char c = m->value[i];
+        if (is_space(c) || c == '"' || c == '\'' || c == '=' || c == '<' || c == '>' || c == '`') {
+            safe = 0;
+        }
+    }
+
+    if (safe) {
+        out_data(m, m->value, m->value_len);
+        m->last_tag_char = m->value[m->value_len - 1];
+        m->attr_space = 2;  // 未加引号的值后面必须有分隔符
+    } else {
+        out_char(m, m->quote);
+        out_data(m, m->value, m->value_len);
+        out_char(m, m->quote);
+        m->last_tag_char = m->quote;
+    }
+}
+
+static void end_tag(HtmlMinifier* m) {
+    out_char(m, '>');
+    m->after_block_tag = m->tag_is_block;
+    m->state = MS_TEXT;
+
+    if (!m->closing && m->last_tag_char != '/' &&
+        in_list(m->tag_name, raw_tags, sizeof(raw_tags)/sizeof(raw_tags[0]))) {
+        strcpy(m->raw_tag, m->tag_name);
+        m->raw_match = 0;
+        m->state = MS_RAW;
+    }
+}
+
+// 标签名读取完毕，决定前面的空白并输出缓存的 "<name"
+static void begin_tag(HtmlMinifier* m) {
+    m->tag_is_block = in_list(m->tag_name, block_tags, sizeof(block_tags)/sizeof(block_tags[0]));
+    resolve_space(m, m->tag_is_block);
+    out_data(m, m->tag, m->tag_len);
+    m->started = 1;
+    m->state = MS_TAG;
+    m->attr_space = 0;
+    m->last_tag_char = m->tag[m->tag_len - 1];
+}
+
+// 处理一个字符；返回 0 表示需要在新状态下重新处理该字符
+static int process_char(HtmlMinifier* m, char c) {
+    switch (m->state) {
+        case MS_TEXT:
+            if (is_space(c)) {
+                if (c == '\n') m->pending_space = 2;
+                else if (!m->pending_space) m->pending_space = 1;
+            } else if (c == '<') {
+                m->state = MS_TAG_OPEN;
+                m->tag[0] = '<';
+                m->tag_len = 1;
+                m->tag_name[0] = '\0';
+                m->closing = 0;
+            } else {
+                resolve_space(m, 0);
+                out_char(m, c);
+                m->started = 1;
+                m->after_block_tag = 0;
+            }
+            return 1;
+
+        case MS_TAG_OPEN: {
+            size_t name_len = strlen(m->tag_name);
+            if (m->tag_len == 1 && c == '/') {
+                m->closing = 1;
+                m->tag[m->tag_len++] = c;
+                return 1;
+            }
+            if (m->tag_len == 1 && (c == '!' || c == '?')) {
+                m->tag[m->tag_len++] = c;
+                return 1;
+            }
+            if (m->tag_len >= 2 && (m->tag[1] == '!' || m->tag[1] == '?')) {
+                if (m->tag[1] == '!' && m->tag_len == 2 && c == '-') {
+                    m->tag[m->tag_len++] = c;
+                    return 1;
+                }
+                if (m->tag[1] == '!' && m->tag_len == 3 && c == '-') {
+                    m->state = MS_COMMENT;
+                    m->dashes = 0;
+                    m->tag_len = 0;
+                    return 1;
+                }
+                resolve_space(m, 1);
+                out_data(m, m->tag, m->tag_len);
+                m->started = 1;
+                m->state = MS_DECL;
+                return 0;
+            }
+            if (isalnum((unsigned char)c) && m->tag_len < MINIFY_TAG_SIZE - 1) {
+                m->tag[m->tag_len++] = c;
+                m->tag_name[name_len] = (char)tolower((unsigned char)c);
+                m->tag_name[name_len + 1] = '\0';
+                return 1;
+            }
+            if (name_len == 0) {
+                // 不是标签（例如 "a < b"），按文本输出
+                resolve_space(m, 0);
+                out_data(m, m->tag, m->tag_len);
+                m->started = 1;
+                m->after_block_tag = 0;
+                m->state = MS_TEXT;
+                return 0;
+            }
+            begin_tag(m);
+            return 0;
+        }
+
+        case MS_TAG:
+            if (is_space(c)) {
+                if (!m->attr_space) m->attr_space = 1;
+            } else if (c == '>') {
+                end_tag(m);
+            } else if ((c == '"' || c == '\'') && m->last_tag_char == '=') {
+                m->state = MS_VALUE;
+                m->quote = c;
+                m->value_len = 0;
+            } else if (c == '=') {
+                out_char(m, c);
+                m->attr_space = 0;
+                m->last_tag_char = c;
+            } else {
+                if (m->attr_space && m->last_tag_char != '=') out_char(m, ' ');
+                m->attr_space = 0;
+                out_char(m, c);
+                m->last_tag_char = c;
+            }
+            return 1;
+
+        case MS_VALUE:
+            if (c == m->quote) {
+                flush_value(m);
+                m->state = MS_TAG;
+            } else if (m->value_len < MINIFY_VALUE_SIZE) {
+                m->value[m->value_len++] = c;
+            } else {
+                out_char(m, m->quote);
+                out_data(m, m->value, m->value_len);
+                out_char(m, c);
+                m->state = MS_VALUE_RAW;
+            }
+            return 1;
+
+        case MS_VALUE_RAW:
+            out_char(m, c);
+            if (c == m->quote) {
+                m->last_tag_char = c;
+                m->state = MS_TAG;
+            }
+            return 1;
+
+        case MS_COMMENT:
+            if (c == '>' && m->dashes >= 2) {
+                m->state = MS_TEXT;
+            } else {
+                m->dashes = c == '-' ? m->dashes + 1 : 0;
+            }
+            return 1;
+
+        case MS_DECL:
+            out_char(m, c);
+            if (c == '>') {
+                m->after_block_tag = 1;
+                m->state = MS_TEXT;
+            }
+            return 1;
+
+        case MS_RAW: {
+            out_char(m, c);
+            size_t raw_len = strlen(m->raw_tag);
+            char expected = m->raw_match == 0 ? '<' :
+                            m->raw_match == 1 ? '/' : m->raw_tag[m->raw_match - 2];
+
+            if (tolower((unsigned char)c) == expected) {
+                m->raw_match++;
+                if (m->raw_match == raw_len + 2) {
+                    // 找到结束标签，后续按普通标签处理
+                    strcpy(m->tag_name, m->raw_tag);
+                    m->closing = 1;
+                    m->tag_is_block = in_list(m->tag_name, block_tags,
+                                              sizeof(block_tags)/sizeof(block_tags[0]));
+                    m->attr_space = 0;
+                    m->last_tag_char = c;
+                    m->raw_tag[0] = '\0';
+                    m->state = MS_TAG;
+                }
+            } else {
+                m->raw_match = c == '<' ? 1 : 0;
+            }
+            return 1;
+        }
+    }
+    return 1;
+}
+
+void minifier_feed(HtmlMinifier* m, const char* data, size_t length) {
+    for (size_t i = 0; i < length; ) {
+        if (process_char(m, data[i])) i++;
+    }
+}
+
+void minifier_finish(HtmlMinifier* m) {
+    if (m->state == MS_TAG_OPEN) {
+        out_data(m, m->tag, m->tag_len);
+    } else if (m->state == MS_VALUE) {
+        out_char(m, m->quote);
+        out_data(m, m->value, m->value_len);
+    }
+    m->state = MS_TEXT;
+    m->pending_space = 0;
+    out_flush(m);
+}
+
+size_t minify_css(const char* css, size_t length, char* out) {
+    size_t n = 0;
+    int space = 0;
+
+    for (size_t i = 0; i < length; i++) {
+        char c = css[i];
+
+        if (c == '/' && i + 1 < length && css[i + 1] == '*') {
+            size_t j = i + 2;
+            while (j + 1 < length && !(css[j] == '*' && css[j + 1] == '/')) j++;
+            i = j + 1;
+            space = 1;
+            continue;
+        }
+        if (is_space(c)) {
+            space = 1;
+            continue;
+        }
+
+        // 只在两侧都不是分隔符时保留一个空格；"+"/"-" 可能出现在 calc() 中，不能去掉空格
+        if (space && n > 0 && !strchr("{};:,>(", out[n - 1]) && !strchr("{};,>)", c)) {
+            out[n++] = ' ';
+        }
+        space = 0;
+
+        if (c == '"' || c == '\'') {
+            char quote = c;
+            out[n++] = c;
+            while (++i < length) {
+                out[n++] = css[i];
+                if (css[i] == '\\' && i + 1 < length) {
+                    out[n++] = css[++i];
+                } else if (css[i] == quote) {
+                    break;
+                }
+            }
+            continue;
+        }
+
+        if (c == '}' && n > 0 && out[n - 1] == ';') n--;
+        out[n++] = c;
+    }
+    return n;
+}
@@ -1 +1,244 @@
- 
\ No newline at end of file
+#include "../include/optimization.h"
+#include "../include/utils.h"
+#include <stdlib.h>
+#include <time.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+
+#define FNV_PRIME 0x100000001b3ULL
+
+// 增量计算内容哈希，便于分块处理大文件
+uint64_t content_hash_update(uint64_t hash, const void* data, size_t length) {
+    const unsigned char* bytes = (const unsigned char*)data;
+    for (size_t i = 0; i < length; i++) {
+        hash ^= bytes[i];
+        hash *= FNV_PRIME;
+    }
+    return hash;
+}
+
+uint64_t content_hash(const void* data, size_t length) {
+    return content_hash_update(CONTENT_HASH_INIT, data, length);
+}
+
+long long monotonic_ns(void) {
+#ifdef _WIN32
+    return (long long)GetTickCount64() * 1000000LL;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+#endif
+}
+
+void cancel_token_init(CancelToken* token, long long budget_ms) {
+    atomic_init(&token->cancelled, 0);
+    token->budget_ms = budget_ms;
+    token->deadline_ns = 0;
+}
+
+void cancel_token_restart(CancelToken* token) {
+    if (!token) return;
+    atomic_store(&token->cancelled, 0);
+    token->deadline_ns = token->budget_ms > 0 ? monotonic_ns() + token->budget_ms * 1000000LL : 0;
+}
+
+void cancel_token_cancel(CancelToken* token) {
+    if (token) atomic_store(&token->cancelled, 1);
+}
+
+// 检查只读一次时钟，超时后置位 cancelled，之后的检查不再读时钟
+int cancel_requested(CancelToken* token) {
+    if (!token) return 0;
+    if (atomic_load_explicit(&token->cancelled, memory_order_relaxed)) return 1;
+
+    if (token->deadline_ns && monotonic_ns() > token->deadline_ns) {
+        atomic_store(&token->cancelled, 1);
+        return 1;
+    }
+    return 0;
+}
+
+static _Thread_local CancelToken* current_token = NULL;
+
+CancelToken* worker_pool_current_token(void) {
+    return current_token;
+}
+
+// 运行任务：有令牌时从此刻开始计算预算；无令牌的嵌套任务沿用外层任务的令牌
+static void run_task(WorkerTask run, void* arg, CancelToken* token) {
+    CancelToken* previous = current_token;
+    if (token) {
+        token->deadline_ns = token->budget_ms > 0 ? monotonic_ns() + token->budget_ms * 1000000LL : 0;
+        current_token = token;
+    }
+    // 任务的日志先缓冲在线程内，任务结束时一次写出
+    log_batch_begin();
+    run(arg);
+    log_batch_end();
+    current_token = previous;
+}
+
+// 线程池实现
+typedef struct PoolTask {
+    WorkerTask run;
+    void* arg;
+    CancelToken* token;
+    struct PoolTask* next;
+} PoolTask;
+
+struct WorkerPool {
+    int size;
+#ifndef _WIN32
+    pthread_t* threads;
+    pthread_mutex_t lock;
+    pthread_cond_t task_ready;    // 有新任务或线程池正在关闭
+    pthread_cond_t all_done;      // pending 降为 0
+    PoolTask* head;
+    PoolTask* tail;
+    int pending;                  // 已提交但尚未完成的任务数
+    int shutdown;
+#endif
+};
+
+#ifndef _WIN32
+static void* worker_main(void* arg) {
+    WorkerPool* pool = (WorkerPool*)arg;
+
+    pthread_mutex_lock(&pool->lock);
+    for (;;) {
+        while (!pool->head && !pool->shutdown) {
+            pthread_cond_wait(&pool->task_ready, &pool->lock);
+        }
+        if (!pool->head) break;
+
+        PoolTask* task = pool->head;
+        pool->head = task->next;
+        if (!pool->head) pool->tail = NULL;
+        pthread_mutex_unlock(&pool->lock);
+
+        run_task(task->run, task->arg, task->token);
+        free(task);
+
+        pthread_mutex_lock(&pool->lock);
+        if (--pool->pending == 0) {
+            pthread_cond_broadcast(&pool->all_done);
+        }
+    }
+    pthread_mutex_unlock(&pool->lock);
+    return NULL;
+}
+#endif
+
+WorkerPool* worker_pool_create(int workers) {
+    WorkerPool* pool = (WorkerPool*)calloc(1, sizeof(WorkerPool));
+    if (!pool) return NULL;
+
+    pool->size = workers > 1 ? workers : 1;
+#ifndef _WIN32
+    if (pool->size == 1) return pool;
+
+    pool->threads = (pthread_t*)calloc(pool->size, sizeof(pthread_t));
+    if (!pool->threads) {
+        free(pool);
+        return NULL;
+    }
+
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->task_ready, NULL);
+    pthread_cond_init(&pool->all_done, NULL);
+
+    for (int i = 0; i < pool->size; i++) {
+        if (pthread_create(&pool->threads[i], NULL, worker_main, pool) != 0) {
+            // 线程创建失败时用已有的线程继续工作
+            pool->size = i;
+            break;
+        }
+    }
+    if (pool->size == 0) {
+        pool->size = 1;
+        free(pool->threads);
+        pool->threads = NULL;
+    }
+#else
+    pool->size = 1;
+#endif
+    return pool;
+}
+
+int worker_pool_submit(WorkerPool* pool, WorkerTask task, void* arg) {
+    return worker_pool_submit_with_token(pool, task, arg, NULL);
+}
+
+int worker_pool_submit_with_token(WorkerPool* pool, WorkerTask task, void* arg, CancelToken* token) {
+    if (!pool || !task) return 0;
+
+#ifndef _WIN32
+    if (pool->threads) {
+        PoolTask* item = (PoolTask*)malloc(sizeof(PoolTask));
+        if (!item) return 0;
+        item->run = task;
+        item->arg = arg;
+        item->token = token;
+        item->next = NULL;
+
+        pthread_mutex_lock(&pool->lock);
+        if (pool->tail) pool->tail->next = item;
+        else pool->head = item;
+        pool->tail = item;
+        pool->pending++;
+        pthread_cond_signal(&pool->task_ready);
+        pthread_mutex_unlock(&pool->lock);
+        return 1;
+    }
+#endif
+
+    run_task(task, arg, token);
+    return 1;
+}
+
+void worker_pool_wait(WorkerPool* pool) {
+#ifndef _WIN32
+    if (!pool || !pool->threads) return;
+
+    pthread_mutex_lock(&pool->lock);
+    while (pool->pending > 0) {
+        pthread_cond_wait(&pool->all_done, &pool->lock);
+    }
+    pthread_mutex_unlock(&pool->lock);
+#else
+    (void)pool;
+#endif
+}
+
+void worker_pool_destroy(WorkerPool* pool) {
+    if (!pool) return;
+
+#ifndef _WIN32
+    if (pool->threads) {
+        worker_pool_wait(pool);
+
+        pthread_mutex_lock(&pool->lock);
+        pool->shutdown = 1;
+        pthread_cond_broadcast(&pool->task_ready);
+        pthread_mutex_unlock(&pool->lock);
+
+        for (int i = 0; i < pool->size; i++) {
+            pthread_join(pool->threads[i], NULL);
+        }
+        free(pool->threads);
+        pthread_mutex_destroy(&pool->lock);
+        pthread_cond_destroy(&pool->task_ready);
+        pthread_cond_destroy(&pool->all_done);
+    }
+#endif
+    free(pool);
+}
+
+int worker_pool_size(const WorkerPool* pool) {
+    return pool ? pool->size : 0;
+}
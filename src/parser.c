@@ -1,34 +1,51 @@
 #include "../include/parser.h"
+#include "../include/optimization.h"
+#include "../include/memstats.h"
 #include <ctype.h>
 
 #define POOL_INITIAL_SIZE (1024 * 1024)  // 1MB
 #define MAX_LINE_LENGTH 4096
 #define MAX_HEADING_LEVEL 6
+#define POOL_ALIGN 16
+#define POOL_CHUNK_HEADER POOL_ALIGN  // 块开头保存上一块的指针
+#define POOL_STREAM_RESET (64 * 1024)  // 流式解析时内存池用量超过该值就清空
 
 // 内存池实现
 MemPool* create_memory_pool(size_t initial_size) {
-    MemPool* pool = (MemPool*)malloc(sizeof(MemPool));
+    MemPool* pool = (MemPool*)mem_malloc(MEM_PARSER, sizeof(MemPool));
     if (!pool) return NULL;
     
-    pool->pool = (char*)malloc(initial_size);
+    if (initial_size < POOL_CHUNK_HEADER * 2) initial_size = POOL_CHUNK_HEADER * 2;
+    pool->pool = (char*)mem_malloc(MEM_ARENA, initial_size);
     if (!pool->pool) {
-        free(pool);
+        mem_free(MEM_PARSER, pool);
         return NULL;
     }
     
+    *(char**)pool->pool = NULL;
     pool->capacity = initial_size;
-    pool->used = 0;
+    pool->used = POOL_CHUNK_HEADER;
+    pool->retired_used = 0;
+    pool->reserved = initial_size;
     return pool;
 }
 
+// 当前块放不下时分配新块而不是 realloc，已经返回的指针（如块链表）保持有效
 void* pool_alloc(MemPool* pool, size_t size) {
+    size = (size + POOL_ALIGN - 1) & ~(size_t)(POOL_ALIGN - 1);
     if (pool->used + size > pool->capacity) {
         size_t new_capacity = pool->capacity * 2;
-        char* new_pool = (char*)realloc(pool->pool, new_capacity);
-        if (!new_pool) return NULL;
+        while (new_capacity < size + POOL_CHUNK_HEADER) new_capacity *= 2;
         
-        pool->pool = new_pool;
+        char* chunk = (char*)mem_malloc(MEM_ARENA, new_capacity);
+        if (!chunk) return NULL;
+        
+        *(char**)chunk = pool->pool;
+        pool->retired_used += pool->used;
+        pool->reserved += new_capacity;
+        pool->pool = chunk;
         pool->capacity = new_capacity;
+        pool->used = POOL_CHUNK_HEADER;
     }
     
     void* ptr = pool->pool + pool->used;
@@ -36,21 +53,48 @@ void* pool_alloc(MemPool* pool, size_t size) {
     return ptr;
 }
 
+// 只保留最近（也是最大）的一块，之前的块全部释放
+static void rewind_memory_pool(MemPool* pool) {
+    char* chunk = *(char**)pool->pool;
+    while (chunk) {
+        char* prev = *(char**)chunk;
+        mem_free(MEM_ARENA, chunk);
+        chunk = prev;
+    }
+    *(char**)pool->pool = NULL;
+    pool->used = POOL_CHUNK_HEADER;
+    pool->retired_used = 0;
+    pool->reserved = pool->capacity;
+}
+
+// 清空内存池以便复用
+void reset_memory_pool(MemPool* pool) {
+    if (!pool) return;
+    mem_stats_arena(pool->retired_used + pool->used, pool->reserved);
+    rewind_memory_pool(pool);
+}
+
 void destroy_memory_pool(MemPool* pool) {
     if (pool) {
-        if (pool->pool) free(pool->pool);
-        free(pool);
+        mem_stats_arena(pool->retired_used + pool->used, pool->reserved);
+        char* chunk = pool->pool;
+        while (chunk) {
+            char* prev = *(char**)chunk;
+            mem_free(MEM_ARENA, chunk);
+            chunk = prev;
+        }
+        mem_free(MEM_PARSER, pool);
     }
 }
 
 // 解析器上下文实现
 ParserContext* create_parser_context(const ParserConfig* config) {
-    ParserContext* ctx = (ParserContext*)malloc(sizeof(ParserContext));
+    ParserContext* ctx = (ParserContext*)mem_malloc(MEM_PARSER, sizeof(ParserContext));
     if (!ctx) return NULL;
     
     ctx->pool = create_memory_pool(POOL_INITIAL_SIZE);
     if (!ctx->pool) {
-        free(ctx);
+        mem_free(MEM_PARSER, ctx);
         return NULL;
     }
     
@@ -66,16 +110,32 @@ ParserContext* create_parser_context(const ParserConfig* config) {
     
     ctx->first_block = NULL;
     ctx->current_block = NULL;
+    ctx->sink = NULL;
+    ctx->sink_user = NULL;
+    ctx->sink_list = 0;
+    ctx->block_count = 0;
     return ctx;
 }
 
 void destroy_parser_context(ParserContext* ctx) {
     if (ctx) {
         destroy_memory_pool(ctx->pool);
-        free(ctx);
+        mem_free(MEM_PARSER, ctx);
     }
 }
 
+// 丢弃已解析的块，保留内存池供下一篇文档使用
+void reset_parser_context(ParserContext* ctx) {
+    if (!ctx) return;
+    reset_memory_pool(ctx->pool);
+    ctx->first_block = NULL;
+    ctx->current_block = NULL;
+    ctx->sink = NULL;
+    ctx->sink_user = NULL;
+    ctx->sink_list = 0;
+    ctx->block_count = 0;
+}
+
 // 创建块的实现
 static Block* create_block(ParserContext* ctx, BlockType type) {
     Block* block = (Block*)pool_alloc(ctx->pool, sizeof(Block));
@@ -88,8 +148,25 @@ static Block* create_block(ParserContext* ctx, BlockType type) {
     return block;
 }
 
+static char* render_block(const Block* block, int* in_list);
+
+// 流式解析：块立即渲染写出，写出后块不再被引用，内存池用量较大时直接清空
+static void emit_block(ParserContext* ctx, Block* block) {
+    char* html = render_block(block, &ctx->sink_list);
+    if (html) {
+        ctx->sink(ctx->sink_user, html, strlen(html));
+        mem_free(MEM_RENDER, html);
+    }
+    ctx->block_count++;
+    if (ctx->pool->used > POOL_STREAM_RESET || ctx->pool->retired_used) rewind_memory_pool(ctx->pool);
+}
+
 // 将块添加到解析器上下文中
 static void add_block(ParserContext* ctx, Block* block) {
+    if (ctx->sink) {
+        emit_block(ctx, block);
+        return;
+    }
     if (!ctx->first_block) {
         ctx->first_block = block;
     } else {
@@ -147,22 +224,33 @@ static Block* parse_list_item(ParserContext* ctx, const char* line) {
     return block;
 }
 
+// 在 [start, limit) 范围内查找子串
+static const char* find_in_span(const char* start, const char* limit, const char* needle, size_t needle_len) {
+    while ((size_t)(limit - start) >= needle_len) {
+        const char* hit = memchr(start, needle[0], limit - start - needle_len + 1);
+        if (!hit) return NULL;
+        if (memcmp(hit, needle, needle_len) == 0) return hit;
+        start = hit + 1;
+    }
+    return NULL;
+}
+
 // 解析代码块
-static Block* parse_code_block(ParserContext* ctx, const char** ptr) {
+static Block* parse_code_block(ParserContext* ctx, const char** ptr, const char* limit) {
     const char* start = *ptr;
-    if (strncmp(start, "```", 3) != 0) return NULL;
+    if (limit - start < 3 || strncmp(start, "```", 3) != 0) return NULL;
     
     // Skip opening marker and get language identifier
     start += 3;
     const char* lang_start = start;
-    while (*start && *start != '\n') start++;
+    while (start < limit && *start != '\n') start++;
     size_t lang_len = start - lang_start;
     
     // Skip newline after language identifier
-    if (*start == '\n') start++;
+    if (start < limit && *start == '\n') start++;
     
     // Find closing marker
-    const char* end = strstr(start, "\n```");
+    const char* end = find_in_span(start, limit, "\n```", 4);
     if (!end) return NULL;
     
     Block* block = create_block(ctx, BLOCK_CODE);
@@ -196,9 +284,10 @@ static Block* parse_code_block(ParserContext* ctx, const char** ptr) {
     while (src < end) {
         if (line_start) {
             // Skip common indentation at the start of lines
-            while (isspace(*src) && *src != '\n') src++;
+            while (src < end && isspace(*src) && *src != '\n') src++;
             line_start = 0;
             in_whitespace = 1;
+            if (src == end) break;
         }
         
         if (*src == '\n') {
@@ -226,38 +315,59 @@ static Block* parse_code_block(ParserContext* ctx, const char** ptr) {
     
     // Update pointer position to after the closing marker
     *ptr = end + 4;  // Skip "\n```"
-    if (**ptr == '\n') (*ptr)++;  // Skip additional newline if present
+    if (*ptr < limit && **ptr == '\n') (*ptr)++;  // Skip additional newline if present
     
     return block;
 }
 
 // 从字符串解析Markdown
 int parse_markdown_with_context(ParserContext* ctx, const char* content) {
+    if (!content) return 0;
+    return parse_markdown_span(ctx, content, strlen(content));
+}
+
+// 解析长度确定的文本片段，内容无需以 '\0' 结尾（可直接指向 mmap 的文件）
+int parse_markdown_span(ParserContext* ctx, const char* content, size_t length) {
+    return parse_markdown_indexed(ctx, content, length, NULL);
+}
+
+// 查找 ptr 所在行的行尾：有行索引时直接查表（ptr 单调前进，游标只向后移动），否则用 memchr
+static const char* find_line_end(const LineIndex* lines, size_t* cursor, const char* ptr, const char* end) {
+    if (!lines) return memchr(ptr, '\n', end - ptr);
+    
+    size_t offset = ptr - lines->base;
+    while (*cursor < lines->count && lines->starts[*cursor] <= offset) (*cursor)++;
+    if (*cursor == lines->count) return NULL;
+    
+    const char* eol = lines->base + lines->starts[*cursor] - 1;
+    return eol < end ? eol : NULL;
+}
+
+// lines 为加载时建立的行索引（可为 NULL），偏移相对 lines->base
+int parse_markdown_indexed(ParserContext* ctx, const char* content, size_t length, const LineIndex* lines) {
     if (!ctx || !content) return 0;
     
     const char* ptr = content;
+    const char* end = content + length;
     char line[MAX_LINE_LENGTH];
+    size_t line_cursor = 0;
     Block* block = NULL;
     int in_list = 0;  // Track if we're in a list
     int list_type = 0;  // 0: no list, 'u': unordered list, 'o': ordered list
+    size_t iterations = 0;
+    CancelToken* token = worker_pool_current_token();
     
     // Skip YAML front matter
-    if (strncmp(ptr, "---\n", 4) == 0) {
+    if (length >= 4 && strncmp(ptr, "---\n", 4) == 0) {
         ptr += 4;
-        while (*ptr) {
-            const char* eol = strchr(ptr, '\n');
+        while (ptr < end) {
+            const char* eol = memchr(ptr, '\n', end - ptr);
             if (!eol) break;
             
-            size_t line_len = eol - ptr;
-            if (line_len >= sizeof(line)) line_len = sizeof(line) - 1;
-            
-            strncpy(line, ptr, line_len);
-            line[line_len] = '\0';
-            
-            if (strcmp(line, "---") == 0) {
+            if (eol - ptr == 3 && strncmp(ptr, "---", 3) == 0) {
                 ptr = eol + 1;
                 // Skip any additional newlines after front matter
-                while (*ptr == '\n') ptr++;
+                while (ptr < end && *ptr == '\n') ptr++;
                 break;
             }
             
@@ -266,9 +376,12 @@ int parse_markdown_with_context(ParserContext* ctx, const char* content) {
     }
     
     // Process the actual content
-    while (*ptr) {
+    while (ptr < end) {
+        // 每 256 行检查一次任务是否超出时间预算，病态输入不会拖住整个构建
+        if ((++iterations & 255) == 0 && cancel_requested(token)) return 0;
+        
         // Check for code block
-        if (strncmp(ptr, "```", 3) == 0) {
+        if (end - ptr >= 3 && strncmp(ptr, "```", 3) == 0) {
             if (in_list) {
                 // End current list
                 block = create_block(ctx, BLOCK_LIST);
@@ -278,7 +391,7 @@ int parse_markdown_with_context(ParserContext* ctx, const char* content) {
                 in_list = 0;
                 list_type = 0;
             }
-            block = parse_code_block(ctx, &ptr);
+            block = parse_code_block(ctx, &ptr, end);
             if (block) {
                 add_block(ctx, block);
                 continue;
@@ -286,21 +399,13 @@ int parse_markdown_with_context(ParserContext* ctx, const char* content) {
         }
         
         // Read a line
-        const char* eol = strchr(ptr, '\n');
-        size_t line_len;
-        if (eol) {
-            line_len = eol - ptr;
-            if (line_len >= sizeof(line)) line_len = sizeof(line) - 1;
-            strncpy(line, ptr, line_len);
-            line[line_len] = '\0';
-            ptr = eol + 1;
-        } else {
-            line_len = strlen(ptr);
-            if (line_len >= sizeof(line)) line_len = sizeof(line) - 1;
-            strncpy(line, ptr, line_len);
-            line[line_len] = '\0';
-            ptr += line_len;
-        }
+        const char* eol = find_line_end(lines, &line_cursor, ptr, end);
+        size_t line_len = eol ? (size_t)(eol - ptr) : (size_t)(end - ptr);
+        if (line_len >= sizeof(line)) line_len = sizeof(line) - 1;
+        memcpy(line, ptr, line_len);
+        line[line_len] = '\0';
+        // 没有换行的最后一行超长时，与逐行读取的原实现一样，截断处之后的内容作为下一行继续处理
+        ptr = eol ? eol + 1 : ptr + line_len;
         
         // Skip empty lines
         if (line_len == 0) {
@@ -393,13 +498,103 @@ int parse_markdown_with_context(ParserContext* ctx, const char* content) {
     return 1;
 }
 
+// 渲染单个块，返回 MEM_RENDER 分配的 HTML；空段落等不产生输出的块返回 NULL
+// in_list 为当前打开的列表类型，列表开始和结束块会更新它
+static char* render_block(const Block* block, int* in_list) {
+    char* block_html = NULL;
+    size_t block_size = 0;
+    
+    switch (block->type) {
+        case BLOCK_HEADING:
+            block_size = strlen(block->content) + 50;
+            block_html = (char*)mem_malloc(MEM_RENDER, block_size);
+            if (block_html) {
+                snprintf(block_html, block_size, "<h%d>%s</h%d>\n", 
+                        block->level, block->content, block->level);
+            }
+            break;
+            
+        case BLOCK_PARAGRAPH:
+            if (strlen(block->content) > 0) {  // 只输出非空段落
+                block_size = strlen(block->content) + 50;
+                block_html = (char*)mem_malloc(MEM_RENDER, block_size);
+                if (block_html) {
+                    snprintf(block_html, block_size, "<p>%s</p>\n", 
+                            block->content);
+                }
+            }
+            break;
+            
+        case BLOCK_LIST:
+            if (!block->content) {
+                // 列表结束
+                block_html = (char*)mem_malloc(MEM_RENDER, 10);
+                if (block_html) {
+                    snprintf(block_html, 10, "</%cl>\n", *in_list);
+                    *in_list = 0;
+                }
+            } else if (block->content[0] == 'u' || block->content[0] == 'o') {
+                // 列表开始
+                *in_list = block->content[0];
+                block_html = (char*)mem_malloc(MEM_RENDER, 10);
+                if (block_html) {
+                    snprintf(block_html, 10, "<%cl>\n", 
+                            block->content[0] == 'u' ? 'u' : 'o');
+                }
+            } else {
+                // 列表项
+                block_size = strlen(block->content) + 50;
+                block_html = (char*)mem_malloc(MEM_RENDER, block_size);
+                if (block_html) {
+                    snprintf(block_html, block_size, "<li>%s</li>\n",
+                            block->content);
+                }
+            }
+            break;
+            
+        case BLOCK_CODE:
+            {
+                const char* lang = block->content;
+                const char* code = block->content + block->level + 1;
+                block_size = strlen(code) + block->level + 100;
+                block_html = (char*)mem_malloc(MEM_RENDER, block_size);
+                if (block_html) {
+                    if (block->level > 0) {
+                        // Trim any whitespace from language identifier
+                        char lang_buf[32];
+                        size_t i = 0;
+                        while (i < block->level && i < sizeof(lang_buf)-1 && !isspace(lang[i])) {
+                            lang_buf[i] = lang[i];
+                            i++;
+                        }
+                        lang_buf[i] = '\0';
+                        
+                        snprintf(block_html, block_size, 
+                                "<pre><code class=\"language-%s\">%s</code></pre>\n",
+                                lang_buf, code);
+                    } else {
+                        snprintf(block_html, block_size, 
+                                "<pre><code>%s</code></pre>\n",
+                                code);
+                    }
+                }
+            }
+            break;
+            
+        default:
+            break;
+    }
+    
+    return block_html;
+}
+
 // 生成HTML输出
 char* get_html_output(ParserContext* ctx) {
     if (!ctx || !ctx->first_block) return NULL;
     
     // 预估需要的缓冲区大小
     size_t buffer_size = 4096;
-    char* output = (char*)malloc(buffer_size);
+    char* output = (char*)mem_malloc(MEM_RENDER, buffer_size);
     if (!output) return NULL;
     
     size_t used = 0;
@@ -407,98 +602,16 @@ char* get_html_output(ParserContext* ctx) {
     int in_list = 0;  // 跟踪是否在列表中
     
     while (block) {
-        char* block_html = NULL;
-        size_t block_size = 0;
-        
-        switch (block->type) {
-            case BLOCK_HEADING:
-                block_size = strlen(block->content) + 50;
-                block_html = (char*)malloc(block_size);
-                if (block_html) {
-                    snprintf(block_html, block_size, "<h%d>%s</h%d>\n", 
-                            block->level, block->content, block->level);
-                }
-                break;
-                
-            case BLOCK_PARAGRAPH:
-                if (strlen(block->content) > 0) {  // 只输出非空段落
-                    block_size = strlen(block->content) + 50;
-                    block_html = (char*)malloc(block_size);
-                    if (block_html) {
-                        snprintf(block_html, block_size, "<p>%s</p>\n", 
-                                block->content);
-                    }
-                }
-                break;
-                
-            case BLOCK_LIST:
-                if (!block->content) {
-                    // 列表结束
-                    block_html = (char*)malloc(10);
-                    if (block_html) {
-                        snprintf(block_html, 10, "</%cl>\n", in_list);
-                        in_list = 0;
-                    }
-                } else if (block->content[0] == 'u' || block->content[0] == 'o') {
-                    // 列表开始
-                    in_list = block->content[0];
-                    block_html = (char*)malloc(10);
-                    if (block_html) {
-                        snprintf(block_html, 10, "<%cl>\n", 
-                                block->content[0] == 'u' ? 'u' : 'o');
-                    }
-                } else {
-                    // 列表项
-                    block_size = strlen(block->content) + 50;
-                    block_html = (char*)malloc(block_size);
-                    if (block_html) {
-                        snprintf(block_html, block_size, "<li>%s</li>\n",
-                                block->content);
-                    }
-                }
-                break;
-                
-            case BLOCK_CODE:
-                {
-                    const char* lang = block->content;
-                    const char* code = block->content + block->level + 1;
-                    block_size = strlen(code) + block->level + 100;
-                    block_html = (char*)malloc(block_size);
-                    if (block_html) {
-                        if (block->level > 0) {
-                            // Trim any whitespace from language identifier
-                            char lang_buf[32];
-                            size_t i = 0;
-                            while (i < block->level && i < sizeof(lang_buf)-1 && !isspace(lang[i])) {
-                                lang_buf[i] = lang[i];
-                                i++;
-                            }
-                            lang_buf[i] = '\0';
-                            
-                            snprintf(block_html, block_size, 
-                                    "<pre><code class=\"language-%s\">%s</code></pre>\n",
-                                    lang_buf, code);
-                        } else {
-                            snprintf(block_html, block_size, 
-                                    "<pre><code>%s</code></pre>\n",
-                                    code);
-                        }
-                    }
-                }
-                break;
-                
-            default:
-                break;
-        }
+        char* block_html = render_block(block, &in_list);
         
         if (block_html) {
             size_t html_len = strlen(block_html);
             if (used + html_len >= buffer_size) {
-                buffer_size *= 2;
-                char* new_output = (char*)realloc(output, buffer_size);
+                while (used + html_len >= buffer_size) buffer_size *= 2;
+                char* new_output = (char*)mem_realloc(MEM_RENDER, output, buffer_size);
                 if (!new_output) {
-                    free(block_html);
-                    free(output);
+                    mem_free(MEM_RENDER, block_html);
+                    mem_free(MEM_RENDER, output);
                     return NULL;
                 }
                 output = new_output;
@@ -506,7 +619,7 @@ char* get_html_output(ParserContext* ctx) {
             
             strcpy(output + used, block_html);
             used += html_len;
-            free(block_html);
+            mem_free(MEM_RENDER, block_html);
         }
         
         block = block->next;
@@ -519,9 +632,9 @@ char* get_html_output(ParserContext* ctx) {
         size_t len = strlen(list_end);
         if (used + len >= buffer_size) {
             buffer_size *= 2;
-            char* new_output = (char*)realloc(output, buffer_size);
+            char* new_output = (char*)mem_realloc(MEM_RENDER, output, buffer_size);
             if (!new_output) {
-                free(output);
+                mem_free(MEM_RENDER, output);
                 return NULL;
             }
             output = new_output;
@@ -533,6 +646,27 @@ char* get_html_output(ParserContext* ctx) {
     return output;
 }
 
+// 流式解析：add_block 把块直接交给 sink，结束时与 get_html_output 一样关闭未结束的列表
+int parse_markdown_streaming(ParserContext* ctx, const char* content, size_t length,
+                             HtmlSink sink, void* user) {
+    if (!ctx || !content || !sink) return 0;
+    
+    ctx->sink = sink;
+    ctx->sink_user = user;
+    ctx->sink_list = 0;
+    ctx->block_count = 0;
+    int result = parse_markdown_indexed(ctx, content, length, NULL);
+    if (result && ctx->sink_list) {
+        char list_end[10];
+        snprintf(list_end, sizeof(list_end), "</%cl>\n", ctx->sink_list);
+        sink(user, list_end, strlen(list_end));
+    }
+    ctx->sink = NULL;
+    ctx->sink_user = NULL;
+    ctx->sink_list = 0;
+    return result;
+}
+
 // 转义HTML
 char* escape_html(const char* str) {
     if (!str) return NULL;
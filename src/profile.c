@@ -0,0 +1,259 @@
+#include "../include/profile.h"
+#include "../include/optimization.h"
+#include "../include/memstats.h"
+#include "../include/utils.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef _WIN32
+#include <pthread.h>
+#endif
+
+typedef struct {
+    ProfilePhase phase;
+    const char* subject;
+    long long start_ns;
+    long long duration_ns;
+} ProfileEvent;
+
+// 每个线程一个缓冲区，记录时无需加锁；只有首次记录时把缓冲区挂到全局链表上
+typedef struct ProfileBuffer {
+    ProfileEvent* events;
+    int count;
+    int capacity;
+    int thread_id;
+    struct ProfileBuffer* next;
+} ProfileBuffer;
+
+// 每篇文章各阶段的耗时合计
+typedef struct {
+    const char* subject;
+    long long phase_ns[PROFILE_PHASE_COUNT];
+    long long total_ns;
+} PostProfile;
+
+static const char* phase_names[PROFILE_PHASE_COUNT] = {
+    "scan", "read", "front matter", "parse", "render", "template", "write", "compress"
+};
+
+static int profiling = 0;
+static long long origin_ns = 0;
+static ProfileBuffer* buffers = NULL;
+static int thread_count = 0;
+static _Thread_local ProfileBuffer* local_buffer = NULL;
+
+#ifndef _WIN32
+static pthread_mutex_t buffers_lock = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+void profile_enable(void) {
+    origin_ns = monotonic_ns();
+    profiling = 1;
+}
+
+int profile_enabled(void) {
+    return profiling;
+}
+
+static ProfileBuffer* thread_buffer(void) {
+    if (local_buffer) return local_buffer;
+
+    ProfileBuffer* buffer = mem_calloc(MEM_GENERAL, 1, sizeof(ProfileBuffer));
+    if (!buffer) return NULL;
+
+#ifndef _WIN32
+    pthread_mutex_lock(&buffers_lock);
+#endif
+    buffer->thread_id = ++thread_count;
+    buffer->next = buffers;
+    buffers = buffer;
+#ifndef _WIN32
+    pthread_mutex_unlock(&buffers_lock);
+#endif
+
+    local_buffer = buffer;
+    return buffer;
+}
+
+ProfileSpan profile_begin(ProfilePhase phase, const char* subject) {
+    ProfileSpan span = {phase, subject, 0};
+    if (profiling) span.start_ns = monotonic_ns();
+    return span;
+}
+
+void profile_end(const ProfileSpan* span) {
+    if (!profiling || !span->start_ns) return;
+
+    long long end_ns = monotonic_ns();
+    ProfileBuffer* buffer = thread_buffer();
+    if (!buffer) return;
+
+    if (buffer->count == buffer->capacity) {
+        int new_capacity = buffer->capacity ? buffer->capacity * 2 : 256;
+        ProfileEvent* events = mem_realloc(MEM_GENERAL, buffer->events, new_capacity * sizeof(ProfileEvent));
+        if (!events) return;
+        buffer->events = events;
+        buffer->capacity = new_capacity;
+    }
+
+    ProfileEvent* event = &buffer->events[buffer->count++];
+    event->phase = span->phase;
+    event->subject = span->subject;
+    event->start_ns = span->start_ns;
+    event->duration_ns = end_ns - span->start_ns;
+}
+
+static void write_json_string(FILE* fp, const char* str) {
+    fputc('"', fp);
+    for (const unsigned char* p = (const unsigned char*)str; *p; p++) {
+        if (*p == '"' || *p == '\\') {
+            fputc('\\', fp);
+            fputc(*p, fp);
+        } else if (*p < 0x20) {
+            fprintf(fp, "\\u%04x", *p);
+        } else {
+            fputc(*p, fp);
+        }
+    }
+    fputc('"', fp);
+}
+
+static int write_trace(const char* path) {
+    FILE* fp = fopen(path, "w");
+    if (!fp) return 0;
+
+    // 时间戳以微秒为单位，相对于开始分析的时刻
+    fprintf(fp, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    int first = 1;
+    for (ProfileBuffer* buffer = buffers; buffer; buffer = buffer->next) {
+        fprintf(fp, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"worker %d\"}}",
+                first ? "" : ",\n", buffer->thread_id, buffer->thread_id);
+        first = 0;
+
+        for (int i = 0; i < buffer->count; i++) {
+            const ProfileEvent* event = &buffer->events[i];
+            fprintf(fp, ",\n{\"name\":\"%s\",\"cat\":\"build\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f",
+                    phase_names[event->phase], buffer->thread_id,
+                    (event->start_ns - origin_ns) / 1000.0, event->duration_ns / 1000.0);
+            if (event->subject) {
+                fprintf(fp, ",\"args\":{\"path\":");
+                write_json_string(fp, event->subject);
+                fputc('}', fp);
+            }
+            fputc('}', fp);
+        }
+    }
+    fprintf(fp, "\n]}\n");
+
+    int ok = !ferror(fp);
+    if (fclose(fp) != 0) ok = 0;
+    return ok;
+}
+
+static int compare_events_by_subject(const void* a, const void* b) {
+    const ProfileEvent* ea = *(const ProfileEvent* const*)a;
+    const ProfileEvent* eb = *(const ProfileEvent* const*)b;
+    return strcmp(ea->subject, eb->subject);
+}
+
+static int compare_posts_by_total(const void* a, const void* b) {
+    const PostProfile* pa = (const PostProfile*)a;
+    const PostProfile* pb = (const PostProfile*)b;
+    if (pa->total_ns != pb->total_ns) return pa->total_ns < pb->total_ns ? 1 : -1;
+    return strcmp(pa->subject, pb->subject);
+}
+
+static void print_summary(int top_n) {
+    long long phase_ns[PROFILE_PHASE_COUNT] = {0};
+    int phase_count[PROFILE_PHASE_COUNT] = {0};
+    int post_events = 0;
+
+    for (ProfileBuffer* buffer = buffers; buffer; buffer = buffer->next) {
+        for (int i = 0; i < buffer->count; i++) {
+            const ProfileEvent* event = &buffer->events[i];
+            phase_ns[event->phase] += event->duration_ns;
+            phase_count[event->phase]++;
+            if (event->subject && event->phase >= PROFILE_READ && event->phase <= PROFILE_WRITE) post_events++;
+        }
+    }
+
+    // 各阶段的合计是所有线程耗时之和，并行时可能超过总的构建时间
+    printf("Profile: %.1f ms elapsed, %d thread(s)\n", (monotonic_ns() - origin_ns) / 1e6, thread_count);
+    for (int p = 0; p < PROFILE_PHASE_COUNT; p++) {
+        if (!phase_count[p]) continue;
+        printf("  %-13s %10.2f ms  (%d)\n", phase_names[p], phase_ns[p] / 1e6, phase_count[p]);
+    }
+    if (!post_events || top_n <= 0) return;
+
+    // 按路径排序后相邻的事件属于同一篇文章
+    const ProfileEvent** events = mem_malloc(MEM_GENERAL, post_events * sizeof(ProfileEvent*));
+    PostProfile* posts = mem_calloc(MEM_GENERAL, post_events, sizeof(PostProfile));
+    if (!events || !posts) {
+        mem_free(MEM_GENERAL, events);
+        mem_free(MEM_GENERAL, posts);
+        return;
+    }
+
+    int n = 0;
+    for (ProfileBuffer* buffer = buffers; buffer; buffer = buffer->next) {
+        for (int i = 0; i < buffer->count; i++) {
+            const ProfileEvent* event = &buffer->events[i];
+            if (event->subject && event->phase >= PROFILE_READ && event->phase <= PROFILE_WRITE) {
+                events[n++] = event;
+            }
+        }
+    }
+    qsort(events, n, sizeof(ProfileEvent*), compare_events_by_subject);
+
+    int post_count = 0;
+    for (int i = 0; i < n; i++) {
+        if (post_count == 0 || strcmp(posts[post_count - 1].subject, events[i]->subject) != 0) {
+            posts[post_count++].subject = events[i]->subject;
+        }
+        PostProfile* post = &posts[post_count - 1];
+        post->phase_ns[events[i]->phase] += events[i]->duration_ns;
+        post->total_ns += events[i]->duration_ns;
+    }
+    qsort(posts, post_count, sizeof(PostProfile), compare_posts_by_total);
+
+    if (top_n > post_count) top_n = post_count;
+    printf("Slowest %d post(s):\n", top_n);
+    for (int i = 0; i < top_n; i++) {
+        const PostProfile* post = &posts[i];
+        printf("  %8.2f ms  %s  (read %.2f, front matter %.2f, parse %.2f, render %.2f, template %.2f, write %.2f)\n",
+               post->total_ns / 1e6, post->subject,
+               post->phase_ns[PROFILE_READ] / 1e6, post->phase_ns[PROFILE_FRONT_MATTER] / 1e6,
+               post->phase_ns[PROFILE_PARSE] / 1e6, post->phase_ns[PROFILE_RENDER] / 1e6,
+               post->phase_ns[PROFILE_TEMPLATE] / 1e6, post->phase_ns[PROFILE_WRITE] / 1e6);
+    }
+
+    mem_free(MEM_GENERAL, events);
+    mem_free(MEM_GENERAL, posts);
+}
+
+int profile_report(const char* trace_path, int top_n) {
+    if (!profiling) return 1;
+    profiling = 0;
+
+    int ok = write_trace(trace_path);
+    if (ok) {
+        printf("Profile trace written to %s\n", trace_path);
+    } else {
+        log_error("Could not write profile trace %s", trace_path);
+    }
+    print_summary(top_n);
+    return ok;
+}
+
+void profile_shutdown(void) {
+    profiling = 0;
+    while (buffers) {
+        ProfileBuffer* next = buffers->next;
+        mem_free(MEM_GENERAL, buffers->events);
+        mem_free(MEM_GENERAL, buffers);
+        buffers = next;
+    }
+    thread_count = 0;
+    local_buffer = NULL;
+}
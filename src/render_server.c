@@ -0,0 +1,502 @@
+#define _GNU_SOURCE
+#include "../include/render_server.h"
+#include "../include/blog.h"
+#include "../include/optimization.h"
+#include "../include/memstats.h"
+#include "../include/utils.h"
+#include <errno.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <sys/un.h>
+
+#define RENDER_MAX_EVENTS 64
+#define RENDER_READ_CHUNK (64 * 1024)
+#define RENDER_HEADER_SIZE (RENDER_HEADER_FIELDS * 4)
+
+typedef struct RenderServer RenderServer;
+
+// 连接在任一时刻只属于一方：等待数据时属于事件循环（EPOLLONESHOT 已注册），
+// 收到完整请求后交给工作线程，应答发送完毕再重新注册
+typedef struct RenderConnection {
+    int fd;
+    char* buffer;
+    size_t length;
+    size_t capacity;
+    int eof;                  // 客户端已关闭写端，处理完已收到的请求后关闭连接
+    atomic_int busy;          // 交给工作线程时置 1，工作线程重新注册之后清零
+    CancelToken token;
+    RenderServer* server;
+    struct RenderConnection* prev;
+    struct RenderConnection* next;
+} RenderConnection;
+
+// 工作线程各自的渲染上下文，服务结束时统一释放
+typedef struct RendererSlot {
+    BlogRenderer* renderer;
+    struct RendererSlot* next;
+} RendererSlot;
+
+struct RenderServer {
+    const RenderServerConfig* config;
+    int epoll_fd;
+    int listen_fd;
+    WorkerPool* workers;
+    BlogTemplate* tpl;
+    pthread_mutex_t lock;     // 保护 connections 和 renderers
+    RenderConnection* connections;
+    RendererSlot* renderers;
+};
+
+static volatile sig_atomic_t render_stop = 0;
+static _Thread_local BlogRenderer* thread_renderer = NULL;
+static char listen_tag;
+
+static void handle_stop_signal(int sig) {
+    (void)sig;
+    render_stop = 1;
+}
+
+static uint32_t read_u32(const char* p) {
+    const unsigned char* b = (const unsigned char*)p;
+    return ((uint32_t)b[0] << 24) | ((uint32_t)b[1] << 16) | ((uint32_t)b[2] << 8) | b[3];
+}
+
+static void write_u32(char* p, uint32_t value) {
+    p[0] = (char)(value >> 24);
+    p[1] = (char)(value >> 16);
+    p[2] = (char)(value >> 8);
+    p[3] = (char)value;
+}
+
+// 缓冲区开头的请求：返回 1 表示完整（*total 为请求长度），0 表示还需要数据，-1 表示格式错误
+static int request_length(const RenderConnection* conn, size_t* total) {
+    if (conn->length < RENDER_HEADER_SIZE) return 0;
+
+    uint32_t mode = read_u32(conn->buffer);
+    if (mode != RENDER_MODE_FRAGMENT && mode != RENDER_MODE_PAGE) return -1;
+
+    size_t size = RENDER_HEADER_SIZE;
+    for (int i = 1; i < RENDER_HEADER_FIELDS; i++) {
+        size += read_u32(conn->buffer + i * 4);
+        if (size > RENDER_MAX_REQUEST) return -1;
+    }
+    *total = size;
+    return conn->length >= size;
+}
+
+static BlogRenderer* worker_renderer(RenderServer* server) {
+    if (thread_renderer) return thread_renderer;
+
+    RendererSlot* slot = mem_malloc(MEM_SERVER, sizeof(RendererSlot));
+    BlogRenderer* renderer = slot ? blog_renderer_create() : NULL;
+    if (!renderer) {
+        mem_free(MEM_SERVER, slot);
+        return NULL;
+    }
+
+    slot->renderer = renderer;
+    pthread_mutex_lock(&server->lock);
+    slot->next = server->renderers;
+    server->renderers = slot;
+    pthread_mutex_unlock(&server->lock);
+
+    thread_renderer = renderer;
+    return renderer;
+}
+
+static void close_connection(RenderServer* server, RenderConnection* conn) {
+    epoll_ctl(server->epoll_fd, EPOLL_CTL_DEL, conn->fd, NULL);
+    close(conn->fd);
+
+    pthread_mutex_lock(&server->lock);
+    if (conn->prev) conn->prev->next = conn->next;
+    else server->connections = conn->next;
+    if (conn->next) conn->next->prev = conn->prev;
+    pthread_mutex_unlock(&server->lock);
+
+    mem_free(MEM_SERVER, conn->buffer);
+    mem_free(MEM_SERVER, conn);
+}
+
+// 套接字是非阻塞的；发送缓冲区满时等待可写，客户端长时间不读取则放弃
+static int send_all(int fd, struct iovec* iov, int count) {
+    while (count > 0) {
+        ssize_t sent = writev(fd, iov, count);
+        if (sent < 0) {
+            if (errno == EINTR) continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK) return 0;
+            struct pollfd pfd = { .fd = fd, .events = POLLOUT };
+            if (poll(&pfd, 1, RENDER_SEND_TIMEOUT_MS) <= 0) return 0;
+            continue;
+        }
+        while (count > 0 && (size_t)sent >= iov->iov_len) {
+            sent -= iov->iov_len;
+            iov++;
+            count--;
+        }
+        if (count > 0) {
+            iov->iov_base = (char*)iov->iov_base + sent;
+            iov->iov_len -= sent;
+        }
+    }
+    return 1;
+}
+
+static int send_reply(int fd, BlogStatus status, const char* body, size_t length) {
+    char header[8];
+    write_u32(header, (uint32_t)status);
+    write_u32(header + 4, (uint32_t)length);
+    struct iovec iov[2] = {
+        { .iov_base = header, .iov_len = sizeof(header) },
+        { .iov_base = (void*)body, .iov_len = length }
+    };
+    return send_all(fd, iov, length ? 2 : 1);
+}
+
+static char* copy_field(const char* data, size_t length) {
+    if (length == 0) return NULL;
+    char* copy = mem_malloc(MEM_SERVER, length + 1);
+    if (copy) {
+        memcpy(copy, data, length);
+        copy[length] = '\0';
+    }
+    return copy;
+}
+
+// 处理一个完整的请求并发送应答；返回 0 表示连接已不可用
+static int serve_request(RenderServer* server, RenderConnection* conn, size_t total) {
+    long long start = monotonic_ns();
+    uint32_t mode = read_u32(conn->buffer);
+    size_t lengths[RENDER_HEADER_FIELDS - 1];
+    for (int i = 0; i < RENDER_HEADER_FIELDS - 1; i++) {
+        lengths[i] = read_u32(conn->buffer + (i + 1) * 4);
+    }
+
+    const char* markdown = conn->buffer + RENDER_HEADER_SIZE;
+    const char* field = markdown + lengths[0];
+    char* values[4];
+    int has_metadata = 0;
+    for (int i = 0; i < 4; i++) {
+        values[i] = copy_field(field, lengths[i + 1]);
+        if (lengths[i + 1]) has_metadata = 1;
+        field += lengths[i + 1];
+    }
+    BlogMetadata metadata = { values[0], values[1], values[2], values[3] };
+
+    BlogRenderer* renderer = worker_renderer(server);
+    const char* html = NULL;
+    size_t html_length = 0;
+    BlogStatus status;
+    if (!renderer) {
+        status = BLOG_ERROR_MEMORY;
+    } else if (mode == RENDER_MODE_PAGE && server->tpl) {
+        status = blog_render_page_arena(renderer, server->tpl, markdown, lengths[0],
+                                        has_metadata ? &metadata : NULL, &html, &html_length);
+    } else if (mode == RENDER_MODE_PAGE) {
+        status = BLOG_ERROR_INVALID;
+    } else {
+        status = blog_render_markdown_arena(renderer, markdown, lengths[0], &html, &html_length);
+    }
+    for (int i = 0; i < 4; i++) mem_free(MEM_SERVER, values[i]);
+
+    if (status != BLOG_OK) {
+        if (mode == RENDER_MODE_PAGE && !server->tpl) {
+            html = "No template loaded";
+        } else if (renderer && blog_renderer_error(renderer)[0]) {
+            html = blog_renderer_error(renderer);
+        } else {
+            html = blog_status_message(status);
+        }
+        html_length = strlen(html);
+    }
+    log_debug("Rendered %zu byte(s) of markdown in %.3f ms (status %d)",
+              lengths[0], (monotonic_ns() - start) / 1e6, (int)status);
+
+    int ok = send_reply(conn->fd, status, html, html_length);
+
+    // 丢弃已处理的请求，保留之后已经收到的数据
+    memmove(conn->buffer, conn->buffer + total, conn->length - total);
+    conn->length -= total;
+    return ok;
+}
+
+// 把连接交还给事件循环；注册成功后不能再访问 conn，只清零 busy
+static void rearm_connection(RenderServer* server, RenderConnection* conn) {
+    struct epoll_event ev = { .events = EPOLLIN | EPOLLONESHOT, .data.ptr = conn };
+    if (epoll_ctl(server->epoll_fd, EPOLL_CTL_MOD, conn->fd, &ev) != 0) {
+        close_connection(server, conn);
+        return;
+    }
+    atomic_store_explicit(&conn->busy, 0, memory_order_release);
+}
+
+// 工作线程：依次处理缓冲区中所有完整的请求，然后把连接交还给事件循环
+static void connection_task(void* arg) {
+    RenderConnection* conn = arg;
+    RenderServer* server = conn->server;
+    size_t total;
+    int state;
+
+    while ((state = request_length(conn, &total)) == 1) {
+        // 同一连接上的每个请求各自计算时间预算
+        cancel_token_restart(&conn->token);
+        if (!serve_request(server, conn, total)) {
+            close_connection(server, conn);
+            return;
+        }
+    }
+
+    if (state < 0) {
+        const char* message = "Malformed or oversized request";
+        send_reply(conn->fd, BLOG_ERROR_INVALID, message, strlen(message));
+        close_connection(server, conn);
+        return;
+    }
+    if (conn->eof) {
+        close_connection(server, conn);
+        return;
+    }
+    rearm_connection(server, conn);
+}
+
+static int reserve(RenderConnection* conn, size_t needed) {
+    if (needed <= conn->capacity) return 1;
+    size_t capacity = conn->capacity ? conn->capacity : RENDER_READ_CHUNK;
+    while (capacity < needed) capacity *= 2;
+    char* buffer = mem_realloc(MEM_SERVER, conn->buffer, capacity);
+    if (!buffer) return 0;
+    conn->buffer = buffer;
+    conn->capacity = capacity;
+    return 1;
+}
+
+static void handle_readable(RenderServer* server, RenderConnection* conn) {
+    // 工作线程重新注册和清零 busy 之间可能已经收到事件，等它清零后再接手连接
+    while (atomic_load_explicit(&conn->busy, memory_order_acquire)) sched_yield();
+
+    for (;;) {
+        // 缓冲区中已有一个完整的请求（或格式错误）时停止读取，之后的数据留在套接字里，
+        // 连接重新注册后再读；缓冲区因此不会超过一个请求，即至多 RENDER_MAX_REQUEST 字节
+        size_t total = 0;
+        if (request_length(conn, &total) != 0) break;
+
+        // 请求头还没收全时按块读取，知道请求长度后一次扩容到位，只读到请求末尾
+        size_t want = total ? total : RENDER_READ_CHUNK;
+        if (!reserve(conn, want)) {
+            close_connection(server, conn);
+            return;
+        }
+
+        ssize_t n = read(conn->fd, conn->buffer + conn->length, want - conn->length);
+        if (n > 0) {
+            conn->length += n;
+            continue;
+        }
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+        if (n < 0) {
+            close_connection(server, conn);
+            return;
+        }
+        conn->eof = 1;
+        break;
+    }
+
+    size_t total;
+    int state = request_length(conn, &total);
+    if (state != 0) {
+        cancel_token_init(&conn->token, server->config->budget_ms);
+        atomic_store_explicit(&conn->busy, 1, memory_order_relaxed);
+        if (!worker_pool_submit_with_token(server->workers, connection_task, conn, &conn->token)) {
+            close_connection(server, conn);
+        }
+        return;
+    }
+    if (conn->eof) {
+        close_connection(server, conn);
+        return;
+    }
+    rearm_connection(server, conn);
+}
+
+static void accept_connections(RenderServer* server) {
+    for (;;) {
+        int fd = accept4(server->listen_fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno == EINTR) continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                log_warn("accept failed (errno: %d)", errno);
+            }
+            return;
+        }
+
+        RenderConnection* conn = mem_calloc(MEM_SERVER, 1, sizeof(RenderConnection));
+        if (!conn) {
+            close(fd);
+            continue;
+        }
+        conn->fd = fd;
+        conn->server = server;
+
+        pthread_mutex_lock(&server->lock);
+        conn->next = server->connections;
+        if (conn->next) conn->next->prev = conn;
+        server->connections = conn;
+        pthread_mutex_unlock(&server->lock);
+
+        struct epoll_event ev = { .events = EPOLLIN | EPOLLONESHOT, .data.ptr = conn };
+        if (epoll_ctl(server->epoll_fd, EPOLL_CTL_ADD, fd, &ev) != 0) {
+            close_connection(server, conn);
+        }
+    }
+}
+
+static int open_listener(const char* path) {
+    struct sockaddr_un addr = { .sun_family = AF_UNIX };
+    if (strlen(path) >= sizeof(addr.sun_path)) {
+        errno = ENAMETOOLONG;
+        return -1;
+    }
+    strcpy(addr.sun_path, path);
+
+    // 上次没有正常退出时留下的套接字文件；其他类型的文件不动
+    struct stat st;
+    if (lstat(path, &st) == 0 && S_ISSOCK(st.st_mode)) unlink(path);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) return -1;
+    if (bind(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0 || listen(fd, SOMAXCONN) != 0) {
+        int saved = errno;
+        close(fd);
+        errno = saved;
+        return -1;
+    }
+    return fd;
+}
+
+static BlogTemplate* load_template(const char* path) {
+    FILE* fp = path ? fopen(path, "rb") : NULL;
+    if (!fp) return NULL;
+
+    fseek(fp, 0, SEEK_END);
+    long size = ftell(fp);
+    rewind(fp);
+    char* source = size >= 0 ? mem_malloc(MEM_SERVER, size + 1) : NULL;
+    size_t length = source ? fread(source, 1, size, fp) : 0;
+    fclose(fp);
+
+    BlogTemplate* tpl = source ? blog_template_compile(source, length) : NULL;
+    mem_free(MEM_SERVER, source);
+    return tpl;
+}
+
+int run_render_server(const RenderServerConfig* config) {
+    if (!config || !config->socket_path) return 0;
+
+    RenderServer* server = mem_calloc(MEM_SERVER, 1, sizeof(RenderServer));
+    if (!server) return 0;
+    server->config = config;
+    pthread_mutex_init(&server->lock, NULL);
+
+    server->tpl = load_template(config->template_path);
+    if (!server->tpl) {
+        log_warn("Could not load template %s, only fragment requests will be served",
+                 config->template_path ? config->template_path : "(none)");
+    }
+
+    server->listen_fd = open_listener(config->socket_path);
+    if (server->listen_fd < 0) {
+        log_error("Could not listen on %s (errno: %d)", config->socket_path, errno);
+        blog_template_destroy(server->tpl);
+        mem_free(MEM_SERVER, server);
+        return 0;
+    }
+
+    server->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    server->workers = worker_pool_create(config->workers);
+    struct epoll_event ev = { .events = EPOLLIN, .data.ptr = &listen_tag };
+    if (server->epoll_fd < 0 || !server->workers ||
+        epoll_ctl(server->epoll_fd, EPOLL_CTL_ADD, server->listen_fd, &ev) != 0) {
+        log_error("Could not set up the render server (errno: %d)", errno);
+        if (server->epoll_fd >= 0) close(server->epoll_fd);
+        worker_pool_destroy(server->workers);
+        close(server->listen_fd);
+        unlink(config->socket_path);
+        blog_template_destroy(server->tpl);
+        mem_free(MEM_SERVER, server);
+        return 0;
+    }
+
+    render_stop = 0;
+    signal(SIGINT, handle_stop_signal);
+    signal(SIGTERM, handle_stop_signal);
+    signal(SIGPIPE, SIG_IGN);
+
+    log_info("Render server listening on %s with %d worker(s) (press Ctrl+C to stop)",
+             config->socket_path, worker_pool_size(server->workers));
+
+    struct epoll_event events[RENDER_MAX_EVENTS];
+    while (!render_stop) {
+        int count = epoll_wait(server->epoll_fd, events, RENDER_MAX_EVENTS, 1000);
+        if (count < 0) {
+            if (errno == EINTR) continue;
+            log_error("epoll_wait failed (errno: %d)", errno);
+            break;
+        }
+
+        for (int i = 0; i < count; i++) {
+            if (events[i].data.ptr == &listen_tag) {
+                accept_connections(server);
+            } else {
+                // 出错或挂断时 read 会返回错误或 0，统一在读取时处理
+                handle_readable(server, events[i].data.ptr);
+            }
+        }
+    }
+
+    log_info("Stopping render server");
+    worker_pool_destroy(server->workers);
+    while (server->connections) {
+        close_connection(server, server->connections);
+    }
+    while (server->renderers) {
+        RendererSlot* next = server->renderers->next;
+        blog_renderer_destroy(server->renderers->renderer);
+        mem_free(MEM_SERVER, server->renderers);
+        server->renderers = next;
+    }
+    thread_renderer = NULL;
+
+    close(server->epoll_fd);
+    close(server->listen_fd);
+    unlink(config->socket_path);
+    blog_template_destroy(server->tpl);
+    pthread_mutex_destroy(&server->lock);
+    mem_free(MEM_SERVER, server);
+    return 1;
+}
+
+#else
+
+int run_render_server(const RenderServerConfig* config) {
+    (void)config;
+    log_error("The render server is only supported on Linux");
+    return 0;
+}
+
+#endif
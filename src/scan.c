@@ -0,0 +1,258 @@
+#define _GNU_SOURCE
+#include "../include/scan.h"
+#include "../include/memstats.h"
+#include "../include/utils.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#endif
+
+void free_scan_result(ScanResult* result) {
+    if (!result) return;
+
+    for (int i = 0; i < result->count; i++) {
+        mem_free(MEM_SCAN, result->entries[i].path);
+    }
+    mem_free(MEM_SCAN, result->entries);
+    memset(result, 0, sizeof(ScanResult));
+}
+
+static int add_entry(ScanResult* result, char* path, long long size, long long mtime_ns) {
+    if (result->count == result->capacity) {
+        int new_capacity = result->capacity ? result->capacity * 2 : 256;
+        ScanEntry* entries = mem_realloc(MEM_SCAN, result->entries, new_capacity * sizeof(ScanEntry));
+        if (!entries) return 0;
+        result->entries = entries;
+        result->capacity = new_capacity;
+    }
+
+    ScanEntry* entry = &result->entries[result->count++];
+    entry->path = path;
+    entry->size = size;
+    entry->mtime_ns = mtime_ns;
+    return 1;
+}
+
+static int compare_by_size(const void* a, const void* b) {
+    const ScanEntry* ea = (const ScanEntry*)a;
+    const ScanEntry* eb = (const ScanEntry*)b;
+    if (ea->size != eb->size) return ea->size < eb->size ? 1 : -1;
+    return strcmp(ea->path, eb->path);
+}
+
+void sort_scan_by_size(ScanResult* result) {
+    if (result && result->count > 1) {
+        qsort(result->entries, result->count, sizeof(ScanEntry), compare_by_size);
+    }
+}
+
+static char* join_relative(const char* dir, const char* name) {
+    size_t dir_len = strlen(dir);
+    size_t size = dir_len + strlen(name) + 2;
+    char* path = mem_malloc(MEM_SCAN, size);
+    if (path) {
+        const char* separator = dir_len && (dir[dir_len - 1] == '/' || dir[dir_len - 1] == '\\') ? "" : "/";
+        snprintf(path, size, "%s%s%s", dir, separator, name);
+    }
+    return path;
+}
+
+#ifdef _WIN32
+
+static int scan_directory(const char* dir, ScanResult* result) {
+    char pattern[MAX_PATH];
+    snprintf(pattern, sizeof(pattern), "%s\\*", dir);
+
+    WIN32_FIND_DATA find_data;
+    HANDLE handle = FindFirstFile(pattern, &find_data);
+    if (handle == INVALID_HANDLE_VALUE) return 0;
+
+    int success = 1;
+    do {
+        if (find_data.cFileName[0] == '.') continue;
+
+        char* path = join_relative(dir, find_data.cFileName);
+        if (!path) {
+            success = 0;
+            break;
+        }
+
+        if (find_data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) {
+            success = scan_directory(path, result) && success;
+            mem_free(MEM_SCAN, path);
+        } else if (is_markdown_file(find_data.cFileName)) {
+            // 与 POSIX 一致使用 stat 的时间，增量构建比较时才能对上
+            struct stat st;
+            if (stat(path, &st) != 0) {
+                mem_free(MEM_SCAN, path);
+                continue;
+            }
+            if (!add_entry(result, path, (long long)st.st_size, stat_mtime_ns(&st))) {
+                mem_free(MEM_SCAN, path);
+                success = 0;
+            }
+        } else {
+            mem_free(MEM_SCAN, path);
+        }
+    } while (FindNextFile(handle, &find_data));
+
+    FindClose(handle);
+    return success;
+}
+
+int scan_markdown_files(const char* root, WorkerPool* workers, ScanResult* result) {
+    (void)workers;
+    if (!root || !result) return 0;
+    memset(result, 0, sizeof(ScanResult));
+    return scan_directory(root, result);
+}
+
+#else
+
+// 扫描共享状态：结果数组由互斥锁保护，每个目录只加锁一次
+typedef struct {
+    WorkerPool* workers;
+    ScanResult* result;
+    pthread_mutex_t lock;
+    atomic_int failed;
+} ScanJob;
+
+// 单个目录的扫描任务，dir_fd 由父目录打开后交给任务，任务结束时关闭
+typedef struct {
+    ScanJob* job;
+    int dir_fd;
+    char* path;
+} ScanTask;
+
+static void scan_task(void* arg);
+
+static void submit_directory(ScanJob* job, int dir_fd, char* path) {
+    ScanTask* task = mem_malloc(MEM_SCAN, sizeof(ScanTask));
+    if (!task) {
+        close(dir_fd);
+        mem_free(MEM_SCAN, path);
+        atomic_store(&job->failed, 1);
+        return;
+    }
+
+    task->job = job;
+    task->dir_fd = dir_fd;
+    task->path = path;
+    if (!job->workers || !worker_pool_submit(job->workers, scan_task, task)) {
+        scan_task(task);
+    }
+}
+
+static void scan_task(void* arg) {
+    ScanTask* task = (ScanTask*)arg;
+    ScanJob* job = task->job;
+    ScanResult local = {0};
+
+    DIR* dir = fdopendir(task->dir_fd);
+    if (!dir) {
+        close(task->dir_fd);
+        atomic_store(&job->failed, 1);
+        mem_free(MEM_SCAN, task->path);
+        mem_free(MEM_SCAN, task);
+        return;
+    }
+
+    struct dirent* entry;
+    while ((entry = readdir(dir)) != NULL) {
+        if (entry->d_name[0] == '.') continue;
+
+        int is_dir = entry->d_type == DT_DIR;
+        int is_reg = entry->d_type == DT_REG;
+
+        // 只有 Markdown 文件需要 stat；目录靠 d_type 判断，文件系统不提供时才 fstatat
+        // 指向文件的符号链接照常处理，指向目录的不进入，否则 loop -> .. 这类链接会无限递归
+        struct stat st;
+        int have_stat = 0;
+        if (entry->d_type == DT_UNKNOWN || entry->d_type == DT_LNK) {
+            if (fstatat(dirfd(dir), entry->d_name, &st, AT_SYMLINK_NOFOLLOW) != 0) continue;
+            int is_link = S_ISLNK(st.st_mode);
+            if (is_link && fstatat(dirfd(dir), entry->d_name, &st, 0) != 0) continue;
+            if (is_link && S_ISDIR(st.st_mode)) {
+                log_debug("Skipping symlinked directory %s/%s", task->path, entry->d_name);
+                continue;
+            }
+            is_dir = S_ISDIR(st.st_mode);
+            is_reg = S_ISREG(st.st_mode);
+            have_stat = 1;
+        }
+
+        if (is_dir) {
+            int child_fd = openat(dirfd(dir), entry->d_name, O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+            char* child_path = join_relative(task->path, entry->d_name);
+            if (child_fd < 0 || !child_path) {
+                if (child_fd >= 0) close(child_fd);
+                mem_free(MEM_SCAN, child_path);
+                atomic_store(&job->failed, 1);
+                continue;
+            }
+            submit_directory(job, child_fd, child_path);
+        } else if (is_reg && is_markdown_file(entry->d_name)) {
+            if (!have_stat && fstatat(dirfd(dir), entry->d_name, &st, 0) != 0) continue;
+
+            char* path = join_relative(task->path, entry->d_name);
+            if (!path || !add_entry(&local, path, (long long)st.st_size, stat_mtime_ns(&st))) {
+                mem_free(MEM_SCAN, path);
+                atomic_store(&job->failed, 1);
+            }
+        }
+    }
+    closedir(dir);
+
+    if (local.count > 0) {
+        pthread_mutex_lock(&job->lock);
+        for (int i = 0; i < local.count; i++) {
+            ScanEntry* e = &local.entries[i];
+            if (!add_entry(job->result, e->path, e->size, e->mtime_ns)) {
+                mem_free(MEM_SCAN, e->path);
+                atomic_store(&job->failed, 1);
+            }
+        }
+        pthread_mutex_unlock(&job->lock);
+    }
+    mem_free(MEM_SCAN, local.entries);
+    mem_free(MEM_SCAN, task->path);
+    mem_free(MEM_SCAN, task);
+}
+
+int scan_markdown_files(const char* root, WorkerPool* workers, ScanResult* result) {
+    if (!root || !result) return 0;
+    memset(result, 0, sizeof(ScanResult));
+
+    int root_fd = open(root, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (root_fd < 0) return 0;
+
+    char* root_path = mem_strdup(MEM_SCAN, root);
+    if (!root_path) {
+        close(root_fd);
+        return 0;
+    }
+
+    ScanJob job;
+    job.workers = workers;
+    job.result = result;
+    pthread_mutex_init(&job.lock, NULL);
+    atomic_init(&job.failed, 0);
+
+    submit_directory(&job, root_fd, root_path);
+    if (workers) worker_pool_wait(workers);
+    pthread_mutex_destroy(&job.lock);
+
+    return !atomic_load(&job.failed);
+}
+
+#endif
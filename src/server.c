@@ -0,0 +1,735 @@
+#define _GNU_SOURCE
+#include "../include/server.h"
+#include "../include/optimization.h"
+#include "../include/parser.h"
+#include "../include/utils.h"
+#include <errno.h>
+#include <signal.h>
+#include <time.h>
+#include <ctype.h>
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/epoll.h>
+#include <sys/sendfile.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+
+#define SERVER_MAX_EVENTS 256
+#define CACHE_BUCKETS 1024
+#define SENDFILE_CHUNK (1024 * 1024)
+
+// 内存中缓存的文件内容，按 mtime 和大小判断是否过期
+typedef struct CachedFile {
+    char* path;
+    char* data;
+    size_t length;
+    struct timespec mtime;
+    char etag[24];
+    int refs;                 // 缓存本身持有一个引用，每个正在发送的连接各持有一个
+    struct CachedFile* next;
+} CachedFile;
+
+// 客户端连接状态
+typedef struct Connection {
+    int fd;
+    char request[SERVER_MAX_REQUEST];
+    size_t request_len;
+    char header[1024];
+    size_t header_len;
+    size_t header_sent;
+    CachedFile* cached;       // 响应体来自缓存时持有的引用
+    const char* body;         // 内存中的响应体
+    size_t body_len;
+    size_t body_sent;
+    int file_fd;              // 大文件通过 sendfile 发送
+    off_t file_offset;
+    off_t file_remaining;
+    int keep_alive;
+    int writing;              // 响应尚未发送完
+    time_t last_active;
+    struct Connection* prev;
+    struct Connection* next;
+} Connection;
+
+typedef struct {
+    const ServerConfig* config;
+    int epoll_fd;
+    int listen_fd;
+    CachedFile* cache[CACHE_BUCKETS];
+    Connection* connections;
+    int connection_count;
+} Server;
+
+static volatile sig_atomic_t server_stop = 0;
+
+// epoll 事件中用来区分监听套接字和监视器的标记
+static char listen_tag;
+static char watch_tag;
+
+static void handle_stop_signal(int sig) {
+    (void)sig;
+    server_stop = 1;
+}
+
+// 常见文件类型
+static const struct {
+    const char* ext;
+    const char* type;
+} mime_types[] = {
+    {"html", "text/html; charset=utf-8"},
+    {"htm", "text/html; charset=utf-8"},
+    {"css", "text/css; charset=utf-8"},
+    {"js", "application/javascript; charset=utf-8"},
+    {"json", "application/json"},
+    {"xml", "application/xml; charset=utf-8"},
+    {"txt", "text/plain; charset=utf-8"},
+    {"svg", "image/svg+xml"},
+    {"png", "image/png"},
+    {"jpg", "image/jpeg"},
+    {"jpeg", "image/jpeg"},
+    {"gif", "image/gif"},
+    {"webp", "image/webp"},
+    {"ico", "image/x-icon"},
+    {"woff2", "font/woff2"}
+};
+
+static const char* mime_type(const char* path) {
+    const char* dot = strrchr(path, '.');
+    const char* slash = strrchr(path, '/');
+    if (dot && (!slash || dot > slash)) {
+        for (size_t i = 0; i < sizeof(mime_types)/sizeof(mime_types[0]); i++) {
+            if (strcasecmp(dot + 1, mime_types[i].ext) == 0) return mime_types[i].type;
+        }
+    }
+    return "application/octet-stream";
+}
+
+// 缓存操作
+static void release_cached(CachedFile* file) {
+    if (file && --file->refs == 0) {
+        mem_free(MEM_SERVER, file->path);
+        mem_free(MEM_SERVER, file->data);
+        mem_free(MEM_SERVER, file);
+    }
+}
+
+static char* read_whole_file(const char* path, size_t size) {
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return NULL;
+
+    char* data = mem_malloc(MEM_SERVER, size ? size : 1);
+    size_t total = 0;
+    while (data && total < size) {
+        ssize_t n = read(fd, data + total, size - total);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) {
+            mem_free(MEM_SERVER, data);
+            data = NULL;
+            break;
+        }
+        total += n;
+    }
+    close(fd);
+    return data;
+}
+
+// 查找或加载缓存文件；文件过大时返回 NULL，由调用者改用 sendfile
+static CachedFile* lookup_cached(Server* server, const char* path, const struct stat* st) {
+    if (st->st_size > SERVER_CACHE_LIMIT) return NULL;
+
+    size_t bucket = content_hash(path, strlen(path)) % CACHE_BUCKETS;
+    CachedFile** link = &server->cache[bucket];
+    while (*link) {
+        CachedFile* file = *link;
+        if (strcmp(file->path, path) == 0) {
+            if (file->mtime.tv_sec == st->st_mtim.tv_sec &&
+                file->mtime.tv_nsec == st->st_mtim.tv_nsec &&
+                file->length == (size_t)st->st_size) {
+                file->refs++;
+                return file;
+            }
+            // 文件已更新，丢弃旧内容
+            *link = file->next;
+            release_cached(file);
+            break;
+        }
+        link = &file->next;
+    }
+
+    CachedFile* file = mem_calloc(MEM_SERVER, 1, sizeof(CachedFile));
+    if (!file) return NULL;
+
+    file->path = mem_strdup(MEM_SERVER, path);
+    file->data = read_whole_file(path, st->st_size);
+    if (!file->path || !file->data) {
+        mem_free(MEM_SERVER, file->path);
+        mem_free(MEM_SERVER, file->data);
+        mem_free(MEM_SERVER, file);
+        return NULL;
+    }
+
+    file->length = st->st_size;
+    file->mtime = st->st_mtim;
+    snprintf(file->etag, sizeof(file->etag), "\"%016llx\"",
+             (unsigned long long)content_hash(file->data, file->length));
+    file->refs = 2;
+    file->next = server->cache[bucket];
+    server->cache[bucket] = file;
+    return file;
+}
+
+static void clear_cache(Server* server) {
+    for (int i = 0; i < CACHE_BUCKETS; i++) {
+        CachedFile* file = server->cache[i];
+        while (file) {
+            CachedFile* next = file->next;
+            release_cached(file);
+            file = next;
+        }
+        server->cache[i] = NULL;
+    }
+}
+
+// 连接管理
+static void reset_response(Connection* conn) {
+    release_cached(conn->cached);
+    conn->cached = NULL;
+    if (conn->file_fd >= 0) close(conn->file_fd);
+    conn->file_fd = -1;
+    conn->file_remaining = 0;
+    conn->file_offset = 0;
+    conn->header_len = 0;
+    conn->header_sent = 0;
+    conn->body = NULL;
+    conn->body_len = 0;
+    conn->body_sent = 0;
+    conn->writing = 0;
+}
+
+static void close_connection(Server* server, Connection* conn) {
+    reset_response(conn);
+    epoll_ctl(server->epoll_fd, EPOLL_CTL_DEL, conn->fd, NULL);
+    close(conn->fd);
+
+    if (conn->prev) conn->prev->next = conn->next;
+    else server->connections = conn->next;
+    if (conn->next) conn->next->prev = conn->prev;
+    server->connection_count--;
+    mem_free(MEM_SERVER, conn);
+}
+
+static void set_write_interest(Server* server, Connection* conn, int want_write) {
+    if ((conn->writing == 2) == want_write) return;
+    conn->writing = want_write ? 2 : 1;
+
+    struct epoll_event ev = {
+        .events = want_write ? EPOLLOUT : EPOLLIN,
+        .data.ptr = conn
+    };
+    epoll_ctl(server->epoll_fd, EPOLL_CTL_MOD, conn->fd, &ev);
+}
+
+static void accept_connections(Server* server) {
+    for (;;) {
+        int fd = accept4(server->listen_fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno == EINTR) continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                log_warn("accept failed (errno: %d)", errno);
+            }
+            return;
+        }
+
+        Connection* conn = mem_calloc(MEM_SERVER, 1, sizeof(Connection));
+        if (!conn) {
+            close(fd);
+            continue;
+        }
+        conn->fd = fd;
+        conn->file_fd = -1;
+        conn->last_active = time(NULL);
+
+        struct epoll_event ev = { .events = EPOLLIN, .data.ptr = conn };
+        if (epoll_ctl(server->epoll_fd, EPOLL_CTL_ADD, fd, &ev) != 0) {
+            close(fd);
+            mem_free(MEM_SERVER, conn);
+            continue;
+        }
+
+        conn->next = server->connections;
+        if (server->connections) server->connections->prev = conn;
+        server->connections = conn;
+        server->connection_count++;
+    }
+}
+
+// 发送尚未发送的响应数据；返回 0 表示连接已关闭
+static int flush_connection(Server* server, Connection* conn) {
+    while (conn->header_sent < conn->header_len || conn->body_sent < conn->body_len) {
+        struct iovec iov[2];
+        int iov_count = 0;
+        if (conn->header_sent < conn->header_len) {
+            iov[iov_count].iov_base = conn->header + conn->header_sent;
+            iov[iov_count].iov_len = conn->header_len - conn->header_sent;
+            iov_count++;
+        }
+        if (conn->body_sent < conn->body_len) {
+            iov[iov_count].iov_base = (char*)conn->body + conn->body_sent;
+            iov[iov_count].iov_len = conn->body_len - conn->body_sent;
+            iov_count++;
+        }
+
+        ssize_t n = writev(conn->fd, iov, iov_count);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                set_write_interest(server, conn, 1);
+                return 1;
+            }
+            close_connection(server, conn);
+            return 0;
+        }
+
+        size_t sent = n;
+        size_t header_left = conn->header_len - conn->header_sent;
+        if (sent <= header_left) {
+            conn->header_sent += sent;
+        } else {
+            conn->header_sent = conn->header_len;
+            conn->body_sent += sent - header_left;
+        }
+    }
+
+    while (conn->file_remaining > 0) {
+        size_t chunk = conn->file_remaining > SENDFILE_CHUNK ? SENDFILE_CHUNK : conn->file_remaining;
+        ssize_t n = sendfile(conn->fd, conn->file_fd, &conn->file_offset, chunk);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                set_write_interest(server, conn, 1);
+                return 1;
+            }
+            close_connection(server, conn);
+            return 0;
+        }
+        if (n == 0) {
+            // 文件在发送过程中被截断
+            close_connection(server, conn);
+            return 0;
+        }
+        conn->file_remaining -= n;
+    }
+
+    // 响应发送完毕
+    if (!conn->keep_alive) {
+        close_connection(server, conn);
+        return 0;
+    }
+    set_write_interest(server, conn, 0);
+    reset_response(conn);
+    return 1;
+}
+
+// 请求解析
+static const char* find_header(const char* headers, const char* end, const char* name, size_t* value_len) {
+    size_t name_len = strlen(name);
+    const char* line = headers;
+
+    while (line < end) {
+        const char* eol = memmem(line, end - line, "\r\n", 2);
+        if (!eol) eol = end;
+
+        if ((size_t)(eol - line) > name_len && line[name_len] == ':' &&
+            strncasecmp(line, name, name_len) == 0) {
+            const char* value = line + name_len + 1;
+            while (value < eol && (*value == ' ' || *value == '\t')) value++;
+            *value_len = eol - value;
+            return value;
+        }
+        line = eol + 2;
+    }
+    return NULL;
+}
+
+static int header_contains(const char* value, size_t value_len, const char* token) {
+    size_t token_len = strlen(token);
+    if (!value || token_len > value_len) return 0;
+
+    for (size_t i = 0; i + token_len <= value_len; i++) {
+        if (strncasecmp(value + i, token, token_len) == 0) return 1;
+    }
+    return 0;
+}
+
+static int hex_value(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+// 把请求目标解码为站点根目录下的文件路径
+static int resolve_target(const char* root, const char* target, size_t target_len,
+                          char* path, size_t path_size) {
+    char decoded[1024];
+    size_t j = 0;
+
+    if (target_len == 0 || target[0] != '/') return 0;
+
+    for (size_t i = 0; i < target_len && target[i] != '?' && target[i] != '#'; i++) {
+        if (j + 1 >= sizeof(decoded)) return 0;
+        char c = target[i];
+        if (c == '%' && i + 2 < target_len) {
+            int hi = hex_value(target[i + 1]);
+            int lo = hex_value(target[i + 2]);
+            if (hi < 0 || lo < 0) return 0;
+            c = (char)(hi * 16 + lo);
+            i += 2;
+        }
+        if (c == '\0') return 0;
+        decoded[j++] = c;
+    }
+    decoded[j] = '\0';
+
+    if (!is_valid_path(decoded)) return 0;
+
+    const char* index = decoded[j - 1] == '/' ? "index.html" : "";
+    int written = snprintf(path, path_size, "%s%s%s", root, decoded, index);
+    return written > 0 && (size_t)written < path_size;
+}
+
+// 简单的文本响应，响应体直接跟在响应头后面
+static void set_simple_response(Connection* conn, int status, const char* reason) {
+    int body_len = snprintf(NULL, 0, "%d %s\n", status, reason);
+
+    conn->header_len = snprintf(conn->header, sizeof(conn->header),
+        "HTTP/1.1 %d %s\r\n"
+        "Content-Type: text/plain; charset=utf-8\r\n"
+        "Content-Length: %d\r\n"
+        "Connection: %s\r\n\r\n"
+        "%d %s\n",
+        status, reason, body_len, conn->keep_alive ? "keep-alive" : "close",
+        status, reason);
+}
+
+static void handle_request(Server* server, Connection* conn, size_t request_len) {
+    const char* request = conn->request;
+    const char* end = request + request_len;
+    const char* line_end = memmem(request, request_len, "\r\n", 2);
+
+    conn->writing = 1;
+    conn->keep_alive = 0;
+
+    // 请求行：METHOD SP TARGET SP VERSION
+    const char* method_end = memchr(request, ' ', line_end - request);
+    const char* target = method_end ? method_end + 1 : NULL;
+    const char* target_end = target ? memchr(target, ' ', line_end - target) : NULL;
+    if (!target_end) {
+        set_simple_response(conn, 400, "Bad Request");
+        return;
+    }
+
+    const char* version = target_end + 1;
+    int http11 = line_end - version == 8 && strncmp(version, "HTTP/1.1", 8) == 0;
+    const char* headers = line_end + 2;
+
+    size_t value_len = 0;
+    const char* connection = find_header(headers, end, "Connection", &value_len);
+    if (http11) {
+        conn->keep_alive = !header_contains(connection, value_len, "close");
+    } else {
+        conn->keep_alive = header_contains(connection, value_len, "keep-alive");
+    }
+
+    size_t method_len = method_end - request;
+    int is_head = method_len == 4 && strncmp(request, "HEAD", 4) == 0;
+    int is_get = method_len == 3 && strncmp(request, "GET", 3) == 0;
+    if (!is_get && !is_head) {
+        conn->keep_alive = 0;
+        set_simple_response(conn, 405, "Method Not Allowed");
+        return;
+    }
+
+    char path[1280];
+    struct stat st;
+    if (!resolve_target(server->config->root, target, target_end - target, path, sizeof(path))) {
+        set_simple_response(conn, 400, "Bad Request");
+        return;
+    }
+    if (stat(path, &st) == 0 && S_ISDIR(st.st_mode)) {
+        strncat(path, "/index.html", sizeof(path) - strlen(path) - 1);
+    }
+    if (stat(path, &st) != 0 || !S_ISREG(st.st_mode)) {
+        set_simple_response(conn, 404, "Not Found");
+        return;
+    }
+
+    const char* content_type = mime_type(path);
+
+    // 客户端接受 gzip 且预压缩版本与原文件的修改时间（纳秒精度）完全相同时，直接发送 .gz；
+    // compress 把原文件的修改时间复制到 .gz 上，原文件之后被改写过则发送原文件
+    const char* encoding = find_header(headers, end, "Accept-Encoding", &value_len);
+    int gzip = 0;
+    if (header_contains(encoding, value_len, "gzip")) {
+        char gz_path[sizeof(path) + 3];
+        struct stat gz_st;
+        snprintf(gz_path, sizeof(gz_path), "%s.gz", path);
+        if (stat(gz_path, &gz_st) == 0 && S_ISREG(gz_st.st_mode) &&
+            stat_mtime_ns(&gz_st) == stat_mtime_ns(&st)) {
+            memcpy(path, gz_path, sizeof(path));
+            path[sizeof(path) - 1] = '\0';
+            st = gz_st;
+            gzip = 1;
+        }
+    }
+
+    char etag[48];
+    CachedFile* cached = lookup_cached(server, path, &st);
+    if (cached) {
+        snprintf(etag, sizeof(etag), "%s", cached->etag);
+    } else {
+        snprintf(etag, sizeof(etag), "\"%llx-%llx%s\"",
+                 (unsigned long long)st.st_size,
+                 (unsigned long long)st.st_mtim.tv_sec * 1000000000ULL + st.st_mtim.tv_nsec,
+                 gzip ? "-gz" : "");
+    }
+
+    const char* if_none_match = find_header(headers, end, "If-None-Match", &value_len);
+    int not_modified = if_none_match &&
+        (header_contains(if_none_match, value_len, etag) ||
+         (value_len == 1 && if_none_match[0] == '*'));
+
+    char content_length[48] = "";
+    if (!not_modified) {
+        snprintf(content_length, sizeof(content_length), "Content-Length: %lld\r\n",
+                 (long long)st.st_size);
+    }
+
+    conn->header_len = snprintf(conn->header, sizeof(conn->header),
+        "HTTP/1.1 %s\r\n"
+        "Content-Type: %s\r\n"
+        "%s"
+        "ETag: %s\r\n"
+        "Cache-Control: no-cache\r\n"
+        "Vary: Accept-Encoding\r\n"
+        "%s"
+        "Connection: %s\r\n\r\n",
+        not_modified ? "304 Not Modified" : "200 OK",
+        content_type,
+        content_length,
+        etag,
+        gzip ? "Content-Encoding: gzip\r\n" : "",
+        conn->keep_alive ? "keep-alive" : "close");
+
+    if (not_modified || is_head) {
+        release_cached(cached);
+        return;
+    }
+
+    if (cached) {
+        conn->cached = cached;
+        conn->body = cached->data;
+        conn->body_len = cached->length;
+    } else {
+        conn->file_fd = open(path, O_RDONLY | O_CLOEXEC);
+        if (conn->file_fd < 0) {
+            set_simple_response(conn, 500, "Internal Server Error");
+            return;
+        }
+        conn->file_remaining = st.st_size;
+    }
+}
+
+// 处理缓冲区中所有完整的请求（支持流水线请求）
+static void process_requests(Server* server, Connection* conn) {
+    while (!conn->writing) {
+        char* header_end = memmem(conn->request, conn->request_len, "\r\n\r\n", 4);
+        if (!header_end) {
+            if (conn->request_len == sizeof(conn->request)) {
+                conn->writing = 1;
+                conn->keep_alive = 0;
+                set_simple_response(conn, 431, "Request Header Fields Too Large");
+                flush_connection(server, conn);
+            }
+            return;
+        }
+
+        size_t consumed = header_end - conn->request + 4;
+        handle_request(server, conn, consumed);
+        conn->request_len -= consumed;
+        memmove(conn->request, conn->request + consumed, conn->request_len);
+
+        if (!flush_connection(server, conn)) return;
+    }
+}
+
+static void handle_readable(Server* server, Connection* conn) {
+    for (;;) {
+        size_t space = sizeof(conn->request) - conn->request_len;
+        if (space == 0) break;
+
+        ssize_t n = recv(conn->fd, conn->request + conn->request_len, space, 0);
+        if (n > 0) {
+            conn->request_len += n;
+            continue;
+        }
+        if (n == 0) {
+            close_connection(server, conn);
+            return;
+        }
+        if (errno == EINTR) continue;
+        if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+        close_connection(server, conn);
+        return;
+    }
+
+    conn->last_active = time(NULL);
+    process_requests(server, conn);
+}
+
+static void handle_writable(Server* server, Connection* conn) {
+    conn->last_active = time(NULL);
+    if (!flush_connection(server, conn)) return;
+    if (!conn->writing) process_requests(server, conn);
+}
+
+// 关闭长时间空闲的连接
+static void close_idle_connections(Server* server) {
+    time_t now = time(NULL);
+    Connection* conn = server->connections;
+    while (conn) {
+        Connection* next = conn->next;
+        if (now - conn->last_active > SERVER_IDLE_TIMEOUT) {
+            close_connection(server, conn);
+        }
+        conn = next;
+    }
+}
+
+static int open_listener(const ServerConfig* config) {
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) return -1;
+
+    int on = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons((unsigned short)config->port);
+    if (inet_pton(AF_INET, config->host, &addr.sin_addr) != 1 ||
+        bind(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0 ||
+        listen(fd, SOMAXCONN) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+int run_preview_server(const ServerConfig* config) {
+    if (!config || !config->root) return 0;
+
+    Server* server = mem_calloc(MEM_SERVER, 1, sizeof(Server));
+    if (!server) return 0;
+    server->config = config;
+
+    server->listen_fd = open_listener(config);
+    if (server->listen_fd < 0) {
+        log_error("Could not listen on %s:%d (errno: %d)", config->host, config->port, errno);
+        mem_free(MEM_SERVER, server);
+        return 0;
+    }
+
+    server->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    struct epoll_event ev = { .events = EPOLLIN, .data.ptr = &listen_tag };
+    if (server->epoll_fd < 0 ||
+        epoll_ctl(server->epoll_fd, EPOLL_CTL_ADD, server->listen_fd, &ev) != 0) {
+        log_error("Could not set up epoll (errno: %d)", errno);
+        if (server->epoll_fd >= 0) close(server->epoll_fd);
+        close(server->listen_fd);
+        mem_free(MEM_SERVER, server);
+        return 0;
+    }
+
+    if (config->watcher) {
+        struct epoll_event wev = { .events = EPOLLIN, .data.ptr = &watch_tag };
+        epoll_ctl(server->epoll_fd, EPOLL_CTL_ADD, watcher_fd(config->watcher), &wev);
+    }
+
+    server_stop = 0;
+    signal(SIGINT, handle_stop_signal);
+    signal(SIGTERM, handle_stop_signal);
+    signal(SIGPIPE, SIG_IGN);
+
+    log_info("Serving %s at http://%s:%d/ (press Ctrl+C to stop)",
+           config->root, config->host, config->port);
+
+    struct epoll_event events[SERVER_MAX_EVENTS];
+    time_t last_sweep = time(NULL);
+
+    while (!server_stop) {
+        int timeout = 1000;
+        if (config->watcher) {
+            int watch_timeout = watcher_timeout_ms(config->watcher);
+            if (watch_timeout >= 0 && watch_timeout < timeout) timeout = watch_timeout;
+        }
+
+        int count = epoll_wait(server->epoll_fd, events, SERVER_MAX_EVENTS, timeout);
+        if (count < 0) {
+            if (errno == EINTR) continue;
+            log_error("epoll_wait failed (errno: %d)", errno);
+            break;
+        }
+
+        for (int i = 0; i < count; i++) {
+            void* tag = events[i].data.ptr;
+            if (tag == &listen_tag) {
+                accept_connections(server);
+            } else if (tag == &watch_tag) {
+                watcher_read_events(config->watcher);
+            } else {
+                Connection* conn = tag;
+                if (events[i].events & (EPOLLERR | EPOLLHUP)) {
+                    close_connection(server, conn);
+                } else if (events[i].events & EPOLLOUT) {
+                    handle_writable(server, conn);
+                } else if (events[i].events & EPOLLIN) {
+                    handle_readable(server, conn);
+                }
+            }
+        }
+
+        if (config->watcher) watcher_flush(config->watcher);
+
+        time_t now = time(NULL);
+        if (now != last_sweep) {
+            close_idle_connections(server);
+            last_sweep = now;
+        }
+    }
+
+    log_info("Stopping preview server");
+    while (server->connections) {
+        close_connection(server, server->connections);
+    }
+    clear_cache(server);
+    close(server->epoll_fd);
+    close(server->listen_fd);
+    mem_free(MEM_SERVER, server);
+    return 1;
+}
+
+#else
+
+int run_preview_server(const ServerConfig* config) {
+    (void)config;
+    log_error("The preview server is only supported on Linux");
+    return 0;
+}
+
+#endif
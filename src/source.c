@@ -0,0 +1,518 @@
+#include "../include/source.h"
+#include "../include/memstats.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+// 多字节校验需要 SSSE3 的 pshufb，按函数开启指令集，运行时检测 CPU 后再使用
+#if defined(__GNUC__)
+#include <tmmintrin.h>
+#define HAVE_SSSE3_UTF8 1
+#endif
+#endif
+
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+// 每个线程复用一个小文件缓冲区，同一线程同时打开多个文件时其余的另行分配
+static _Thread_local char* scratch = NULL;
+static _Thread_local int scratch_in_use = 0;
+
+static int map_large_files = 1;
+
+void source_set_mmap(int enabled) {
+    map_large_files = enabled;
+}
+
+// BOM 只移动起点，不搬动数据
+static void skip_bom(SourceFile* src) {
+    const unsigned char* p = (const unsigned char*)src->data;
+    if (src->length >= 3 && p[0] == 0xEF && p[1] == 0xBB && p[2] == 0xBF) {
+        src->data += 3;
+        src->length -= 3;
+    }
+}
+
+static char* small_buffer(SourceFile* src, size_t size) {
+    if (!scratch_in_use) {
+        if (!scratch) scratch = mem_malloc(MEM_SOURCE, SOURCE_SMALL_FILE);
+        if (scratch) {
+            scratch_in_use = 1;
+            src->uses_scratch = 1;
+            return scratch;
+        }
+    }
+    src->owned = mem_malloc(MEM_SOURCE, size ? size : 1);
+    return src->owned;
+}
+
+int source_open(SourceFile* src, const char* path) {
+    if (!src || !path) return 0;
+    memset(src, 0, sizeof(SourceFile));
+
+#ifdef _WIN32
+    FILE* fp = fopen(path, "rb");
+    if (!fp) return 0;
+
+    fseek(fp, 0, SEEK_END);
+    long size = ftell(fp);
+    rewind(fp);
+    if (size < 0) {
+        fclose(fp);
+        return 0;
+    }
+
+    src->owned = mem_malloc(MEM_SOURCE, size ? size : 1);
+    if (!src->owned) {
+        fclose(fp);
+        return 0;
+    }
+    src->length = fread(src->owned, 1, size, fp);
+    src->data = src->owned;
+    fclose(fp);
+#else
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return 0;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+        close(fd);
+        return 0;
+    }
+
+    size_t size = (size_t)st.st_size;
+    if (size <= SOURCE_SMALL_FILE || !map_large_files) {
+        char* buffer = size <= SOURCE_SMALL_FILE ? small_buffer(src, size)
+                                                 : (src->owned = mem_malloc(MEM_SOURCE, size));
+        if (!buffer) {
+            close(fd);
+            return 0;
+        }
+
+        size_t total = 0;
+        while (total < size) {
+            ssize_t n = pread(fd, buffer + total, size - total, (off_t)total);
+            if (n < 0) {
+                close(fd);
+                source_close(src);
+                return 0;
+            }
+            if (n == 0) break;  // 文件在读取时被截短
+            total += (size_t)n;
+        }
+        src->data = buffer;
+        src->length = total;
+    } else {
+        // 大文件直接映射，由页缓存负责读取，重建时无需再次复制
+        void* map = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (map == MAP_FAILED) {
+            close(fd);
+            return 0;
+        }
+#ifdef MADV_SEQUENTIAL
+        madvise(map, size, MADV_SEQUENTIAL);
+#endif
+        src->map = map;
+        src->map_length = size;
+        src->data = map;
+        src->length = size;
+    }
+    close(fd);
+#endif
+
+    skip_bom(src);
+    return 1;
+}
+
+// 开头的 front matter 是否已经完整：没有 front matter，或已读到结束的 "---" 行
+static int header_complete(const char* data, size_t length) {
+    if (length >= 3 && memcmp(data, "\xEF\xBB\xBF", 3) == 0) {
+        data += 3;
+        length -= 3;
+    }
+    if (length < 4) return 0;
+    if (memcmp(data, "---\n", 4) != 0) return 1;
+
+    for (const char* p = data + 3; (p = memchr(p, '\n', data + length - p)) != NULL; p++) {
+        if ((size_t)(data + length - p) >= 5 && memcmp(p, "\n---\n", 5) == 0) return 1;
+    }
+    return 0;
+}
+
+int source_open_header(SourceFile* src, const char* path) {
+    if (!src || !path) return 0;
+    memset(src, 0, sizeof(SourceFile));
+
+#ifdef _WIN32
+    FILE* fp = fopen(path, "rb");
+    if (!fp) return 0;
+#else
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return 0;
+#endif
+
+    size_t capacity = SOURCE_HEADER_CHUNK;
+    size_t total = 0;
+    char* buffer = mem_malloc(MEM_SOURCE, capacity);
+    int success = buffer != NULL;
+
+    while (success) {
+#ifdef _WIN32
+        size_t n = fread(buffer + total, 1, capacity - total, fp);
+        if (n == 0 && ferror(fp)) success = 0;
+#else
+        ssize_t n = pread(fd, buffer + total, capacity - total, (off_t)total);
+        if (n < 0) success = 0;
+#endif
+        if (n <= 0) break;
+        total += (size_t)n;
+        if (header_complete(buffer, total)) break;
+
+        if (total == capacity) {
+            char* grown = mem_realloc(MEM_SOURCE, buffer, capacity * 2);
+            if (!grown) {
+                success = 0;
+                break;
+            }
+            buffer = grown;
+            capacity *= 2;
+        }
+    }
+
+#ifdef _WIN32
+    fclose(fp);
+#else
+    close(fd);
+#endif
+
+    if (!success) {
+        mem_free(MEM_SOURCE, buffer);
+        return 0;
+    }
+
+    src->owned = buffer;
+    src->data = buffer;
+    src->length = total;
+    skip_bom(src);
+    return 1;
+}
+
+void source_close(SourceFile* src) {
+    if (!src) return;
+
+#ifndef _WIN32
+    if (src->map) munmap(src->map, src->map_length);
+#endif
+    if (src->uses_scratch) scratch_in_use = 0;
+    mem_free(MEM_SOURCE, src->owned);
+    free_line_index(&src->lines);
+    memset(src, 0, sizeof(SourceFile));
+}
+
+void free_line_index(LineIndex* lines) {
+    if (!lines) return;
+    mem_free(MEM_SOURCE, lines->starts);
+    memset(lines, 0, sizeof(LineIndex));
+}
+
+// lines 为 NULL 时只做校验
+static int push_line(LineIndex* lines, size_t offset) {
+    if (!lines) return 1;
+    if (lines->count == lines->capacity) {
+        size_t new_capacity = lines->capacity ? lines->capacity * 2 : 256;
+        size_t* starts = mem_realloc(MEM_SOURCE, lines->starts, new_capacity * sizeof(size_t));
+        if (!starts) return 0;
+        lines->starts = starts;
+        lines->capacity = new_capacity;
+    }
+    lines->starts[lines->count++] = offset;
+    return 1;
+}
+
+// UTF-8 校验状态：还需要的后续字节数，以及下一个字节的取值范围（用于排除超长编码和代理对）
+typedef struct {
+    int need;
+    unsigned char low;
+    unsigned char high;
+    size_t lead;              // 当前多字节序列首字节的偏移
+} Utf8State;
+
+// 标量状态机，处理一个字节；返回 0 表示非法
+static int utf8_step(Utf8State* st, unsigned char c, size_t offset) {
+    if (st->need > 0) {
+        if (c < st->low || c > st->high) return 0;
+        st->need--;
+        st->low = 0x80;
+        st->high = 0xBF;
+        return 1;
+    }
+
+    st->lead = offset;
+    if (c < 0x80) return 1;
+    if (c >= 0xC2 && c <= 0xDF) {
+        st->need = 1;
+        st->low = 0x80; st->high = 0xBF;
+    } else if (c == 0xE0) {
+        st->need = 2;
+        st->low = 0xA0; st->high = 0xBF;
+    } else if ((c >= 0xE1 && c <= 0xEC) || c == 0xEE || c == 0xEF) {
+        st->need = 2;
+        st->low = 0x80; st->high = 0xBF;
+    } else if (c == 0xED) {
+        st->need = 2;
+        st->low = 0x80; st->high = 0x9F;
+    } else if (c == 0xF0) {
+        st->need = 3;
+        st->low = 0x90; st->high = 0xBF;
+    } else if (c >= 0xF1 && c <= 0xF3) {
+        st->need = 3;
+        st->low = 0x80; st->high = 0xBF;
+    } else if (c == 0xF4) {
+        st->need = 3;
+        st->low = 0x80; st->high = 0x8F;
+    } else {
+        return 0;
+    }
+    return 1;
+}
+
+// 标量处理一段字节，同时记录行首；返回值同 scan_utf8_lines
+static int scan_scalar(const unsigned char* p, size_t from, size_t to, Utf8State* st,
+                       LineIndex* lines, size_t* error_offset) {
+    for (size_t i = from; i < to; i++) {
+        if (!utf8_step(st, p[i], i)) {
+            // 报告非法序列的起始位置
+            *error_offset = st->need > 0 ? st->lead : i;
+            return 0;
+        }
+        if (p[i] == '\n' && !push_line(lines, i + 1)) return -1;
+    }
+    return 1;
+}
+
+#if defined(__SSE2__)
+// 每次 16 字节：全是 ASCII 时只需用换行掩码记录行首，否则交给标量状态机；*pos 为处理到的位置
+static int scan_blocks_sse2(const unsigned char* p, size_t length, size_t* pos, Utf8State* st,
+                            LineIndex* lines, size_t* error_offset) {
+    const __m128i newline = _mm_set1_epi8('\n');
+    size_t i = 0;
+    while (i + 16 <= length) {
+        __m128i chunk = _mm_loadu_si128((const __m128i*)(p + i));
+        unsigned high_bits = (unsigned)_mm_movemask_epi8(chunk);
+
+        if (high_bits == 0 && st->need == 0) {
+            if (!lines) {
+                i += 16;
+                continue;
+            }
+            unsigned mask = (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, newline));
+            while (mask) {
+                int bit = __builtin_ctz(mask);
+                if (!push_line(lines, i + bit + 1)) return -1;
+                mask &= mask - 1;
+            }
+        } else {
+            int result = scan_scalar(p, i, i + 16, st, lines, error_offset);
+            if (result != 1) return result;
+        }
+        i += 16;
+    }
+    *pos = i;
+    return 1;
+}
+#endif
+
+#ifdef HAVE_SSSE3_UTF8
+// 从 offset 重新开始标量扫描时，需要先退回到跨越 offset 的多字节序列的首字节
+// offset 之前的数据必须已经校验过
+static size_t sequence_start(const unsigned char* p, size_t offset) {
+    for (size_t k = 1; k <= 3 && k <= offset; k++) {
+        unsigned char c = p[offset - k];
+        if ((c & 0xC0) == 0x80) continue;
+        return c >= 0xC0 ? offset - k : offset;
+    }
+    return offset;
+}
+
+// Keiser & Lemire 的查表校验：每个字节与前面 1~3 个字节组合，查三张 16 项的表得到错误位，
+// 三者相与不为 0 即非法；第三、四字节位置上缺少的后续字节单独检查
+#define UTF8_TOO_SHORT      (1 << 0)  // 首字节后面不是后续字节
+#define UTF8_TOO_LONG       (1 << 1)  // ASCII 后面出现后续字节
+#define UTF8_OVERLONG_3     (1 << 2)  // E0 80..9F
+#define UTF8_TOO_LARGE      (1 << 3)  // 大于 U+10FFFF
+#define UTF8_SURROGATE      (1 << 4)  // ED A0..BF
+#define UTF8_OVERLONG_2     (1 << 5)  // C0、C1
+#define UTF8_TOO_LARGE_1000 (1 << 6)  // F5..FF 80..8F
+#define UTF8_OVERLONG_4     (1 << 6)  // F0 80..8F
+#define UTF8_TWO_CONTS      (1 << 7)  // 多出的后续字节
+#define UTF8_CARRY          (UTF8_TOO_SHORT | UTF8_TOO_LONG | UTF8_TWO_CONTS)
+
+__attribute__((target("ssse3")))
+static inline __m128i utf8_block_errors(__m128i input, __m128i prev_input) {
+    const __m128i low_nibble = _mm_set1_epi8(0x0F);
+    __m128i prev1 = _mm_alignr_epi8(input, prev_input, 15);
+
+    // 前一个字节的高 4 位
+    const __m128i byte_1_high_table = _mm_setr_epi8(
+        UTF8_TOO_LONG, UTF8_TOO_LONG, UTF8_TOO_LONG, UTF8_TOO_LONG,
+        UTF8_TOO_LONG, UTF8_TOO_LONG, UTF8_TOO_LONG, UTF8_TOO_LONG,
+        UTF8_TWO_CONTS, UTF8_TWO_CONTS, UTF8_TWO_CONTS, UTF8_TWO_CONTS,
+        UTF8_TOO_SHORT | UTF8_OVERLONG_2,
+        UTF8_TOO_SHORT,
+        UTF8_TOO_SHORT | UTF8_OVERLONG_3 | UTF8_SURROGATE,
+        UTF8_TOO_SHORT | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000 | UTF8_OVERLONG_4);
+    // 前一个字节的低 4 位
+    const __m128i byte_1_low_table = _mm_setr_epi8(
+        UTF8_CARRY | UTF8_OVERLONG_3 | UTF8_OVERLONG_2 | UTF8_OVERLONG_4,
+        UTF8_CARRY | UTF8_OVERLONG_2,
+        UTF8_CARRY,
+        UTF8_CARRY,
+        UTF8_CARRY | UTF8_TOO_LARGE,
+        UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+        UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+        UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+        UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+        UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+        UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+        UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+        UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+        UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000 | UTF8_SURROGATE,
+        UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+        UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000);
+    // 当前字节的高 4 位
+    const __m128i byte_2_high_table = _mm_setr_epi8(
+        UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT,
+        UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT,
+        UTF8_TOO_LONG | UTF8_OVERLONG_2 | UTF8_TWO_CONTS | UTF8_OVERLONG_3 | UTF8_TOO_LARGE_1000 | UTF8_OVERLONG_4,
+        UTF8_TOO_LONG | UTF8_OVERLONG_2 | UTF8_TWO_CONTS | UTF8_OVERLONG_3 | UTF8_TOO_LARGE,
+        UTF8_TOO_LONG | UTF8_OVERLONG_2 | UTF8_TWO_CONTS | UTF8_SURROGATE | UTF8_TOO_LARGE,
+        UTF8_TOO_LONG | UTF8_OVERLONG_2 | UTF8_TWO_CONTS | UTF8_SURROGATE | UTF8_TOO_LARGE,
+        UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT);
+
+    // SSE 没有按字节的移位，16 位移位后再屏蔽掉相邻字节移入的位
+    __m128i byte_1_high = _mm_shuffle_epi8(byte_1_high_table,
+                                           _mm_and_si128(_mm_srli_epi16(prev1, 4), low_nibble));
+    __m128i byte_1_low = _mm_shuffle_epi8(byte_1_low_table, _mm_and_si128(prev1, low_nibble));
+    __m128i byte_2_high = _mm_shuffle_epi8(byte_2_high_table,
+                                           _mm_and_si128(_mm_srli_epi16(input, 4), low_nibble));
+    __m128i special = _mm_and_si128(_mm_and_si128(byte_1_high, byte_1_low), byte_2_high);
+
+    // 前两个字节是三、四字节首字节，或前三个字节是四字节首字节时，当前字节必须是后续字节
+    __m128i prev2 = _mm_alignr_epi8(input, prev_input, 14);
+    __m128i prev3 = _mm_alignr_epi8(input, prev_input, 13);
+    __m128i is_third = _mm_subs_epu8(prev2, _mm_set1_epi8((char)(0xE0 - 0x80)));
+    __m128i is_fourth = _mm_subs_epu8(prev3, _mm_set1_epi8((char)(0xF0 - 0x80)));
+    __m128i must23 = _mm_and_si128(_mm_or_si128(is_third, is_fourth), _mm_set1_epi8((char)0x80));
+    return _mm_xor_si128(must23, special);
+}
+
+// 块末尾的多字节序列是否还缺后续字节（需要由下一块补齐）
+__attribute__((target("ssse3")))
+static inline __m128i utf8_block_incomplete(__m128i input) {
+    const __m128i max_value = _mm_setr_epi8(
+        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+        (char)(0xF0 - 1), (char)(0xE0 - 1), (char)(0xC0 - 1));
+    return _mm_subs_epu8(input, max_value);
+}
+
+// 每次 16 字节同时校验 UTF-8 并记录行首；遇到非法块时停下，返回需要交给标量状态机
+// 重新扫描的位置（标量扫描负责给出准确的出错位置）；内存不足返回 (size_t)-1
+__attribute__((target("ssse3")))
+static size_t scan_blocks_ssse3(const unsigned char* p, size_t length, LineIndex* lines) {
+    const __m128i newline = _mm_set1_epi8('\n');
+    const __m128i zero = _mm_setzero_si128();
+    __m128i prev_input = zero;
+    int incomplete = 0;       // 上一块末尾的多字节序列还没结束
+    size_t i = 0;
+
+    while (i + 16 <= length) {
+        __m128i input = _mm_loadu_si128((const __m128i*)(p + i));
+        // 整块都是 ASCII 且上一块没有未结束的序列时不用查表
+        if (_mm_movemask_epi8(input) | incomplete) {
+            __m128i error = utf8_block_errors(input, prev_input);
+            if (_mm_movemask_epi8(_mm_cmpeq_epi8(error, zero)) != 0xFFFF) break;
+            incomplete = _mm_movemask_epi8(_mm_cmpeq_epi8(utf8_block_incomplete(input), zero)) != 0xFFFF;
+        }
+
+        if (lines) {
+            unsigned mask = (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(input, newline));
+            while (mask) {
+                int bit = __builtin_ctz(mask);
+                if (!push_line(lines, i + bit + 1)) return (size_t)-1;
+                mask &= mask - 1;
+            }
+        }
+        prev_input = input;
+        i += 16;
+    }
+    return sequence_start(p, i);
+}
+
+static int cpu_has_ssse3(void) {
+    static int cached = -1;
+    if (cached < 0) cached = __builtin_cpu_supports("ssse3") ? 1 : 0;
+    return cached;
+}
+#endif
+
+int scan_utf8_lines(const char* data, size_t length, LineIndex* lines, size_t* error_offset) {
+    const unsigned char* p = (const unsigned char*)data;
+    Utf8State st = {0, 0x80, 0xBF, 0};
+    size_t i = 0;
+
+    if (lines) {
+        lines->base = data;
+        lines->count = 0;
+    }
+    *error_offset = 0;
+    if (!push_line(lines, 0)) return -1;
+
+#if defined(__SSE2__)
+    int result;
+#ifdef HAVE_SSSE3_UTF8
+    if (cpu_has_ssse3()) {
+        i = scan_blocks_ssse3(p, length, lines);
+        result = i == (size_t)-1 ? -1 : 1;
+    } else
+#endif
+    result = scan_blocks_sse2(p, length, &i, &st, lines, error_offset);
+    if (result != 1) return result;
+#else
+    // 没有 SSE2 时按 8 字节检查是否全为 ASCII
+    while (i + 8 <= length && st.need == 0) {
+        unsigned long long word;
+        memcpy(&word, p + i, 8);
+        if (word & 0x8080808080808080ULL) break;
+        for (int k = 0; k < 8; k++) {
+            if (p[i + k] == '\n' && !push_line(lines, i + k + 1)) return -1;
+        }
+        i += 8;
+    }
+#endif
+
+    int tail = scan_scalar(p, i, length, &st, lines, error_offset);
+    if (tail != 1) return tail;
+
+    // 文件在多字节序列中间结束
+    if (st.need > 0) {
+        *error_offset = st.lead;
+        return 0;
+    }
+    return 1;
+}
+
+int source_index_lines(SourceFile* src) {
+    if (!src) return 0;
+    return scan_utf8_lines(src->data, src->length, &src->lines, &src->error_offset);
+}
+
+int source_validate_utf8(SourceFile* src) {
+    if (!src) return 0;
+    return scan_utf8_lines(src->data, src->length, NULL, &src->error_offset);
+}
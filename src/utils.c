@@ -1,3 +1,4 @@
+#define _GNU_SOURCE
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -14,36 +15,15 @@
 #define MKDIR_CMD "mkdir "
 #else
 #include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <stdatomic.h>
+#include <sys/sendfile.h>
 #define PATH_SEPARATOR '/'
 #define MKDIR_CMD "mkdir -p "
 #endif
 
-// �ڴ�׷�ٺ���
-static size_t total_allocated = 0;
-static size_t allocation_count = 0;
-
-void* tracked_malloc(size_t size, const char* file, int line) {
-    void* ptr = malloc(size);
-    if (ptr) {
-        total_allocated += size;
-        allocation_count++;
-        fprintf(stderr, "[MEM] Allocated %zu bytes at %s:%d (total: %zu, count: %zu)\n",
-                size, file, line, total_allocated, allocation_count);
-    } else {
-        fprintf(stderr, "[MEM] Failed to allocate %zu bytes at %s:%d\n",
-                size, file, line);
-    }
-    return ptr;
-}
-
-void tracked_free(void* ptr, const char* file, int line) {
-    if (ptr) {
-        allocation_count--;
-        fprintf(stderr, "[MEM] Freed memory at %s:%d (count: %zu)\n",
-                file, line, allocation_count);
-        free(ptr);
-    }
-}
+#include "../include/utils.h"
 
 // Ŀ¼��������
 void mkdir_p(const char* path) {
@@ -74,19 +54,236 @@ void mkdir_p(const char* path) {
 #endif
 }
 
-void copy_directory(const char* src, const char* dest) {
 #ifdef _WIN32
+void copy_directory(const char* src, const char* dest) {
     char command[1024];
     snprintf(command, sizeof(command), "xcopy /E /I \"%s\" \"%s\"", src, dest);
-#else
-    char command[1024];
-    snprintf(command, sizeof(command), "cp -r \"%s/\" \"%s/\"", src, dest);
-#endif
     if (system(command) != 0) {
-        fprintf(stderr, "Failed to copy directory from %s to %s\n", src, dest);
+        log_error("Failed to copy directory from %s to %s", src, dest);
+    }
+}
+
+int sync_directory(const char* src, const char* dest, WorkerPool* workers,
+                   int hard_link, SyncStats* stats) {
+    (void)workers;
+    (void)hard_link;
+    if (stats) memset(stats, 0, sizeof(SyncStats));
+    copy_directory(src, dest);
+    return 1;
+}
+#else
+
+// 一次同步操作的共享状态，文件复制任务通过根目录描述符定位源和目标
+typedef struct {
+    int src_root;
+    int dst_root;
+    int hard_link;
+    atomic_int copied;
+    atomic_int linked;
+    atomic_int unchanged;
+    atomic_int failed;
+} SyncJob;
+
+typedef struct {
+    SyncJob* job;
+    struct stat st;
+    char rel_path[];
+} SyncTask;
+
+// 用 copy_file_range 复制，不支持时依次退回 sendfile 和 read/write
+static int copy_file_data(int in_fd, int out_fd, off_t size) {
+    off_t copied = 0;
+    int use_range = 1;
+    int use_sendfile = 1;
+
+    while (copied < size) {
+        ssize_t n = -1;
+        size_t chunk = size - copied > (1 << 30) ? (1 << 30) : (size_t)(size - copied);
+
+        if (use_range) {
+            n = copy_file_range(in_fd, NULL, out_fd, NULL, chunk, 0);
+            if (n < 0 && (errno == EXDEV || errno == ENOSYS || errno == EINVAL || errno == EOPNOTSUPP)) {
+                use_range = 0;
+                continue;
+            }
+        } else if (use_sendfile) {
+            n = sendfile(out_fd, in_fd, NULL, chunk);
+            if (n < 0 && (errno == ENOSYS || errno == EINVAL)) {
+                use_sendfile = 0;
+                continue;
+            }
+        } else {
+            char buffer[65536];
+            n = read(in_fd, buffer, chunk < sizeof(buffer) ? chunk : sizeof(buffer));
+            if (n > 0 && write(out_fd, buffer, n) != n) return 0;
+        }
+
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return 0;
+        copied += n;
+    }
+    return 1;
+}
+
+// 复制到临时文件后原子替换，并保留源文件的修改时间以便下次跳过
+static int copy_one_file(SyncJob* job, const char* rel_path, const struct stat* st) {
+    char tmp_path[1100];
+    snprintf(tmp_path, sizeof(tmp_path), "%s.sync-tmp", rel_path);
+
+    int in_fd = openat(job->src_root, rel_path, O_RDONLY | O_CLOEXEC);
+    if (in_fd < 0) return 0;
+
+    int out_fd = openat(job->dst_root, tmp_path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC,
+                        st->st_mode & 0777);
+    if (out_fd < 0) {
+        close(in_fd);
+        return 0;
+    }
+
+    int success = copy_file_data(in_fd, out_fd, st->st_size);
+    struct timespec times[2] = { st->st_atim, st->st_mtim };
+    success = success && futimens(out_fd, times) == 0;
+    success = close(out_fd) == 0 && success;
+    close(in_fd);
+
+    if (success) {
+        success = renameat(job->dst_root, tmp_path, job->dst_root, rel_path) == 0;
+    }
+    if (!success) unlinkat(job->dst_root, tmp_path, 0);
+    return success;
+}
+
+static void sync_file_task(void* arg) {
+    SyncTask* task = (SyncTask*)arg;
+    SyncJob* job = task->job;
+    struct stat dst;
+
+    if (fstatat(job->dst_root, task->rel_path, &dst, AT_SYMLINK_NOFOLLOW) == 0) {
+        int same_file = dst.st_dev == task->st.st_dev && dst.st_ino == task->st.st_ino;
+        int same_meta = dst.st_size == task->st.st_size &&
+                        dst.st_mtim.tv_sec == task->st.st_mtim.tv_sec &&
+                        dst.st_mtim.tv_nsec == task->st.st_mtim.tv_nsec;
+        if (same_file || same_meta) {
+            atomic_fetch_add(&job->unchanged, 1);
+            free(task);
+            return;
+        }
+    }
+
+    if (job->hard_link) {
+        unlinkat(job->dst_root, task->rel_path, 0);
+        if (linkat(job->src_root, task->rel_path, job->dst_root, task->rel_path, 0) == 0) {
+            atomic_fetch_add(&job->linked, 1);
+            free(task);
+            return;
+        }
+        // 跨文件系统或不支持硬链接时改为复制
+    }
+
+    if (copy_one_file(job, task->rel_path, &task->st)) {
+        atomic_fetch_add(&job->copied, 1);
+    } else {
+        log_error("Failed to copy %s (errno: %d)", task->rel_path, errno);
+        atomic_fetch_add(&job->failed, 1);
+    }
+    free(task);
+}
+
+// 遍历目录，创建子目录并把文件复制任务分发到线程池
+static void sync_walk(SyncJob* job, WorkerPool* workers, const char* rel_dir) {
+    int dir_fd = openat(job->src_root, rel_dir, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (dir_fd < 0) {
+        atomic_fetch_add(&job->failed, 1);
+        return;
+    }
+
+    DIR* dir = fdopendir(dir_fd);
+    if (!dir) {
+        close(dir_fd);
+        atomic_fetch_add(&job->failed, 1);
+        return;
+    }
+
+    struct dirent* entry;
+    while ((entry = readdir(dir)) != NULL) {
+        const char* name = entry->d_name;
+        if (strcmp(name, ".") == 0 || strcmp(name, "..") == 0) continue;
+
+        char rel_path[1024];
+        int len = snprintf(rel_path, sizeof(rel_path), "%s/%s", rel_dir, name);
+        if (len < 0 || (size_t)len >= sizeof(rel_path)) {
+            atomic_fetch_add(&job->failed, 1);
+            continue;
+        }
+
+        struct stat st;
+        if (fstatat(dir_fd, name, &st, AT_SYMLINK_NOFOLLOW) != 0) continue;
+
+        if (S_ISDIR(st.st_mode)) {
+            if (mkdirat(job->dst_root, rel_path, 0755) != 0 && errno != EEXIST) {
+                atomic_fetch_add(&job->failed, 1);
+                continue;
+            }
+            sync_walk(job, workers, rel_path);
+        } else if (S_ISREG(st.st_mode)) {
+            SyncTask* task = malloc(sizeof(SyncTask) + len + 1);
+            if (!task) {
+                atomic_fetch_add(&job->failed, 1);
+                continue;
+            }
+            task->job = job;
+            task->st = st;
+            memcpy(task->rel_path, rel_path, len + 1);
+
+            if (!workers || !worker_pool_submit(workers, sync_file_task, task)) {
+                sync_file_task(task);
+            }
+        }
     }
+    closedir(dir);
 }
 
+// 递归同步目录：跳过大小和修改时间一致的文件，复制任务在线程池上并行执行
+int sync_directory(const char* src, const char* dest, WorkerPool* workers,
+                   int hard_link, SyncStats* stats) {
+    SyncJob job;
+    memset(&job, 0, sizeof(job));
+    job.hard_link = hard_link;
+    atomic_init(&job.copied, 0);
+    atomic_init(&job.linked, 0);
+    atomic_init(&job.unchanged, 0);
+    atomic_init(&job.failed, 0);
+
+    mkdir_p(dest);
+    job.src_root = open(src, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    job.dst_root = open(dest, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (job.src_root < 0 || job.dst_root < 0) {
+        if (job.src_root >= 0) close(job.src_root);
+        if (job.dst_root >= 0) close(job.dst_root);
+        log_error("Failed to copy directory from %s to %s", src, dest);
+        return 0;
+    }
+
+    sync_walk(&job, workers, ".");
+    if (workers) worker_pool_wait(workers);
+
+    close(job.src_root);
+    close(job.dst_root);
+
+    if (stats) {
+        stats->copied = atomic_load(&job.copied);
+        stats->linked = atomic_load(&job.linked);
+        stats->unchanged = atomic_load(&job.unchanged);
+        stats->failed = atomic_load(&job.failed);
+    }
+    return atomic_load(&job.failed) == 0;
+}
+
+void copy_directory(const char* src, const char* dest) {
+    sync_directory(src, dest, NULL, 0, NULL);
+}
+#endif
+
 // ��ʽ�����ں���
 char* format_rss_date(const char* date) {
     // ���������ʽΪ YYYY-MM-DD
@@ -149,29 +346,77 @@ long get_file_size(const char* path) {
     return -1;
 }
 
-// ���Ժ���־����
-#ifdef DEBUG
-void log_debug(const char* fmt, ...) {
-    va_list args;
-    va_start(args, fmt);
-    fprintf(stderr, "[DEBUG] ");
-    vfprintf(stderr, fmt, args);
-    fprintf(stderr, "\n");
-    va_end(args);
-}
+long long stat_mtime_ns(const struct stat* st) {
+#ifdef _WIN32
+    return (long long)st->st_mtime * 1000000000LL;
 #else
-void log_debug(const char* fmt, ...) {
-    (void)fmt; // 避免未使用参数的警告
-}
+    return (long long)st->st_mtim.tv_sec * 1000000000LL + st->st_mtim.tv_nsec;
 #endif
+}
+
+// 日志
+LogLevel log_level = LOG_LEVEL_INFO;
+
+static _Thread_local char log_buffer[LOG_BUFFER_SIZE];
+static _Thread_local size_t log_length = 0;
+static _Thread_local int log_batch_depth = 0;
 
-void log_error(const char* fmt, ...) {
+void log_set_level(LogLevel level) {
+    log_level = level;
+}
+
+// stderr 不经 stdio 缓冲，一次 fwrite 即一次写入，不同线程的消息不会交错在行中间
+void log_flush(void) {
+    if (log_length == 0) return;
+    fwrite(log_buffer, 1, log_length, stderr);
+    log_length = 0;
+}
+
+void log_batch_begin(void) {
+    log_batch_depth++;
+}
+
+void log_batch_end(void) {
+    if (log_batch_depth > 0 && --log_batch_depth == 0) log_flush();
+}
+
+void log_write(LogLevel level, const char* prefix, const char* fmt, ...) {
+    if (level > log_level) return;
+
+    size_t prefix_length = strlen(prefix);
+    if (log_length + prefix_length + 1 >= LOG_BUFFER_SIZE) log_flush();
+
+    // 直接格式化到缓冲区末尾，结尾的 '\0' 换成换行
+    char* start = log_buffer + log_length;
+    size_t space = LOG_BUFFER_SIZE - log_length;
+    memcpy(start, prefix, prefix_length);
     va_list args;
     va_start(args, fmt);
-    fprintf(stderr, "[ERROR] ");
-    vfprintf(stderr, fmt, args);
-    fprintf(stderr, "\n");
+    int needed = vsnprintf(start + prefix_length, space - prefix_length, fmt, args);
     va_end(args);
+    if (needed < 0) return;
+
+    size_t total = prefix_length + (size_t)needed + 1;
+    if (total > space) {
+        // 放不下：先写出已缓冲的消息再重新格式化，超过整个缓冲区的消息单独分配
+        log_flush();
+        start = total <= LOG_BUFFER_SIZE ? log_buffer : malloc(total);
+        if (!start) return;
+        memcpy(start, prefix, prefix_length);
+        va_start(args, fmt);
+        vsnprintf(start + prefix_length, total - prefix_length, fmt, args);
+        va_end(args);
+        if (start != log_buffer) {
+            start[total - 1] = '\n';
+            fwrite(start, 1, total, stderr);
+            free(start);
+            return;
+        }
+    }
+
+    start[total - 1] = '\n';
+    log_length = (size_t)(start - log_buffer) + total;
+    if (log_batch_depth == 0) log_flush();
 }
 
 // ��ȫ�ַ�������
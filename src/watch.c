@@ -0,0 +1,409 @@
+#include "../include/watch.h"
+#include "../include/compress.h"
+#include "../include/utils.h"
+#include <errno.h>
+#include <signal.h>
+#include <time.h>
+
+#ifdef __linux__
+#include <poll.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <sys/inotify.h>
+
+#define WATCH_EVENT_MASK (IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_DELETE | IN_CREATE)
+#define WATCH_BUFFER_SIZE 4096
+
+// 文章目录树中每个被监视的子目录
+typedef struct {
+    int wd;
+    char* path;
+} WatchedDir;
+
+struct Watcher {
+    GeneratorContext* ctx;
+    int fd;
+    WatchedDir* dirs;         // posts/ 及其所有子目录
+    int dir_count;
+    int dir_capacity;
+    int template_wd;
+    char* posts_dir;
+    char* template_dir;
+    char** pending;           // 待重建的文章路径（已去重）
+    int pending_count;
+    int pending_capacity;
+    int template_changed;
+    int rescan;               // 事件队列溢出或子目录变化，需要重新扫描整个目录
+    long long last_event_ms;  // 最近一次事件的时间，0 表示没有待处理的变更
+};
+
+static volatile sig_atomic_t watch_stop = 0;
+
+static void handle_stop_signal(int sig) {
+    (void)sig;
+    watch_stop = 1;
+}
+
+static long long monotonic_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static int add_string(char*** list, int* count, int* capacity, const char* str) {
+    for (int i = 0; i < *count; i++) {
+        if (strcmp((*list)[i], str) == 0) return 1;
+    }
+    
+    if (*count == *capacity) {
+        int new_capacity = *capacity ? *capacity * 2 : 16;
+        char** items = mem_realloc(MEM_SCAN, *list, new_capacity * sizeof(char*));
+        if (!items) return 0;
+        *list = items;
+        *capacity = new_capacity;
+    }
+    
+    (*list)[*count] = mem_strdup(MEM_SCAN, str);
+    if (!(*list)[*count]) return 0;
+    (*count)++;
+    return 1;
+}
+
+static void free_strings(char** list, int count) {
+    for (int i = 0; i < count; i++) {
+        mem_free(MEM_SCAN, list[i]);
+    }
+    mem_free(MEM_SCAN, list);
+}
+
+static WatchedDir* find_watched_dir(Watcher* watcher, int wd) {
+    for (int i = 0; i < watcher->dir_count; i++) {
+        if (watcher->dirs[i].wd == wd) return &watcher->dirs[i];
+    }
+    return NULL;
+}
+
+// 递归监视目录及其子目录；inotify 本身不递归，新建的子目录需要单独添加
+static int watch_tree(Watcher* watcher, const char* path) {
+    int wd = inotify_add_watch(watcher->fd, path, WATCH_EVENT_MASK | IN_ONLYDIR);
+    if (wd < 0) return 0;
+    
+    // 已经监视过的目录（同一 inode 的 wd 相同）不再递归
+    if (find_watched_dir(watcher, wd)) return 1;
+    
+    if (watcher->dir_count == watcher->dir_capacity) {
+        int new_capacity = watcher->dir_capacity ? watcher->dir_capacity * 2 : 16;
+        WatchedDir* dirs = mem_realloc(MEM_SCAN, watcher->dirs, new_capacity * sizeof(WatchedDir));
+        if (!dirs) return 0;
+        watcher->dirs = dirs;
+        watcher->dir_capacity = new_capacity;
+    }
+    char* copy = mem_strdup(MEM_SCAN, path);
+    if (!copy) return 0;
+    watcher->dirs[watcher->dir_count].wd = wd;
+    watcher->dirs[watcher->dir_count].path = copy;
+    watcher->dir_count++;
+    
+    DIR* dir = opendir(path);
+    if (!dir) return 1;
+    
+    int success = 1;
+    struct dirent* entry;
+    while ((entry = readdir(dir)) != NULL) {
+        if (entry->d_name[0] == '.') continue;
+        
+        char child[1024];
+        snprintf(child, sizeof(child), "%s/%s", path, entry->d_name);
+        
+        // 与扫描一致，不进入指向目录的符号链接
+        int is_dir = entry->d_type == DT_DIR;
+        if (entry->d_type == DT_UNKNOWN) {
+            struct stat st;
+            is_dir = lstat(child, &st) == 0 && S_ISDIR(st.st_mode);
+        }
+        if (is_dir) success = watch_tree(watcher, child) && success;
+    }
+    closedir(dir);
+    return success;
+}
+
+Watcher* watcher_create(GeneratorContext* ctx, const char* posts_dir, const char* template_dir) {
+    if (!ctx || !posts_dir || !template_dir) return NULL;
+    
+    Watcher* watcher = mem_calloc(MEM_SCAN, 1, sizeof(Watcher));
+    if (!watcher) return NULL;
+    
+    watcher->ctx = ctx;
+    watcher->posts_dir = mem_strdup(MEM_SCAN, posts_dir);
+    watcher->template_dir = mem_strdup(MEM_SCAN, template_dir);
+    watcher->fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (!watcher->posts_dir || !watcher->template_dir || watcher->fd < 0) {
+        log_error("Could not initialize inotify (errno: %d)", errno);
+        watcher_destroy(watcher);
+        return NULL;
+    }
+    
+    watcher->template_wd = inotify_add_watch(watcher->fd, template_dir, WATCH_EVENT_MASK);
+    if (!watch_tree(watcher, posts_dir) || watcher->template_wd < 0) {
+        log_error("Could not watch %s or %s (errno: %d)", posts_dir, template_dir, errno);
+        watcher_destroy(watcher);
+        return NULL;
+    }
+    
+    // 初次构建的 .gz 由 compress_site 生成，之后改写的页面在每次 flush 后重新压缩
+    if (ctx->config->enable_compression) track_rewritten_outputs(ctx);
+    return watcher;
+}
+
+void watcher_destroy(Watcher* watcher) {
+    if (!watcher) return;
+    
+    if (watcher->fd >= 0) close(watcher->fd);
+    for (int i = 0; i < watcher->dir_count; i++) {
+        mem_free(MEM_SCAN, watcher->dirs[i].path);
+    }
+    mem_free(MEM_SCAN, watcher->dirs);
+    free_strings(watcher->pending, watcher->pending_count);
+    mem_free(MEM_SCAN, watcher->posts_dir);
+    mem_free(MEM_SCAN, watcher->template_dir);
+    mem_free(MEM_SCAN, watcher);
+}
+
+int watcher_fd(const Watcher* watcher) {
+    return watcher ? watcher->fd : -1;
+}
+
+// 读取所有已到达的 inotify 事件，只记录变更，不立即重建
+int watcher_read_events(Watcher* watcher) {
+    char buffer[WATCH_BUFFER_SIZE] __attribute__((aligned(__alignof__(struct inotify_event))));
+    int events = 0;
+    
+    for (;;) {
+        ssize_t len = read(watcher->fd, buffer, sizeof(buffer));
+        if (len <= 0) break;
+        
+        for (char* ptr = buffer; ptr < buffer + len; ) {
+            struct inotify_event* event = (struct inotify_event*)ptr;
+            ptr += sizeof(struct inotify_event) + event->len;
+            WatchedDir* dir = find_watched_dir(watcher, event->wd);
+            
+            if (event->mask & IN_Q_OVERFLOW) {
+                watcher->rescan = 1;
+            } else if (event->mask & IN_IGNORED) {
+                // 目录已删除或移走，内核自动移除了监视
+                if (dir) {
+                    mem_free(MEM_SCAN, dir->path);
+                    *dir = watcher->dirs[--watcher->dir_count];
+                }
+                continue;
+            } else if (event->len == 0) {
+                continue;
+            } else if (dir && (event->mask & IN_ISDIR)) {
+                // 子目录增删或移动：新目录加入监视，然后重新扫描，其中可能已经有文章
+                char path[1024];
+                snprintf(path, sizeof(path), "%s/%s", dir->path, event->name);
+                if (event->mask & (IN_CREATE | IN_MOVED_TO)) watch_tree(watcher, path);
+                watcher->rescan = 1;
+            } else if (event->mask & IN_CREATE) {
+                continue;  // 新文件等写完后的 IN_CLOSE_WRITE 再处理
+            } else if (dir && is_markdown_file(event->name)) {
+                char path[1024];
+                snprintf(path, sizeof(path), "%s/%s", dir->path, event->name);
+                add_string(&watcher->pending, &watcher->pending_count,
+                           &watcher->pending_capacity, path);
+            } else if (event->wd == watcher->template_wd && strcmp(event->name, "post.html") == 0) {
+                watcher->template_changed = 1;
+            } else {
+                continue;
+            }
+            
+            watcher->last_event_ms = monotonic_ms();
+            events++;
+        }
+    }
+    
+    return events;
+}
+
+// 距离去抖截止还有多少毫秒，没有待处理变更时返回 -1
+int watcher_timeout_ms(const Watcher* watcher) {
+    if (!watcher || !watcher->last_event_ms) return -1;
+    
+    long long remaining = watcher->last_event_ms + WATCH_DEBOUNCE_MS - monotonic_ms();
+    return remaining > 0 ? (int)remaining : 0;
+}
+
+static void collect_tags(const CatalogEntry* entry, char*** tags, int* count, int* capacity) {
+    if (!entry || !entry->metadata) return;
+    
+    for (int i = 0; i < entry->metadata->tag_count; i++) {
+        add_string(tags, count, capacity, entry->metadata->tags[i]);
+    }
+}
+
+// 重建单篇文章，并记录其前后的标签
+static int rebuild_post(Watcher* watcher, const char* path,
+                        char*** tags, int* tag_count, int* tag_capacity) {
+    GeneratorContext* ctx = watcher->ctx;
+    int result = 1;
+    
+    collect_tags(find_catalog_entry(ctx, path), tags, tag_count, tag_capacity);
+    if (file_exists(path)) {
+        result = process_single_post(ctx, path);
+    } else {
+        remove_post(ctx, path);
+    }
+    collect_tags(find_catalog_entry(ctx, path), tags, tag_count, tag_capacity);
+    
+    return result;
+}
+
+// 去抖时间到后，只重建受影响的文章和列表页
+int watcher_flush(Watcher* watcher) {
+    if (watcher_timeout_ms(watcher) != 0) return 0;
+    
+    GeneratorContext* ctx = watcher->ctx;
+    long long start = monotonic_ms();
+    char** dirty_tags = NULL;
+    int tag_count = 0;
+    int tag_capacity = 0;
+    int rebuilt = 0;
+    int failed = 0;
+    
+    int template_reloaded = 0;
+    
+    ctx->catalog_changed = 0;
+    
+    if (watcher->template_changed) {
+        if (load_post_template(ctx)) {
+            // 模板变化影响所有文章：清掉记录的大小和修改时间，下面的全量处理会重新渲染每一篇
+            for (int i = 0; i < ctx->catalog.count; i++) {
+                ctx->catalog.entries[i].size = 0;
+                ctx->catalog.entries[i].mtime_ns = 0;
+            }
+            template_reloaded = 1;
+        } else {
+            log_error("Could not reload template from %s", watcher->template_dir);
+            failed++;
+        }
+    }
+    
+    int full = watcher->rescan || template_reloaded;
+    if (full) {
+        // 在线程池上只重新渲染大小或修改时间变化的文章，已删除的文章同时从目录中移除；
+        // 单独变化的文章也包含在内，不再逐篇重建
+        if (watcher->rescan) log_info("Rescanning %s...", watcher->posts_dir);
+        if (!process_posts(ctx, watcher->posts_dir)) failed++;
+        int post_failures = report_post_failures(ctx);
+        failed += post_failures;
+        if (template_reloaded) {
+            ctx->catalog_cache.render_key = render_fingerprint(ctx);
+            rebuilt += ctx->catalog.count - post_failures;
+        }
+        ctx->catalog_changed = 1;
+    }
+    
+    for (int i = 0; !full && i < watcher->pending_count; i++) {
+        if (rebuild_post(watcher, watcher->pending[i], &dirty_tags, &tag_count, &tag_capacity)) {
+            rebuilt++;
+        } else {
+            failed++;
+        }
+    }
+    
+    if (ctx->catalog_changed) {
+        rebuild_tag_index(ctx);
+        if (!generate_index_page(ctx) ||
+            !generate_archive_page(ctx) ||
+            !generate_rss_feed(ctx) ||
+            !generate_sitemap(ctx)) {
+            log_error("Failed to regenerate list pages (%s)",
+                   get_error_message(get_last_error(ctx)));
+            failed++;
+        }
+        
+        if (full) {
+            generate_tag_pages(ctx);
+        } else {
+            for (int i = 0; i < tag_count; i++) {
+                int found = 0;
+                for (int t = 0; t < ctx->tag_index.count; t++) {
+                    if (strcmp(ctx->tag_index.tags[t].name, dirty_tags[i]) == 0) {
+                        generate_tag_page(ctx, &ctx->tag_index.tags[t]);
+                        found = 1;
+                        break;
+                    }
+                }
+                if (!found) remove_tag_page(ctx, dirty_tags[i]);
+            }
+        }
+    }
+    
+    if (!flush_output(ctx)) failed++;
+    if (ctx->config->enable_compression && !compress_rewritten_outputs(ctx)) failed++;
+    
+    log_info("Rebuilt %d post(s)%s in %lld ms%s", rebuilt,
+           ctx->catalog_changed ? " and list pages" : "",
+           monotonic_ms() - start,
+           failed ? " (with errors)" : "");
+    
+    free_strings(dirty_tags, tag_count);
+    free_strings(watcher->pending, watcher->pending_count);
+    watcher->pending = NULL;
+    watcher->pending_count = 0;
+    watcher->pending_capacity = 0;
+    watcher->template_changed = 0;
+    watcher->rescan = 0;
+    watcher->last_event_ms = 0;
+    return failed == 0;
+}
+
+int run_watch_mode(GeneratorContext* ctx, const char* posts_dir, const char* template_dir) {
+    Watcher* watcher = watcher_create(ctx, posts_dir, template_dir);
+    if (!watcher) return 0;
+    
+    watch_stop = 0;
+    signal(SIGINT, handle_stop_signal);
+    signal(SIGTERM, handle_stop_signal);
+    
+    log_info("Watching %s and %s for changes (press Ctrl+C to stop)...", posts_dir, template_dir);
+    
+    while (!watch_stop) {
+        struct pollfd pfd = { .fd = watcher_fd(watcher), .events = POLLIN, .revents = 0 };
+        int ready = poll(&pfd, 1, watcher_timeout_ms(watcher));
+        if (ready < 0) {
+            if (errno == EINTR) continue;
+            log_error("poll failed (errno: %d)", errno);
+            break;
+        }
+        
+        if (ready > 0) watcher_read_events(watcher);
+        watcher_flush(watcher);
+    }
+    
+    log_info("Stopping watch mode");
+    watcher_destroy(watcher);
+    return 1;
+}
+
+#else
+
+Watcher* watcher_create(GeneratorContext* ctx, const char* posts_dir, const char* template_dir) {
+    (void)ctx; (void)posts_dir; (void)template_dir;
+    return NULL;
+}
+
+void watcher_destroy(Watcher* watcher) { (void)watcher; }
+int watcher_fd(const Watcher* watcher) { (void)watcher; return -1; }
+int watcher_read_events(Watcher* watcher) { (void)watcher; return 0; }
+int watcher_timeout_ms(const Watcher* watcher) { (void)watcher; return -1; }
+int watcher_flush(Watcher* watcher) { (void)watcher; return 0; }
+
+int run_watch_mode(GeneratorContext* ctx, const char* posts_dir, const char* template_dir) {
+    (void)ctx; (void)posts_dir; (void)template_dir;
+    log_error("Watch mode is only supported on Linux");
+    return 0;
+}
+
+#endif
@@ -0,0 +1,627 @@
+#include "../include/writer.h"
+#include "../include/memstats.h"
+#include "../include/utils.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <sys/stat.h>
+
+// 稀疏固定文件表（IORING_RSRC_REGISTER_SPARSE，5.19 的头文件）同时意味着 IORING_REGISTER_FILES2
+// 和 sqe->file_index 可用；更旧的内核头文件不编译批量写出，output_batch_create 返回 NULL
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#ifdef IORING_RSRC_REGISTER_SPARSE
+#define HAVE_IO_URING 1
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <pthread.h>
+#include <stdint.h>
+#endif
+#endif
+#endif
+
+void output_init(OutputBuffer* out) {
+    memset(out, 0, sizeof(OutputBuffer));
+}
+
+void output_free(OutputBuffer* out) {
+    mem_free(MEM_OUTPUT, out->data);
+    memset(out, 0, sizeof(OutputBuffer));
+}
+
+void output_adopt(OutputBuffer* out, char* data, size_t length) {
+    mem_free(MEM_OUTPUT, out->data);
+    out->data = data;
+    out->length = length;
+    out->capacity = length + 1;
+}
+
+void output_set_filter(OutputBuffer* out, OutputFilter filter, void* user) {
+    out->filter = filter;
+    out->filter_user = user;
+}
+
+static int output_reserve(OutputBuffer* out, size_t extra) {
+    if (out->failed) return 0;
+    if (out->length + extra + 1 <= out->capacity) return 1;
+
+    size_t new_capacity = out->capacity ? out->capacity : 4096;
+    while (new_capacity < out->length + extra + 1) new_capacity *= 2;
+
+    char* data = mem_realloc(MEM_OUTPUT, out->data, new_capacity);
+    if (!data) {
+        out->failed = 1;
+        return 0;
+    }
+    out->data = data;
+    out->capacity = new_capacity;
+    return 1;
+}
+
+void output_append_raw(OutputBuffer* out, const char* data, size_t length) {
+    if (!output_reserve(out, length)) return;
+    memcpy(out->data + out->length, data, length);
+    out->length += length;
+    out->data[out->length] = '\0';
+}
+
+void output_append(OutputBuffer* out, const char* data, size_t length) {
+    if (out->filter) {
+        out->filter(out->filter_user, data, length);
+        return;
+    }
+    output_append_raw(out, data, length);
+}
+
+void output_puts(OutputBuffer* out, const char* str) {
+    output_append(out, str, strlen(str));
+}
+
+void output_putc(OutputBuffer* out, char c) {
+    output_append(out, &c, 1);
+}
+
+void output_printf(OutputBuffer* out, const char* fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    char small[256];
+    int needed = vsnprintf(small, sizeof(small), fmt, args);
+    va_end(args);
+    if (needed < 0) {
+        out->failed = 1;
+        return;
+    }
+
+    if ((size_t)needed < sizeof(small)) {
+        output_append(out, small, needed);
+        return;
+    }
+
+    // 有过滤器时先格式化到临时缓冲区
+    if (out->filter) {
+        char* text = mem_malloc(MEM_OUTPUT, (size_t)needed + 1);
+        if (!text) {
+            out->failed = 1;
+            return;
+        }
+        va_start(args, fmt);
+        vsnprintf(text, needed + 1, fmt, args);
+        va_end(args);
+        out->filter(out->filter_user, text, needed);
+        mem_free(MEM_OUTPUT, text);
+        return;
+    }
+
+    if (!output_reserve(out, needed)) return;
+    va_start(args, fmt);
+    vsnprintf(out->data + out->length, needed + 1, fmt, args);
+    va_end(args);
+    out->length += needed;
+}
+
+// 逐块比较磁盘上的文件，大小不同时无需读取
+static int same_as_disk(const char* path, const char* data, size_t length) {
+    struct stat st;
+    if (stat(path, &st) != 0 || (size_t)st.st_size != length) return 0;
+
+    FILE* fp = fopen(path, "rb");
+    if (!fp) return 0;
+
+    char buffer[65536];
+    size_t offset = 0;
+    int same = 1;
+    size_t n;
+    while (same && (n = fread(buffer, 1, sizeof(buffer), fp)) > 0) {
+        same = offset + n <= length && memcmp(buffer, data + offset, n) == 0;
+        offset += n;
+    }
+    same = same && !ferror(fp) && offset == length;
+    fclose(fp);
+    return same;
+}
+
+static WriteResult count_result(WriterStats* stats, WriteResult result) {
+    if (stats) {
+        switch (result) {
+            case WRITE_WRITTEN: atomic_fetch_add(&stats->written, 1); break;
+            case WRITE_UNCHANGED: atomic_fetch_add(&stats->unchanged, 1); break;
+            default: atomic_fetch_add(&stats->failed, 1); break;
+        }
+    }
+    return result;
+}
+
+// 写入临时文件（path + suffix）后 rename 替换目标文件
+static WriteResult replace_file_via(const char* path, const char* data, size_t length, const char* suffix) {
+    char tmp_path[1100];
+    snprintf(tmp_path, sizeof(tmp_path), "%s%s", path, suffix);
+
+    FILE* fp = fopen(tmp_path, "wb");
+    if (!fp) {
+        log_error("Could not create output file %s", tmp_path);
+        return WRITE_FAILED;
+    }
+
+    int success = fwrite(data, 1, length, fp) == length;
+    success = fclose(fp) == 0 && success;
+#ifdef _WIN32
+    if (success) remove(path);
+#endif
+    if (success) success = rename(tmp_path, path) == 0;
+    if (!success) {
+        log_error("Could not write output file %s", path);
+        remove(tmp_path);
+        return WRITE_FAILED;
+    }
+    return WRITE_WRITTEN;
+}
+
+static WriteResult replace_file(const char* path, const char* data, size_t length) {
+    return replace_file_via(path, data, length, ".tmp");
+}
+
+WriteResult write_output_file(const char* path, const char* data, size_t length, WriterStats* stats) {
+    if (!path || !data) return count_result(stats, WRITE_FAILED);
+
+    // 内容未变时不动文件，部署工具不会重新上传
+    if (same_as_disk(path, data, length)) return count_result(stats, WRITE_UNCHANGED);
+    return count_result(stats, replace_file(path, data, length));
+}
+
+WriteResult output_commit(OutputBuffer* out, const char* path, WriterStats* stats) {
+    if (out->failed) {
+        log_error("Out of memory while rendering %s", path);
+        return count_result(stats, WRITE_FAILED);
+    }
+    return write_output_file(path, out->data ? out->data : "", out->length, stats);
+}
+
+int output_stream_open(OutputStream* stream, const char* path, size_t buffer_size) {
+    memset(stream, 0, sizeof(OutputStream));
+    if (!path) return 0;
+    stream->path = path;
+    snprintf(stream->tmp_path, sizeof(stream->tmp_path), "%s.tmp", path);
+
+    stream->fp = fopen(stream->tmp_path, "wb");
+    if (!stream->fp) {
+        log_error("Could not create output file %s", stream->tmp_path);
+        return 0;
+    }
+    if (buffer_size) {
+        stream->buffer = mem_malloc(MEM_OUTPUT, buffer_size);
+        if (stream->buffer) setvbuf(stream->fp, stream->buffer, _IOFBF, buffer_size);
+    }
+
+    struct stat st;
+    if (stat(path, &st) == 0 && S_ISREG(st.st_mode)) {
+        stream->existing = fopen(path, "rb");
+        stream->existing_length = (size_t)st.st_size;
+    }
+    return 1;
+}
+
+// 与旧文件的对应部分比较，一旦不同就不再读取旧文件
+static void compare_existing(OutputStream* stream, const char* data, size_t length) {
+    if (stream->length + length > stream->existing_length) {
+        fclose(stream->existing);
+        stream->existing = NULL;
+        return;
+    }
+
+    char buffer[65536];
+    while (length > 0) {
+        size_t n = length < sizeof(buffer) ? length : sizeof(buffer);
+        if (fread(buffer, 1, n, stream->existing) != n || memcmp(buffer, data, n) != 0) {
+            fclose(stream->existing);
+            stream->existing = NULL;
+            return;
+        }
+        data += n;
+        length -= n;
+    }
+}
+
+void output_stream_write(OutputStream* stream, const char* data, size_t length) {
+    if (stream->failed || length == 0) return;
+    if (stream->existing) compare_existing(stream, data, length);
+    if (fwrite(data, 1, length, stream->fp) != length) stream->failed = 1;
+    stream->length += length;
+}
+
+static void close_stream(OutputStream* stream) {
+    if (stream->existing) fclose(stream->existing);
+    stream->existing = NULL;
+    if (stream->fp && fclose(stream->fp) != 0) stream->failed = 1;
+    stream->fp = NULL;
+    mem_free(MEM_OUTPUT, stream->buffer);
+    stream->buffer = NULL;
+}
+
+WriteResult output_stream_commit(OutputStream* stream, WriterStats* stats) {
+    int same = stream->existing && stream->length == stream->existing_length;
+    close_stream(stream);
+
+    if (!stream->failed && same) {
+        remove(stream->tmp_path);
+        return count_result(stats, WRITE_UNCHANGED);
+    }
+#ifdef _WIN32
+    if (!stream->failed) remove(stream->path);
+#endif
+    if (stream->failed || rename(stream->tmp_path, stream->path) != 0) {
+        log_error("Could not write output file %s", stream->path);
+        remove(stream->tmp_path);
+        return count_result(stats, WRITE_FAILED);
+    }
+    return count_result(stats, WRITE_WRITTEN);
+}
+
+void output_stream_abort(OutputStream* stream) {
+    close_stream(stream);
+    remove(stream->tmp_path);
+}
+
+#ifdef HAVE_IO_URING
+
+// 每个文件占用 4 个 SQE：openat -> write -> close -> renameat，依次链接
+#define BATCH_OPS_PER_FILE 4
+#define BATCH_RING_ENTRIES (OUTPUT_BATCH_FILES * BATCH_OPS_PER_FILE)
+
+enum { OP_OPEN = 0, OP_WRITE, OP_CLOSE, OP_RENAME };
+
+typedef struct {
+    char* path;
+    char tmp_path[1100];
+    char* data;
+    size_t length;
+    int completed;             // 已完成（成功）的操作数
+} BatchFile;
+
+struct OutputBatch {
+    int ring_fd;
+    void* sq_ptr;
+    size_t sq_size;
+    void* cq_ptr;
+    size_t cq_size;
+    struct io_uring_sqe* sqes;
+    size_t sqes_size;
+
+    unsigned* sq_head;
+    unsigned* sq_tail;
+    unsigned* sq_mask;
+    unsigned* sq_array;
+    unsigned* cq_head;
+    unsigned* cq_tail;
+    unsigned* cq_mask;
+    struct io_uring_cqe* cqes;
+
+    BatchFile files[OUTPUT_BATCH_FILES];
+    int file_count;
+    unsigned generation;       // 每批递增，写入 user_data，不会把旧批次的完成事件记到新文件上
+    int broken;                // 无法确认已提交的请求全部完成，之后不再使用 ring
+    WriterStats* stats;
+    BatchFailure on_failure;
+    void* failure_user;
+    pthread_mutex_t lock;
+};
+
+static int ring_setup(unsigned entries, struct io_uring_params* params) {
+    return (int)syscall(__NR_io_uring_setup, entries, params);
+}
+
+static int ring_enter(int fd, unsigned to_submit, unsigned min_complete, unsigned flags) {
+    return (int)syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, NULL, 0);
+}
+
+static int ring_register(int fd, unsigned opcode, void* arg, unsigned nr_args) {
+    return (int)syscall(__NR_io_uring_register, fd, opcode, arg, nr_args);
+}
+
+void output_batch_destroy(OutputBatch* batch) {
+    if (!batch) return;
+
+    output_batch_flush(batch);
+    if (batch->sqes) munmap(batch->sqes, batch->sqes_size);
+    if (batch->cq_ptr) munmap(batch->cq_ptr, batch->cq_size);
+    if (batch->sq_ptr) munmap(batch->sq_ptr, batch->sq_size);
+    if (batch->ring_fd >= 0) close(batch->ring_fd);
+    pthread_mutex_destroy(&batch->lock);
+    free(batch);
+}
+
+OutputBatch* output_batch_create(WriterStats* stats, BatchFailure on_failure, void* user) {
+    OutputBatch* batch = calloc(1, sizeof(OutputBatch));
+    if (!batch) return NULL;
+    pthread_mutex_init(&batch->lock, NULL);
+    batch->stats = stats;
+    batch->on_failure = on_failure;
+    batch->failure_user = user;
+
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    batch->ring_fd = ring_setup(BATCH_RING_ENTRIES, &params);
+    if (batch->ring_fd < 0) {
+        batch->ring_fd = -1;
+        output_batch_destroy(batch);
+        return NULL;
+    }
+
+    batch->sq_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    batch->cq_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    batch->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+
+    void* sq_ptr = mmap(NULL, batch->sq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                        batch->ring_fd, IORING_OFF_SQ_RING);
+    void* cq_ptr = mmap(NULL, batch->cq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                        batch->ring_fd, IORING_OFF_CQ_RING);
+    void* sqes = mmap(NULL, batch->sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                      batch->ring_fd, IORING_OFF_SQES);
+    batch->sq_ptr = sq_ptr == MAP_FAILED ? NULL : sq_ptr;
+    batch->cq_ptr = cq_ptr == MAP_FAILED ? NULL : cq_ptr;
+    batch->sqes = sqes == MAP_FAILED ? NULL : sqes;
+    if (!batch->sq_ptr || !batch->cq_ptr || !batch->sqes) {
+        output_batch_destroy(batch);
+        return NULL;
+    }
+
+    char* sq = batch->sq_ptr;
+    char* cq = batch->cq_ptr;
+    batch->sq_head = (unsigned*)(sq + params.sq_off.head);
+    batch->sq_tail = (unsigned*)(sq + params.sq_off.tail);
+    batch->sq_mask = (unsigned*)(sq + params.sq_off.ring_mask);
+    batch->sq_array = (unsigned*)(sq + params.sq_off.array);
+    batch->cq_head = (unsigned*)(cq + params.cq_off.head);
+    batch->cq_tail = (unsigned*)(cq + params.cq_off.tail);
+    batch->cq_mask = (unsigned*)(cq + params.cq_off.ring_mask);
+    batch->cqes = (struct io_uring_cqe*)(cq + params.cq_off.cqes);
+
+    // 注册稀疏的固定文件表，open 的结果直接放入槽位，链中的 write/close 无需知道 fd
+    struct io_uring_rsrc_register reg;
+    memset(&reg, 0, sizeof(reg));
+    reg.nr = OUTPUT_BATCH_FILES;
+    reg.flags = IORING_RSRC_REGISTER_SPARSE;
+    if (ring_register(batch->ring_fd, IORING_REGISTER_FILES2, &reg, sizeof(reg)) < 0) {
+        output_batch_destroy(batch);
+        return NULL;
+    }
+
+    return batch;
+}
+
+static struct io_uring_sqe* queue_sqe(OutputBatch* batch, unsigned* tail, int file, int op) {
+    unsigned index = *tail & *batch->sq_mask;
+    struct io_uring_sqe* sqe = &batch->sqes[index];
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->user_data = ((unsigned long long)batch->generation << 32) | ((unsigned long long)file << 2) | op;
+    batch->sq_array[index] = index;
+    (*tail)++;
+    return sqe;
+}
+
+// 收取当前批次的完成事件，返回收到的个数；其他批次遗留的事件直接丢弃
+static unsigned reap_completions(OutputBatch* batch) {
+    unsigned reaped = 0;
+    unsigned head = *batch->cq_head;
+    unsigned cq_tail = __atomic_load_n(batch->cq_tail, __ATOMIC_ACQUIRE);
+    while (head != cq_tail) {
+        struct io_uring_cqe* cqe = &batch->cqes[head & *batch->cq_mask];
+        head++;
+        if ((unsigned)(cqe->user_data >> 32) != batch->generation) continue;
+
+        int file = (int)((cqe->user_data >> 2) & 0x3FFFFFFF);
+        int op = (int)(cqe->user_data & 3);
+        int ok = cqe->res >= 0 &&
+                 (op != OP_WRITE || (size_t)cqe->res == batch->files[file].length);
+        if (ok && file < batch->file_count) batch->files[file].completed++;
+        reaped++;
+    }
+    __atomic_store_n(batch->cq_head, head, __ATOMIC_RELEASE);
+    return reaped;
+}
+
+// 一次系统调用提交整批并等待全部完成；提交出错时不再提交剩余的 SQE，但仍等待已提交的请求
+// 返回 1 表示已提交的请求全部完成，0 表示无法确认
+static int submit_and_wait(OutputBatch* batch, unsigned total) {
+    unsigned pending = total;      // 还在提交队列中的 SQE
+    unsigned in_flight = 0;        // 已提交、尚未完成
+    int can_submit = 1;
+
+    while (in_flight > 0 || (pending > 0 && can_submit)) {
+        unsigned submit = can_submit ? pending : 0;
+        int ret = ring_enter(batch->ring_fd, submit, in_flight + submit, IORING_ENTER_GETEVENTS);
+        int error = ret < 0 ? errno : 0;
+        if (ret > 0) {
+            unsigned n = (unsigned)ret < pending ? (unsigned)ret : pending;
+            pending -= n;
+            in_flight += n;
+        }
+        unsigned reaped = reap_completions(batch);
+        in_flight -= reaped < in_flight ? reaped : in_flight;
+        if (ret == 0 && submit > 0 && reaped == 0) error = EAGAIN;
+
+        if (error == 0 || error == EINTR) continue;
+        if ((error == EAGAIN || error == EBUSY) && reaped > 0) continue;  // 完成队列腾出空间后重试
+
+        // 其他错误：剩余的 SQE 不再提交，只等待已提交的请求；等待本身也出错时无法确认
+        if (!can_submit) return 0;
+        can_submit = 0;
+    }
+
+    // 没有提交的 SQE 从队列中撤回，下一批不会把它们一起提交
+    if (pending > 0) {
+        __atomic_store_n(batch->sq_tail, __atomic_load_n(batch->sq_head, __ATOMIC_ACQUIRE), __ATOMIC_RELEASE);
+    }
+    return 1;
+}
+
+static int flush_locked(OutputBatch* batch) {
+    if (batch->file_count == 0) return 0;
+    batch->generation++;
+
+    unsigned tail = *batch->sq_tail;
+    for (int i = 0; i < batch->file_count; i++) {
+        BatchFile* file = &batch->files[i];
+        file->completed = 0;
+
+        struct io_uring_sqe* sqe = queue_sqe(batch, &tail, i, OP_OPEN);
+        sqe->opcode = IORING_OP_OPENAT;
+        sqe->fd = AT_FDCWD;
+        sqe->addr = (unsigned long long)(uintptr_t)file->tmp_path;
+        sqe->len = 0666;
+        sqe->open_flags = O_WRONLY | O_CREAT | O_TRUNC;  // 直接描述符不允许 O_CLOEXEC
+        sqe->file_index = i + 1;
+        sqe->flags = IOSQE_IO_LINK;
+
+        sqe = queue_sqe(batch, &tail, i, OP_WRITE);
+        sqe->opcode = IORING_OP_WRITE;
+        sqe->fd = i;
+        sqe->addr = (unsigned long long)(uintptr_t)file->data;
+        sqe->len = (unsigned)file->length;
+        sqe->off = 0;
+        sqe->flags = IOSQE_FIXED_FILE | IOSQE_IO_LINK;
+
+        sqe = queue_sqe(batch, &tail, i, OP_CLOSE);
+        sqe->opcode = IORING_OP_CLOSE;
+        sqe->file_index = i + 1;
+        sqe->flags = IOSQE_IO_LINK;
+
+        sqe = queue_sqe(batch, &tail, i, OP_RENAME);
+        sqe->opcode = IORING_OP_RENAMEAT;
+        sqe->fd = AT_FDCWD;
+        sqe->addr = (unsigned long long)(uintptr_t)file->tmp_path;
+        sqe->len = AT_FDCWD;
+        sqe->addr2 = (unsigned long long)(uintptr_t)file->path;
+    }
+    __atomic_store_n(batch->sq_tail, tail, __ATOMIC_RELEASE);
+
+    // 回退到普通写出之前必须等内核交还每个已提交请求的完成事件，否则两边会同时写同一个临时文件，
+    // 缓冲区也可能在内核读取时被释放；确认不了时不再使用 ring，仍可能被读取的缓冲区不释放
+    int drained = submit_and_wait(batch, batch->file_count * BATCH_OPS_PER_FILE);
+    if (!drained) {
+        batch->broken = 1;
+        log_warn("io_uring stopped responding, falling back to POSIX writes");
+    }
+
+    // 任一步骤失败（例如旧内核不支持某个操作）时改用普通写出
+    int failed = 0;
+    for (int i = 0; i < batch->file_count; i++) {
+        BatchFile* file = &batch->files[i];
+        int done = file->completed == BATCH_OPS_PER_FILE;
+        WriteResult result = WRITE_WRITTEN;
+        if (!done) {
+            result = replace_file_via(file->path, file->data, file->length, drained ? ".tmp" : ".tmp-fallback");
+        }
+        if (result == WRITE_FAILED) {
+            failed++;
+            if (batch->on_failure) batch->on_failure(batch->failure_user, file->path);
+        }
+        count_result(batch->stats, result);
+        free(file->path);
+        if (drained || done) mem_free(MEM_OUTPUT, file->data);
+    }
+    batch->file_count = 0;
+    return failed;
+}
+
+int output_batch_flush(OutputBatch* batch) {
+    if (!batch) return 0;
+    pthread_mutex_lock(&batch->lock);
+    int failed = flush_locked(batch);
+    pthread_mutex_unlock(&batch->lock);
+    return failed;
+}
+
+WriteResult output_batch_add(OutputBatch* batch, const char* path, char* data, size_t length) {
+    if (same_as_disk(path, data, length)) {
+        mem_free(MEM_OUTPUT, data);
+        return count_result(batch->stats, WRITE_UNCHANGED);
+    }
+
+    // 超过单次写入上限的文件以及 ring 不可用之后直接走普通路径；
+    // ring 不可用时换一个临时文件名，避开可能仍在执行的内核请求
+    pthread_mutex_lock(&batch->lock);
+    int broken = batch->broken;
+    if (length > (1u << 30) || broken) {
+        pthread_mutex_unlock(&batch->lock);
+        WriteResult result = count_result(batch->stats,
+                                          replace_file_via(path, data, length, broken ? ".tmp-fallback" : ".tmp"));
+        mem_free(MEM_OUTPUT, data);
+        return result;
+    }
+
+    // 同一批中不能出现重复路径，否则临时文件会互相覆盖
+    for (int i = 0; i < batch->file_count; i++) {
+        if (strcmp(batch->files[i].path, path) == 0) {
+            flush_locked(batch);
+            break;
+        }
+    }
+    if (batch->file_count == OUTPUT_BATCH_FILES) flush_locked(batch);
+
+    BatchFile* file = &batch->files[batch->file_count];
+    file->path = strdup(path);
+    if (!file->path) {
+        pthread_mutex_unlock(&batch->lock);
+        mem_free(MEM_OUTPUT, data);
+        return count_result(batch->stats, WRITE_FAILED);
+    }
+    snprintf(file->tmp_path, sizeof(file->tmp_path), "%s.tmp", path);
+    file->data = data;
+    file->length = length;
+    batch->file_count++;
+
+    pthread_mutex_unlock(&batch->lock);
+    return WRITE_QUEUED;
+}
+
+#else
+
+OutputBatch* output_batch_create(WriterStats* stats, BatchFailure on_failure, void* user) {
+    (void)stats;
+    (void)on_failure;
+    (void)user;
+    return NULL;
+}
+
+WriteResult output_batch_add(OutputBatch* batch, const char* path, char* data, size_t length) {
+    (void)batch;
+    WriteResult result = write_output_file(path, data, length, NULL);
+    mem_free(MEM_OUTPUT, data);
+    return result;
+}
+
+int output_batch_flush(OutputBatch* batch) {
+    (void)batch;
+    return 0;
+}
+
+void output_batch_destroy(OutputBatch* batch) {
+    (void)batch;
+}
+
+#endif
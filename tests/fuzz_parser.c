@@ -0,0 +1,132 @@
+// 解析器的模糊测试入口：每个输入都做完整的差分检查，不一致时 abort
+// 使用 libFuzzer：定义 BLOG_LIBFUZZER 并加上 -fsanitize=fuzzer 编译（见 make fuzz）
+// 不使用 libFuzzer 时：blog-fuzz [--runs N] [--seed N] [文件...]，给出文件时逐个重放
+#include "harness.h"
+#include "../include/parser.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// 差分检查之外，输入本身也作为模板，检查占位符切分
+static int check_input(const uint8_t* data, size_t size, char* message, size_t message_size) {
+    if (!check_markdown((const char*)data, size, message, message_size)) return 0;
+
+    char* text = malloc(size + 1);
+    if (!text) return 1;
+    memcpy(text, data, size);
+    text[size] = '\0';
+    int ok = check_template(text, "<p>content</p>", message, message_size);
+    free(text);
+    return ok;
+}
+
+int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    char message[512];
+    if (!check_input(data, size, message, sizeof(message))) {
+        fprintf(stderr, "fuzz: %s\n", message);
+        abort();
+    }
+    return 0;
+}
+
+#ifndef BLOG_LIBFUZZER
+
+#define FUZZ_DEFAULT_RUNS 10000
+#define FUZZ_MAX_INPUT 4096
+
+// 由 Markdown 片段和随机字节拼成的输入，偏向解析器关心的结构
+static size_t random_markdown(unsigned* seed, char* out, size_t capacity) {
+    static const char* tokens[] = {
+        "\n", "\n\n", "---\n", "# ", "###### ", "- ", "* ", "1. ", "> ", "```", "```c\n", "\n```\n",
+        "**", "_", "`", "[", "](", ")", "![", "<", ">", "&", "\"", "{{", "}}", "{{content}}", "{{ title }}",
+        "{{asset:a.css}}", "text ", "中文", "😀", "\r\n", "\t", "    ", "<script>", "javascript:",
+        // 各类 UTF-8 序列的边界值
+        "\xC2\x80", "\xDF\xBF", "\xE0\xA0\x80", "\xED\x9F\xBF", "\xEE\x80\x80", "\xF0\x90\x80\x80", "\xF4\x8F\xBF\xBF"
+    };
+    size_t length = 0;
+    size_t target = harness_random(seed) % capacity;
+    // 一半的输入不插入随机字节，保持合法的 UTF-8，才能走到行索引和渲染的比较
+    int noisy = harness_random(seed) % 2;
+    while (length < target) {
+        unsigned pick = harness_random(seed);
+        if (noisy && pick % 10 == 0) {
+            out[length++] = (char)(harness_random(seed) & 0xFF);
+            continue;
+        }
+        const char* token = tokens[pick % (sizeof(tokens) / sizeof(tokens[0]))];
+        size_t n = strlen(token);
+        if (length + n > capacity) break;
+        memcpy(out + length, token, n);
+        length += n;
+    }
+    // 偶尔构造超过解析器行缓冲区的长行
+    if (harness_random(seed) % 64 == 0) {
+        while (length < capacity) out[length++] = 'x';
+    }
+    return length;
+}
+
+static int replay_file(const char* path) {
+    FILE* fp = fopen(path, "rb");
+    if (!fp) {
+        printf("Error: Could not open %s\n", path);
+        return 0;
+    }
+    fseek(fp, 0, SEEK_END);
+    long size = ftell(fp);
+    rewind(fp);
+    uint8_t* data = malloc(size > 0 ? size : 1);
+    size_t length = data ? fread(data, 1, size, fp) : 0;
+    fclose(fp);
+    if (!data) return 0;
+
+    LLVMFuzzerTestOneInput(data, length);
+    free(data);
+    printf("ok    %s\n", path);
+    return 1;
+}
+
+int main(int argc, char* argv[]) {
+    long runs = FUZZ_DEFAULT_RUNS;
+    unsigned seed = 1;
+    int files = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--runs") == 0 && i + 1 < argc) {
+            runs = atol(argv[++i]);
+        } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            seed = (unsigned)strtoul(argv[++i], NULL, 10);
+        } else if (argv[i][0] != '-') {
+            if (!replay_file(argv[i])) return 1;
+            files++;
+        } else {
+            printf("Usage: %s [--runs N] [--seed N] [FILE...]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (files) return 0;
+
+    char buffer[FUZZ_MAX_INPUT + 1];
+    for (long i = 0; i < runs; i++) {
+        // 每个输入的种子可以单独重现：--seed N --runs 1
+        unsigned input_seed = seed + (unsigned)i;
+        unsigned state = input_seed;
+        size_t length = random_markdown(&state, buffer, FUZZ_MAX_INPUT);
+        char message[512];
+        if (!check_input((const uint8_t*)buffer, length, message, sizeof(message))) {
+            printf("FAIL  seed %u: %s\n", input_seed, message);
+            FILE* fp = fopen("fuzz-crash.md", "wb");
+            if (fp) {
+                fwrite(buffer, 1, length, fp);
+                fclose(fp);
+                printf("Input written to fuzz-crash.md\n");
+            }
+            return 1;
+        }
+    }
+    printf("%ld random input(s) passed (seed %u)\n", runs, seed);
+    return 0;
+}
+
+#endif /* BLOG_LIBFUZZER */
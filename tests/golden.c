@@ -0,0 +1,187 @@
+// 差分测试：语料中的每个 Markdown 文件分别走参考路径和优化路径，HTML 必须逐字节相同，
+// 参考路径的输出还要与 tests/golden 中保存的结果一致
+// 用法：blog-golden [--update] [语料目录] [期望输出目录]
+#include "harness.h"
+#include <dirent.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define GOLDEN_CORPUS_DIR "tests/corpus"
+#define GOLDEN_EXPECTED_DIR "tests/golden"
+#define GOLDEN_MAX_FILES 256
+#define GOLDEN_RANDOM_CASES 2000
+
+static int failures = 0;
+
+static void report(const char* name, int ok, const char* message) {
+    if (ok) {
+        printf("ok    %s\n", name);
+    } else {
+        printf("FAIL  %s: %s\n", name, message);
+        failures++;
+    }
+}
+
+static char* read_file(const char* path, size_t* length) {
+    FILE* fp = fopen(path, "rb");
+    if (!fp) return NULL;
+    fseek(fp, 0, SEEK_END);
+    long size = ftell(fp);
+    rewind(fp);
+    char* data = size >= 0 ? malloc(size + 1) : NULL;
+    if (data) {
+        *length = fread(data, 1, size, fp);
+        data[*length] = '\0';
+    }
+    fclose(fp);
+    return data;
+}
+
+static int write_file(const char* path, const char* data) {
+    FILE* fp = fopen(path, "wb");
+    if (!fp) return 0;
+    int ok = fwrite(data, 1, strlen(data), fp) == strlen(data);
+    if (fclose(fp) != 0) ok = 0;
+    return ok;
+}
+
+// 参考路径的输出与保存的期望结果比较；--update 时改为写入
+static int check_golden(const char* expected_dir, const char* name, const char* html,
+                        int update, char* message, size_t size) {
+    char path[512];
+    snprintf(path, sizeof(path), "%s/%.*s.html", expected_dir, (int)(strlen(name) - 3), name);
+
+    if (update) {
+        if (write_file(path, html)) return 1;
+        snprintf(message, size, "could not write %s", path);
+        return 0;
+    }
+
+    size_t length;
+    char* expected = read_file(path, &length);
+    if (!expected) {
+        snprintf(message, size, "missing %s (run with --update to create it)", path);
+        return 0;
+    }
+    int ok = strcmp(expected, html) == 0;
+    if (!ok) snprintf(message, size, "output differs from %s", path);
+    free(expected);
+    return ok;
+}
+
+// 在每个位置插入非法或截断的序列，检查错误位置与参考实现一致
+static int check_utf8_mutations(const char* data, size_t length, char* message, size_t size) {
+    static const char* bad[] = {"\x80", "\xC0\xAF", "\xE0\x80\x80", "\xED\xA0\x80", "\xF4\x90\x80\x80", "\xF0\x9F", "\xFF"};
+    char* buffer = malloc(length + 8);
+    if (!buffer) return 0;
+
+    // 长文件每隔若干字节取一个位置，保证覆盖 16 字节块的每种对齐
+    size_t step = length > 4096 ? 37 : 1;
+    for (size_t at = 0; at <= length; at += step) {
+        const char* seq = bad[at % (sizeof(bad) / sizeof(bad[0]))];
+        size_t n = strlen(seq);
+        memcpy(buffer, data, at);
+        memcpy(buffer + at, seq, n);
+        memcpy(buffer + at + n, data + at, length - at);
+        if (!check_utf8_scan(buffer, length + n, message, size)) {
+            size_t used = strlen(message);
+            snprintf(message + used, size - used, " (invalid sequence inserted at %zu)", at);
+            free(buffer);
+            return 0;
+        }
+    }
+    free(buffer);
+    return 1;
+}
+
+// 随机拼接 ASCII、换行和多字节字符，偶尔插入非法字节
+static size_t random_utf8(unsigned* seed, char* out, size_t capacity) {
+    static const char* pieces[] = {"a", "word ", "\n", "\n\n", "é", "中", "😀", "\xED\x9F\xBF", "\xF4\x8F\xBF\xBF",
+                                   "- ", "# ", "```\n", "**", "`", "[x](y)", "<b>", "&", "---\n"};
+    size_t length = 0;
+    size_t target = harness_random(seed) % capacity;
+    while (length < target) {
+        const char* piece = pieces[harness_random(seed) % (sizeof(pieces) / sizeof(pieces[0]))];
+        size_t n = strlen(piece);
+        if (length + n > capacity) break;
+        memcpy(out + length, piece, n);
+        length += n;
+    }
+    if (length && harness_random(seed) % 8 == 0) out[harness_random(seed) % length] = (char)0x80;
+    return length;
+}
+
+static int compare_names(const void* a, const void* b) {
+    return strcmp(*(char* const*)a, *(char* const*)b);
+}
+
+int main(int argc, char* argv[]) {
+    int update = 0;
+    const char* dirs[2] = {GOLDEN_CORPUS_DIR, GOLDEN_EXPECTED_DIR};
+    int dir_count = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--update") == 0) {
+            update = 1;
+        } else if (argv[i][0] != '-' && dir_count < 2) {
+            dirs[dir_count++] = argv[i];
+        } else {
+            printf("Usage: %s [--update] [CORPUS_DIR] [EXPECTED_DIR]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    DIR* dir = opendir(dirs[0]);
+    if (!dir) {
+        printf("Error: Could not open corpus directory %s\n", dirs[0]);
+        return 1;
+    }
+    char* names[GOLDEN_MAX_FILES];
+    int count = 0;
+    struct dirent* entry;
+    while ((entry = readdir(dir)) != NULL && count < GOLDEN_MAX_FILES) {
+        size_t len = strlen(entry->d_name);
+        if (len > 3 && strcmp(entry->d_name + len - 3, ".md") == 0) names[count++] = strdup(entry->d_name);
+    }
+    closedir(dir);
+    qsort(names, count, sizeof(char*), compare_names);
+
+    char message[1024];
+    for (int i = 0; i < count; i++) {
+        char path[512];
+        snprintf(path, sizeof(path), "%s/%s", dirs[0], names[i]);
+        size_t length = 0;
+        char* data = read_file(path, &length);
+        char* html = data ? render_reference(data, length) : NULL;
+
+        int ok = html != NULL;
+        if (!ok) snprintf(message, sizeof(message), "could not read or render %s", path);
+        if (ok) ok = check_golden(dirs[1], names[i], html, update, message, sizeof(message));
+        if (ok) ok = check_markdown(data, length, message, sizeof(message));
+        if (ok) ok = check_template(data, html, message, sizeof(message));
+        if (ok) ok = check_utf8_mutations(data, length, message, sizeof(message));
+        report(names[i], ok, message);
+
+        free(html);
+        free(data);
+        free(names[i]);
+    }
+
+    // 合成输入：覆盖语料中没有的组合和 16 字节块边界
+    unsigned seed = 47;
+    char buffer[512];
+    int random_ok = 1;
+    for (int i = 0; i < GOLDEN_RANDOM_CASES && random_ok; i++) {
+        size_t length = random_utf8(&seed, buffer, sizeof(buffer));
+        random_ok = check_markdown(buffer, length, message, sizeof(message));
+        if (!random_ok) {
+            size_t used = strlen(message);
+            snprintf(message + used, sizeof(message) - used, " (random case %d)", i);
+        }
+    }
+    report("random inputs", random_ok, message);
+
+    printf("%d file(s), %d failure(s)%s\n", count, failures, update ? ", expected output updated" : "");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,434 @@
+#include "harness.h"
+#include "../include/parser.h"
+#include "../include/minify.h"
+#include "../include/memstats.h"
+#include "../include/blog.h"
+#include "../include/writer.h"
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+unsigned harness_random(unsigned* state) {
+    unsigned x = *state ? *state : 0x9E3779B9u;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
+
+static char* copy_text(const char* data, size_t length) {
+    char* copy = malloc(length + 1);
+    if (!copy) return NULL;
+    memcpy(copy, data, length);
+    copy[length] = '\0';
+    return copy;
+}
+
+// get_html_output 没有块时返回 NULL；统一转换为 malloc 分配的字符串
+static char* take_html(ParserContext* ctx) {
+    char* html = get_html_output(ctx);
+    char* result = copy_text(html ? html : "", html ? strlen(html) : 0);
+    mem_free(MEM_RENDER, html);
+    return result;
+}
+
+char* render_reference(const char* markdown, size_t length) {
+    char* text = copy_text(markdown, length);
+    char* result = text ? reference_parse_markdown(text) : NULL;
+    free(text);
+    return result;
+}
+
+char* render_with_context(const char* markdown, size_t length) {
+    char* text = copy_text(markdown, length);
+    ParserContext* ctx = create_parser_context(NULL);
+    char* result = NULL;
+    if (text && ctx && parse_markdown_with_context(ctx, text)) result = take_html(ctx);
+    destroy_parser_context(ctx);
+    free(text);
+    return result;
+}
+
+char* render_indexed(const char* markdown, size_t length, int use_index) {
+    // 恰好 length 字节，越界读取可以被 AddressSanitizer 发现
+    char* data = malloc(length ? length : 1);
+    if (!data) return NULL;
+    memcpy(data, markdown, length);
+
+    LineIndex lines = {0};
+    size_t error_offset;
+    if (use_index && scan_utf8_lines(data, length, &lines, &error_offset) != 1) {
+        free_line_index(&lines);
+        free(data);
+        return NULL;
+    }
+
+    ParserContext* ctx = create_parser_context(NULL);
+    char* result = NULL;
+    if (ctx && parse_markdown_indexed(ctx, data, length, use_index ? &lines : NULL)) {
+        result = take_html(ctx);
+    }
+    destroy_parser_context(ctx);
+    free_line_index(&lines);
+    free(data);
+    return result;
+}
+
+static void append_html(void* user, const char* data, size_t length) {
+    output_append((OutputBuffer*)user, data, length);
+}
+
+char* render_streaming(const char* markdown, size_t length) {
+    char* data = malloc(length ? length : 1);
+    if (!data) return NULL;
+    memcpy(data, markdown, length);
+
+    OutputBuffer out;
+    output_init(&out);
+    ParserContext* ctx = create_parser_context(NULL);
+    char* result = NULL;
+    if (ctx && parse_markdown_streaming(ctx, data, length, append_html, &out) && !out.failed) {
+        result = copy_text(out.data ? out.data : "", out.length);
+    }
+    destroy_parser_context(ctx);
+    output_free(&out);
+    free(data);
+    return result;
+}
+
+static int add_line(LineIndex* lines, size_t offset) {
+    if (lines->count == lines->capacity) {
+        size_t capacity = lines->capacity ? lines->capacity * 2 : 64;
+        size_t* starts = mem_realloc(MEM_SOURCE, lines->starts, capacity * sizeof(size_t));
+        if (!starts) return 0;
+        lines->starts = starts;
+        lines->capacity = capacity;
+    }
+    lines->starts[lines->count++] = offset;
+    return 1;
+}
+
+// 按 Unicode 标准表 3-7 逐个解码，每个序列从首字节开始完整检查
+static size_t utf8_sequence_length(const unsigned char* p, size_t available) {
+    unsigned char c = p[0];
+    size_t need;
+    unsigned char low = 0x80, high = 0xBF;
+
+    if (c < 0x80) return 1;
+    if (c >= 0xC2 && c <= 0xDF) need = 1;
+    else if (c == 0xE0) { need = 2; low = 0xA0; }
+    else if (c == 0xED) { need = 2; high = 0x9F; }
+    else if (c >= 0xE1 && c <= 0xEF) need = 2;
+    else if (c == 0xF0) { need = 3; low = 0x90; }
+    else if (c == 0xF4) { need = 3; high = 0x8F; }
+    else if (c >= 0xF1 && c <= 0xF3) need = 3;
+    else return 0;
+
+    if (available < need + 1) return 0;
+    if (p[1] < low || p[1] > high) return 0;
+    for (size_t k = 2; k <= need; k++) {
+        if (p[k] < 0x80 || p[k] > 0xBF) return 0;
+    }
+    return need + 1;
+}
+
+int reference_scan_utf8(const char* data, size_t length, LineIndex* lines, size_t* error_offset) {
+    const unsigned char* p = (const unsigned char*)data;
+    lines->base = data;
+    lines->count = 0;
+    *error_offset = 0;
+    if (!add_line(lines, 0)) return -1;
+
+    size_t i = 0;
+    while (i < length) {
+        size_t n = utf8_sequence_length(p + i, length - i);
+        if (n == 0) {
+            *error_offset = i;
+            return 0;
+        }
+        if (p[i] == '\n' && !add_line(lines, i + 1)) return -1;
+        i += n;
+    }
+    return 1;
+}
+
+int check_utf8_scan(const char* data, size_t length, char* message, size_t size) {
+    LineIndex expected = {0}, actual = {0};
+    size_t expected_error, actual_error;
+    int expected_result = reference_scan_utf8(data, length, &expected, &expected_error);
+    int actual_result = scan_utf8_lines(data, length, &actual, &actual_error);
+    int ok = 1;
+
+    if (expected_result < 0 || actual_result < 0) {
+        snprintf(message, size, "utf-8 scan: out of memory");
+        ok = 0;
+    } else if (expected_result != actual_result) {
+        snprintf(message, size, "utf-8 scan: reference says %s, scan_utf8_lines says %s",
+                 expected_result ? "valid" : "invalid", actual_result ? "valid" : "invalid");
+        ok = 0;
+    } else if (!expected_result && expected_error != actual_error) {
+        snprintf(message, size, "utf-8 scan: error offset %zu, expected %zu", actual_error, expected_error);
+        ok = 0;
+    } else if (expected_result) {
+        // 出错时只比较错误位置；合法时行索引必须完全相同
+        if (expected.count != actual.count) {
+            snprintf(message, size, "utf-8 scan: %zu line(s), expected %zu", actual.count, expected.count);
+            ok = 0;
+        }
+        for (size_t i = 0; ok && i < expected.count; i++) {
+            if (expected.starts[i] != actual.starts[i]) {
+                snprintf(message, size, "utf-8 scan: line %zu starts at %zu, expected %zu",
+                         i, actual.starts[i], expected.starts[i]);
+                ok = 0;
+            }
+        }
+    }
+
+    free_line_index(&expected);
+    free_line_index(&actual);
+    return ok;
+}
+
+// 报告第一个不同的字节以及附近的内容
+static int compare_output(const char* what, const char* expected, const char* actual,
+                          char* message, size_t size) {
+    if (!expected || !actual) {
+        snprintf(message, size, "%s: no output", what);
+        return 0;
+    }
+    if (strcmp(expected, actual) == 0) return 1;
+
+    size_t at = 0;
+    while (expected[at] && expected[at] == actual[at]) at++;
+    size_t from = at > 20 ? at - 20 : 0;
+    snprintf(message, size, "%s: differs at byte %zu\n    expected: %.60s\n    actual:   %.60s",
+             what, at, expected + from, actual + from);
+    return 0;
+}
+
+// libblog 复用同一个渲染上下文，检查上一次渲染不会影响下一次
+static int check_library(const char* data, size_t length, const char* reference, char* message, size_t size) {
+    static BlogRenderer* renderer = NULL;
+    if (!renderer && !(renderer = blog_renderer_create())) {
+        snprintf(message, size, "libblog: could not create renderer");
+        return 0;
+    }
+
+    // 先用放不下的缓冲区取得长度，再渲染到恰好足够的缓冲区
+    size_t needed = 0;
+    char small[1];
+    BlogStatus status = blog_render_markdown(renderer, data, length, small, 0, &needed);
+    if (status != BLOG_ERROR_TOO_SMALL || needed != strlen(reference)) {
+        snprintf(message, size, "libblog: expected BLOG_ERROR_TOO_SMALL with length %zu, got %s with %zu",
+                 strlen(reference), blog_status_message(status), needed);
+        return 0;
+    }
+    char* out = malloc(needed + 1);
+    if (!out) return 1;
+    status = blog_render_markdown(renderer, data, length, out, needed + 1, &needed);
+    int ok = status == BLOG_OK && compare_output("blog_render_markdown", reference, out, message, size);
+    free(out);
+
+    const char* html = NULL;
+    if (ok) {
+        status = blog_render_markdown_arena(renderer, data, length, &html, NULL);
+        ok = status == BLOG_OK && compare_output("blog_render_markdown_arena", reference, html, message, size);
+    }
+    if (status != BLOG_OK) snprintf(message, size, "libblog: %s", blog_renderer_error(renderer));
+    return ok;
+}
+
+int check_markdown(const char* data, size_t length, char* message, size_t size) {
+    if (!check_utf8_scan(data, length, message, size)) return 0;
+
+    char* reference = render_reference(data, length);
+    if (!reference) {
+        snprintf(message, size, "reference render failed");
+        return 0;
+    }
+
+    // 参考路径和 parse_markdown_with_context 在第一个 '\0' 处结束，其余路径按长度处理；
+    // 含 '\0' 的输入只比较前两者，其余只检查不崩溃
+    char* whole = render_with_context(data, length);
+    int ok = compare_output("parse_markdown_with_context", reference, whole, message, size);
+    free(whole);
+    if (ok && !memchr(data, '\0', length)) {
+        char* span = render_indexed(data, length, 0);
+        ok = compare_output("parse_markdown_indexed without line index", reference, span, message, size);
+        free(span);
+
+        if (ok) {
+            char* streamed = render_streaming(data, length);
+            ok = compare_output("parse_markdown_streaming", reference, streamed, message, size);
+            free(streamed);
+        }
+
+        size_t error_offset;
+        LineIndex lines = {0};
+        int valid = scan_utf8_lines(data, length, &lines, &error_offset) == 1;
+        free_line_index(&lines);
+        if (ok && valid) {
+            char* indexed = render_indexed(data, length, 1);
+            ok = compare_output("parse_markdown_indexed with line index", reference, indexed, message, size);
+            free(indexed);
+        }
+        if (ok && valid) ok = check_library(data, length, reference, message, size);
+    }
+
+    if (ok) {
+        ok = check_template("<html><title>{{ title }}</title>{{date}}{{author}}{{description}}\n"
+                            "<main>{{content}}</main>{{unknown}}{{}}{{asset:}}{{asset:style.css}}</html>{{",
+                            reference, message, size);
+    }
+    if (ok) ok = check_minify(reference, strlen(reference), (unsigned)length + 1, message, size);
+
+    free(reference);
+    return ok;
+}
+
+static const char* placeholder_value(const char* name, size_t length, const char* content,
+                                     const PostMetadata* metadata, int* known) {
+    static const char* names[] = {"content", "title", "date", "author", "description"};
+    const char* values[] = {content, metadata->title, metadata->date, metadata->author, metadata->description};
+    for (int i = 0; i < 5; i++) {
+        if (strlen(names[i]) == length && strncmp(name, names[i], length) == 0) {
+            *known = 1;
+            return values[i];
+        }
+    }
+    *known = 0;
+    return NULL;
+}
+
+char* reference_template(const char* template_content, const char* content, const PostMetadata* metadata) {
+    size_t capacity = strlen(template_content) + strlen(content) + 1024;
+    size_t used = 0;
+    char* out = malloc(capacity);
+    if (!out) return NULL;
+
+#define EMIT(text, len) do { \
+        size_t n_ = (len); \
+        while (used + n_ + 1 > capacity) { \
+            capacity *= 2; \
+            char* grown_ = realloc(out, capacity); \
+            if (!grown_) { free(out); return NULL; } \
+            out = grown_; \
+        } \
+        memcpy(out + used, (text), n_); \
+        used += n_; \
+    } while (0)
+
+    const char* p = template_content;
+    while (*p) {
+        if (p[0] != '{' || p[1] != '{') {
+            EMIT(p, 1);
+            p++;
+            continue;
+        }
+
+        const char* close = strstr(p + 2, "}}");
+        if (!close) {
+            EMIT(p, strlen(p));
+            break;
+        }
+        const char* name = p + 2;
+        const char* name_end = close;
+        while (name < name_end && isspace((unsigned char)*name)) name++;
+        while (name_end > name && isspace((unsigned char)name_end[-1])) name_end--;
+
+        int known;
+        const char* value = placeholder_value(name, name_end - name, content, metadata, &known);
+        if (known) {
+            if (value) EMIT(value, strlen(value));
+            p = close + 2;
+        } else if (name_end - name > 6 && strncmp(name, "asset:", 6) == 0) {
+            // 没有资源清单时按原路径引用
+            EMIT("assets/", 7);
+            EMIT(name + 6, (size_t)(name_end - name - 6));
+            p = close + 2;
+        } else {
+            EMIT(p, 2);
+            p += 2;
+        }
+    }
+#undef EMIT
+
+    out[used] = '\0';
+    return out;
+}
+
+int check_template(const char* template_content, const char* content, char* message, size_t size) {
+    PostMetadata metadata = {0};
+    metadata.title = "Golden <title>";
+    metadata.date = "2024-03-01";
+    metadata.description = "{{content}} must not be expanded twice";
+
+    char* expected = reference_template(template_content, content, &metadata);
+    CompiledTemplate* tpl = compile_template(template_content);
+    char* actual = tpl ? render_template(tpl, content, &metadata) : NULL;
+    int ok = compare_output("render_template", expected, actual, message, size);
+
+    mem_free(MEM_OUTPUT, actual);
+    destroy_template(tpl);
+    free(expected);
+    return ok;
+}
+
+typedef struct {
+    char* data;
+    size_t length;
+    size_t capacity;
+    int failed;
+} Collected;
+
+static void collect(void* user, const char* data, size_t length) {
+    Collected* out = user;
+    if (out->failed) return;
+    if (out->length + length + 1 > out->capacity) {
+        size_t capacity = out->capacity ? out->capacity : 4096;
+        while (capacity < out->length + length + 1) capacity *= 2;
+        char* grown = realloc(out->data, capacity);
+        if (!grown) {
+            out->failed = 1;
+            return;
+        }
+        out->data = grown;
+        out->capacity = capacity;
+    }
+    memcpy(out->data + out->length, data, length);
+    out->length += length;
+    out->data[out->length] = '\0';
+}
+
+static char* minify_pieces(const char* html, size_t length, unsigned* seed) {
+    Collected out = {0};
+    HtmlMinifier minifier;
+    minifier_init(&minifier, collect, &out);
+
+    size_t offset = 0;
+    while (offset < length) {
+        // seed 为 NULL 时整块输入，否则每次 1 到 64 字节
+        size_t piece = seed ? 1 + harness_random(seed) % 64 : length;
+        if (piece > length - offset) piece = length - offset;
+        minifier_feed(&minifier, html + offset, piece);
+        offset += piece;
+    }
+    minifier_finish(&minifier);
+
+    if (out.failed) {
+        free(out.data);
+        return NULL;
+    }
+    return out.data ? out.data : copy_text("", 0);
+}
+
+int check_minify(const char* html, size_t length, unsigned split_seed, char* message, size_t size) {
+    char* whole = minify_pieces(html, length, NULL);
+    char* split = minify_pieces(html, length, &split_seed);
+    int ok = compare_output("minifier with split input", whole, split, message, size);
+    free(whole);
+    free(split);
+    return ok;
+}
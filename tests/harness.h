@@ -0,0 +1,44 @@
+#ifndef TEST_HARNESS_H
+#define TEST_HARNESS_H
+
+#include <stddef.h>
+#include "../include/source.h"
+#include "../include/generator.h"
+
+// 差分测试和模糊测试共用：同一输入分别走参考路径和优化路径，结果必须逐字节相同
+// 失败时 message 中写入第一个差异的说明
+
+// 参考路径：以 '\0' 结尾的副本交给 reference_parse_markdown；没有输出时返回空字符串
+char* render_reference(const char* markdown, size_t length);
+
+// tests/reference_parser.c 中冻结的基线解析器，与 src/parser.c 不共享代码；结果用 free 释放
+char* reference_parse_markdown(const char* markdown);
+
+// 以 '\0' 结尾的副本交给 parse_markdown_with_context；没有输出时返回空字符串
+char* render_with_context(const char* markdown, size_t length);
+
+// 优化路径：与 generate_post_page 相同，在恰好 length 字节、不以 '\0' 结尾的缓冲区上
+// 建立行索引后调用 parse_markdown_indexed；use_index 为 0 时不用行索引，
+// 由解析器自己用 memchr 查找行尾。输入不是合法 UTF-8 时返回 NULL
+char* render_indexed(const char* markdown, size_t length, int use_index);
+
+// 流式路径：parse_markdown_streaming 逐块交出的 HTML 拼接起来，应与 render_indexed 相同
+char* render_streaming(const char* markdown, size_t length);
+
+// 逐字节的 UTF-8 校验和行索引，不做任何批量处理；返回值同 scan_utf8_lines
+int reference_scan_utf8(const char* data, size_t length, LineIndex* lines, size_t* error_offset);
+
+// 逐个查找占位符并替换，不预先编译；结果用 free 释放
+char* reference_template(const char* template_content, const char* content, const PostMetadata* metadata);
+
+// 各项对照，返回 1 表示一致
+int check_utf8_scan(const char* data, size_t length, char* message, size_t size);
+int check_markdown(const char* data, size_t length, char* message, size_t size);
+int check_template(const char* template_content, const char* content, char* message, size_t size);
+// 整块输入与按 split_seed 随机切分的输入，压缩结果必须相同
+int check_minify(const char* html, size_t length, unsigned split_seed, char* message, size_t size);
+
+// 确定性的伪随机数（xorshift），测试输入可复现
+unsigned harness_random(unsigned* state);
+
+#endif /* TEST_HARNESS_H */
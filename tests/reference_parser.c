@@ -0,0 +1,385 @@
+// 参考解析器：冻结的基线 Markdown 解析器（以 '\0' 结尾的输入，strchr/strstr 逐行读取），
+// 与 src/parser.c 不共享任何代码，优化路径的改动不会同时改变参考结果。
+// 只修正了原实现的内存错误：内存池 realloc 后块指针悬空、输出缓冲区一次只扩容一倍；
+// 块的识别和 HTML 输出规则逐字保留，不要随 src/parser.c 一起修改
+#include "harness.h"
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define REF_MAX_LINE_LENGTH 4096
+#define REF_MAX_HEADING_LEVEL 6
+
+typedef enum {
+    REF_PARAGRAPH,
+    REF_HEADING,
+    REF_CODE,
+    REF_LIST
+} RefBlockType;
+
+typedef struct RefBlock {
+    RefBlockType type;
+    char* content;
+    int level;  // 标题级别；代码块中为语言标识的长度
+    struct RefBlock* next;
+} RefBlock;
+
+typedef struct {
+    RefBlock* first;
+    RefBlock* last;
+} RefDocument;
+
+static RefBlock* ref_create_block(RefBlockType type, size_t content_size) {
+    RefBlock* block = malloc(sizeof(RefBlock));
+    if (!block) return NULL;
+    block->type = type;
+    block->content = NULL;
+    block->level = 0;
+    block->next = NULL;
+    if (content_size) {
+        block->content = malloc(content_size);
+        if (!block->content) {
+            free(block);
+            return NULL;
+        }
+    }
+    return block;
+}
+
+static void ref_add_block(RefDocument* doc, RefBlock* block) {
+    if (!doc->first) {
+        doc->first = block;
+    } else {
+        doc->last->next = block;
+    }
+    doc->last = block;
+}
+
+static void ref_free_document(RefDocument* doc) {
+    RefBlock* block = doc->first;
+    while (block) {
+        RefBlock* next = block->next;
+        free(block->content);
+        free(block);
+        block = next;
+    }
+}
+
+// 列表结束标记：content 为 NULL
+static int ref_end_list(RefDocument* doc) {
+    RefBlock* block = ref_create_block(REF_LIST, 0);
+    if (!block) return 0;
+    ref_add_block(doc, block);
+    return 1;
+}
+
+static RefBlock* ref_parse_heading(const char* line) {
+    int level = 0;
+    while (line[level] == '#' && level < REF_MAX_HEADING_LEVEL) {
+        level++;
+    }
+
+    if (level == 0 || !isspace(line[level])) return NULL;
+
+    const char* content = line + level;
+    while (isspace(*content)) content++;
+
+    RefBlock* block = ref_create_block(REF_HEADING, strlen(content) + 1);
+    if (!block) return NULL;
+    block->level = level;
+    strcpy(block->content, content);
+    return block;
+}
+
+static RefBlock* ref_parse_list_item(const char* line) {
+    if (!(*line == '-' || *line == '*' || isdigit(*line))) return NULL;
+
+    const char* content = line;
+    if (*content == '-' || *content == '*') {
+        content++;
+    } else {
+        while (isdigit(*content)) content++;
+        if (*content == '.') content++;
+    }
+    while (isspace(*content)) content++;
+
+    RefBlock* block = ref_create_block(REF_LIST, strlen(content) + 1);
+    if (!block) return NULL;
+    strcpy(block->content, content);
+    return block;
+}
+
+static RefBlock* ref_parse_code_block(const char** ptr) {
+    const char* start = *ptr;
+    if (strncmp(start, "```", 3) != 0) return NULL;
+
+    start += 3;
+    const char* lang_start = start;
+    while (*start && *start != '\n') start++;
+    size_t lang_len = start - lang_start;
+    if (*start == '\n') start++;
+
+    const char* end = strstr(start, "\n```");
+    if (!end) return NULL;
+
+    RefBlock* block = ref_create_block(REF_CODE, lang_len + (end - start) + 2);
+    if (!block) return NULL;
+
+    memcpy(block->content, lang_start, lang_len);
+    block->content[lang_len] = '\0';
+    block->level = (int)lang_len;
+
+    // 去掉行首缩进，行内连续空白合并为一个空格，去掉末尾空白
+    char* code = block->content + lang_len + 1;
+    const char* src = start;
+    char* dst = code;
+    int in_whitespace = 1;
+    int line_start = 1;
+
+    while (src < end) {
+        if (line_start) {
+            while (isspace(*src) && *src != '\n') src++;
+            line_start = 0;
+            in_whitespace = 1;
+        }
+
+        if (*src == '\n') {
+            *dst++ = *src++;
+            line_start = 1;
+            in_whitespace = 1;
+        } else if (isspace(*src)) {
+            if (!in_whitespace) {
+                *dst++ = ' ';
+                in_whitespace = 1;
+            }
+            src++;
+        } else {
+            *dst++ = *src++;
+            in_whitespace = 0;
+        }
+    }
+
+    while (dst > code && isspace(*(dst - 1))) dst--;
+    *dst = '\0';
+
+    *ptr = end + 4;
+    if (**ptr == '\n') (*ptr)++;
+    return block;
+}
+
+static int ref_parse(RefDocument* doc, const char* content) {
+    const char* ptr = content;
+    char line[REF_MAX_LINE_LENGTH];
+    RefBlock* block = NULL;
+    int in_list = 0;
+    int list_type = 0;
+
+    // YAML front matter
+    if (strncmp(ptr, "---\n", 4) == 0) {
+        ptr += 4;
+        while (*ptr) {
+            const char* eol = strchr(ptr, '\n');
+            if (!eol) break;
+
+            size_t line_len = eol - ptr;
+            if (line_len >= sizeof(line)) line_len = sizeof(line) - 1;
+            memcpy(line, ptr, line_len);
+            line[line_len] = '\0';
+
+            if (strcmp(line, "---") == 0) {
+                ptr = eol + 1;
+                while (*ptr == '\n') ptr++;
+                break;
+            }
+            ptr = eol + 1;
+        }
+    }
+
+    while (*ptr) {
+        if (strncmp(ptr, "```", 3) == 0) {
+            if (in_list) {
+                if (!ref_end_list(doc)) return 0;
+                in_list = 0;
+                list_type = 0;
+            }
+            block = ref_parse_code_block(&ptr);
+            if (block) {
+                ref_add_block(doc, block);
+                continue;
+            }
+        }
+
+        // 超长的行截断到 REF_MAX_LINE_LENGTH - 1 字节
+        const char* eol = strchr(ptr, '\n');
+        size_t line_len;
+        if (eol) {
+            line_len = eol - ptr;
+            if (line_len >= sizeof(line)) line_len = sizeof(line) - 1;
+            memcpy(line, ptr, line_len);
+            line[line_len] = '\0';
+            ptr = eol + 1;
+        } else {
+            line_len = strlen(ptr);
+            if (line_len >= sizeof(line)) line_len = sizeof(line) - 1;
+            memcpy(line, ptr, line_len);
+            line[line_len] = '\0';
+            ptr += line_len;
+        }
+
+        if (line_len == 0) {
+            if (in_list) {
+                if (!ref_end_list(doc)) return 0;
+                in_list = 0;
+                list_type = 0;
+            }
+            continue;
+        }
+
+        if (line[0] == '#') {
+            if (in_list) {
+                if (!ref_end_list(doc)) return 0;
+                in_list = 0;
+                list_type = 0;
+            }
+            block = ref_parse_heading(line);
+            if (block) {
+                ref_add_block(doc, block);
+                continue;
+            }
+        }
+
+        if (line[0] == '-' || line[0] == '*' || isdigit(line[0])) {
+            int new_list_type = isdigit(line[0]) ? 'o' : 'u';
+            if (!in_list || list_type != new_list_type) {
+                if (in_list && !ref_end_list(doc)) return 0;
+                // 列表开始标记：content 为 "u" 或 "o"
+                block = ref_create_block(REF_LIST, 2);
+                if (!block) return 0;
+                block->content[0] = (char)new_list_type;
+                block->content[1] = '\0';
+                ref_add_block(doc, block);
+                in_list = 1;
+                list_type = new_list_type;
+            }
+            block = ref_parse_list_item(line);
+            if (block) {
+                ref_add_block(doc, block);
+                continue;
+            }
+        } else if (in_list) {
+            if (!ref_end_list(doc)) return 0;
+            in_list = 0;
+            list_type = 0;
+        }
+
+        block = ref_create_block(REF_PARAGRAPH, line_len + 1);
+        if (!block) return 0;
+        strcpy(block->content, line);
+        ref_add_block(doc, block);
+    }
+
+    if (in_list && !ref_end_list(doc)) return 0;
+    return 1;
+}
+
+typedef struct {
+    char* data;
+    size_t length;
+    size_t capacity;
+} RefOutput;
+
+static int ref_emit(RefOutput* out, const char* text, size_t length) {
+    if (out->length + length + 1 > out->capacity) {
+        size_t capacity = out->capacity ? out->capacity : 4096;
+        while (capacity < out->length + length + 1) capacity *= 2;
+        char* data = realloc(out->data, capacity);
+        if (!data) return 0;
+        out->data = data;
+        out->capacity = capacity;
+    }
+    memcpy(out->data + out->length, text, length);
+    out->length += length;
+    out->data[out->length] = '\0';
+    return 1;
+}
+
+static int ref_emit_wrapped(RefOutput* out, const char* open, const char* text, const char* close) {
+    return ref_emit(out, open, strlen(open)) && ref_emit(out, text, strlen(text)) &&
+           ref_emit(out, close, strlen(close));
+}
+
+static int ref_render(const RefDocument* doc, RefOutput* out) {
+    int in_list = 0;
+    char tag[32];
+
+    for (const RefBlock* block = doc->first; block; block = block->next) {
+        int ok = 1;
+        switch (block->type) {
+            case REF_HEADING: {
+                char close[16];
+                snprintf(tag, sizeof(tag), "<h%d>", block->level);
+                snprintf(close, sizeof(close), "</h%d>\n", block->level);
+                ok = ref_emit_wrapped(out, tag, block->content, close);
+                break;
+            }
+
+            case REF_PARAGRAPH:
+                if (block->content[0]) ok = ref_emit_wrapped(out, "<p>", block->content, "</p>\n");
+                break;
+
+            case REF_LIST:
+                if (!block->content) {
+                    // 列表结束；in_list 为 0 时与原实现一样输出 "</" 加 '\0' 之前的部分
+                    snprintf(tag, sizeof(tag), "</%cl>\n", in_list);
+                    ok = ref_emit(out, tag, strlen(tag));
+                    in_list = 0;
+                } else if (block->content[0] == 'u' || block->content[0] == 'o') {
+                    in_list = block->content[0];
+                    snprintf(tag, sizeof(tag), "<%cl>\n", in_list);
+                    ok = ref_emit(out, tag, strlen(tag));
+                } else {
+                    ok = ref_emit_wrapped(out, "<li>", block->content, "</li>\n");
+                }
+                break;
+
+            case REF_CODE: {
+                const char* code = block->content + block->level + 1;
+                if (block->level > 0) {
+                    // 语言标识在第一个空白处截断，最多 31 字节
+                    char lang[32];
+                    size_t i = 0;
+                    while (i < (size_t)block->level && i < sizeof(lang) - 1 && !isspace(block->content[i])) {
+                        lang[i] = block->content[i];
+                        i++;
+                    }
+                    lang[i] = '\0';
+                    ok = ref_emit_wrapped(out, "<pre><code class=\"language-", lang, "\">") &&
+                         ref_emit_wrapped(out, "", code, "</code></pre>\n");
+                } else {
+                    ok = ref_emit_wrapped(out, "<pre><code>", code, "</code></pre>\n");
+                }
+                break;
+            }
+        }
+        if (!ok) return 0;
+    }
+
+    if (in_list) {
+        snprintf(tag, sizeof(tag), "</%cl>\n", in_list);
+        if (!ref_emit(out, tag, strlen(tag))) return 0;
+    }
+    return 1;
+}
+
+char* reference_parse_markdown(const char* markdown) {
+    RefDocument doc = {NULL, NULL};
+    RefOutput out = {NULL, 0, 0};
+    int ok = ref_parse(&doc, markdown) && ref_emit(&out, "", 0) && ref_render(&doc, &out);
+    ref_free_document(&doc);
+    if (!ok) {
+        free(out.data);
+        return NULL;
+    }
+    return out.data;
+}